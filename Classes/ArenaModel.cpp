@@ -0,0 +1,322 @@
+#include "ArenaModel.h"
+#include <algorithm>
+#include <random>
+
+namespace Snake {
+
+    namespace {
+        // bands of rows the board is cut into, at most, whatever the
+        // number of threads: more bands than workers to balance the load
+        constexpr std::size_t MAX_REGIONS = 64;
+        // snakes handed to a worker at a time in the moves phase
+        constexpr std::size_t SNAKES_PER_CHUNK = 512;
+        // draws to find two free cells side by side for a new snake
+        constexpr int SPAWN_ATTEMPTS = 64;
+        // draws over the whole board before counting the free cells
+        constexpr int REJECTION_ATTEMPTS = 16;
+    }
+
+    void ArenaModel::SnakeState::push(Cell cell) {
+        if (length == body.size()) {
+            // unroll the ring into twice the room
+            std::vector<Cell> grown(std::max<std::size_t>(4, body.size() * 2));
+            for (std::size_t i = 0; i < length; ++i) {
+                grown[i] = cellAt(i);
+            }
+            body.swap(grown);
+            tail = 0;
+        }
+        body[(tail + length) % body.size()] = cell;
+        ++length;
+    }
+
+    ArenaModel::ArenaModel(std::size_t width, std::size_t height, std::size_t snakeCount, std::size_t foodCount,
+                           std::size_t threads, std::uint64_t seed)
+    : width(width), height(height), boardSize(width * height), board(width * height, EMPTY),
+      snakes(snakeCount), foods(foodCount, NO_CELL), generator(seed), tick(0), alive(0), respawn(false),
+      pool(threads), grain(SNAKES_PER_CHUNK), moves(snakeCount),
+      claims(width * height, 0), claimTicks(width * height, 0) {
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+
+        std::size_t regionCount = std::min(height, MAX_REGIONS);
+        rowsPerRegion = (height + regionCount - 1) / regionCount;
+        regionCount = (height + rowsPerRegion - 1) / rowsPerRegion;
+        regions.resize(regionCount);
+        for (std::size_t r = 0; r < regionCount; ++r) {
+            Region &region = regions[r];
+            region.begin = static_cast<Cell>(r * rowsPerRegion * width);
+            region.end = static_cast<Cell>(std::min(height, (r + 1) * rowsPerRegion) * width);
+            region.freeCount = region.end - region.begin;
+        }
+        std::size_t chunks = (snakeCount + grain - 1) / grain;
+        heads.resize(chunks * regionCount);
+        tails.resize(chunks * regionCount);
+
+        for (std::size_t i = 0; i < snakeCount; ++i) {
+            spawn(i);
+        }
+        for (std::size_t i = 0; i < foodCount; ++i) {
+            putFood(i);
+        }
+    }
+
+    std::size_t ArenaModel::step(const Util::Direction *commands) {
+        pool.parallelFor(snakes.size(), grain, [this, commands](std::size_t begin, std::size_t end) {
+            moveSnakes(begin / grain, begin, end, commands);
+        });
+        pool.parallelFor(regions.size(), 1, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t r = begin; r < end; ++r) {
+                resolveHeads(r);
+            }
+        });
+        pool.parallelFor(regions.size(), 1, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t r = begin; r < end; ++r) {
+                applyMoves(r);
+            }
+        });
+        merge();
+        return alive;
+    }
+
+    /************************ Tick *********************/
+
+    void ArenaModel::moveSnakes(std::size_t chunk, std::size_t begin, std::size_t end,
+                                const Util::Direction *commands) {
+        std::vector<std::uint32_t> *chunkHeads = heads.data() + chunk * regions.size();
+        std::vector<std::uint32_t> *chunkTails = tails.data() + chunk * regions.size();
+        for (std::size_t r = 0; r < regions.size(); ++r) {
+            chunkHeads[r].clear();
+            chunkTails[r].clear();
+        }
+
+        for (std::size_t i = begin; i < end; ++i) {
+            SnakeState &snake = snakes[i];
+            Move &move = moves[i];
+            move.dead = !snake.alive;
+            if (move.dead) {
+                continue;
+            }
+
+            Util::Direction command = commands[i];
+            // UP <-> DOWN, LEFT <-> RIGHT are discarded
+            if (Util::Direction::UNDEFINED != command && command % 2 != snake.direction % 2) {
+                snake.direction = command;
+            }
+            Cell head = snake.cellAt(snake.length - 1);
+            std::size_t x = head % width;
+            std::size_t y = head / width;
+            move.target = NO_CELL;
+            switch (snake.direction) {
+                case Util::Direction::LEFT:
+                    if (x > 0) move.target = head - 1;
+                    break;
+                case Util::Direction::RIGHT:
+                    if (x + 1 < width) move.target = head + 1;
+                    break;
+                case Util::Direction::UP:
+                    if (y + 1 < height) move.target = static_cast<Cell>(head + width);
+                    break;
+                case Util::Direction::DOWN:
+                    if (y > 0) move.target = static_cast<Cell>(head - width);
+                    break;
+                default:
+                    break;
+            }
+            move.tail = snake.cellAt(0);
+            move.eating = NO_CELL != move.target && 0 != (board[move.target] & FOOD);
+            if (NO_CELL == move.target) {
+                move.dead = true;
+            } else {
+                chunkHeads[regionOf(move.target)].push_back(static_cast<std::uint32_t>(i));
+            }
+            if (!move.eating) {
+                chunkTails[regionOf(move.tail)].push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+
+    void ArenaModel::resolveHeads(std::size_t region) {
+        const std::size_t regionCount = regions.size();
+        const std::uint64_t stamp = tick + 1;
+        for (std::size_t chunk = region; chunk < heads.size(); chunk += regionCount) {
+            for (std::uint32_t i : heads[chunk]) {
+                Cell target = moves[i].target;
+                if (claimTicks[target] != stamp) {
+                    claimTicks[target] = stamp;
+                    claims[target] = 0;
+                }
+                ++claims[target];
+            }
+        }
+
+        for (std::size_t chunk = region; chunk < heads.size(); chunk += regionCount) {
+            for (std::uint32_t i : heads[chunk]) {
+                Move &move = moves[i];
+                Cell value = board[move.target];
+                bool blocked = claims[move.target] > 1;
+                if (!blocked && isSnake(value)) {
+                    // only a tail moving on leaves its cell
+                    const Move &owner = moves[value - 1];
+                    blocked = move.target != owner.tail || owner.eating;
+                }
+                move.dead = blocked;
+            }
+        }
+    }
+
+    void ArenaModel::applyMoves(std::size_t region) {
+        const std::size_t regionCount = regions.size();
+        Region &area = regions[region];
+        area.eaten.clear();
+        // tails first, a head may take the cell a tail just left
+        for (std::size_t chunk = region; chunk < tails.size(); chunk += regionCount) {
+            for (std::uint32_t i : tails[chunk]) {
+                if (!moves[i].dead) {
+                    release(moves[i].tail);
+                }
+            }
+        }
+        for (std::size_t chunk = region; chunk < heads.size(); chunk += regionCount) {
+            for (std::uint32_t i : heads[chunk]) {
+                const Move &move = moves[i];
+                if (move.dead) {
+                    continue;
+                }
+                SnakeState &snake = snakes[i];
+                if (move.eating) {
+                    area.eaten.push_back(board[move.target] & ~FOOD);
+                    ++snake.foodEaten;
+                } else {
+                    snake.pop();
+                }
+                snake.push(move.target);
+                occupy(move.target, static_cast<Cell>(i + 1));
+            }
+        }
+    }
+
+    void ArenaModel::merge() {
+        for (std::size_t i = 0; i < snakes.size(); ++i) {
+            if (snakes[i].alive && moves[i].dead) {
+                removeSnake(i);
+            }
+        }
+        for (const Region &region : regions) {
+            for (std::size_t food : region.eaten) {
+                foods[food] = NO_CELL;
+                putFood(food);
+            }
+        }
+        // foods that found no room before
+        for (std::size_t food = 0; food < foods.size(); ++food) {
+            if (NO_CELL == foods[food]) {
+                putFood(food);
+            }
+        }
+        if (respawn) {
+            for (std::size_t i = 0; i < snakes.size(); ++i) {
+                if (!snakes[i].alive) {
+                    spawn(i);
+                }
+            }
+        }
+        ++tick;
+    }
+
+    /************************ Board *********************/
+
+    void ArenaModel::occupy(Cell cell, Cell value) {
+        if (EMPTY == board[cell]) {
+            --regions[regionOf(cell)].freeCount;
+        }
+        board[cell] = value;
+    }
+
+    void ArenaModel::release(Cell cell) {
+        if (EMPTY != board[cell]) {
+            ++regions[regionOf(cell)].freeCount;
+        }
+        board[cell] = EMPTY;
+    }
+
+    ArenaModel::Cell ArenaModel::sampleFree() {
+        std::uniform_int_distribution<Cell> anywhere(0, static_cast<Cell>(boardSize - 1));
+        for (int attempt = 0; attempt < REJECTION_ATTEMPTS; ++attempt) {
+            Cell cell = anywhere(generator);
+            if (EMPTY == board[cell]) {
+                return cell;
+            }
+        }
+
+        std::size_t total = 0;
+        for (const Region &region : regions) {
+            total += region.freeCount;
+        }
+        if (0 == total) {
+            return NO_CELL;
+        }
+        std::size_t index = std::uniform_int_distribution<std::size_t>(0, total - 1)(generator);
+        for (const Region &region : regions) {
+            if (index >= region.freeCount) {
+                index -= region.freeCount;
+                continue;
+            }
+            for (Cell cell = region.begin; cell < region.end; ++cell) {
+                if (EMPTY == board[cell] && 0 == index--) {
+                    return cell;
+                }
+            }
+        }
+        return NO_CELL;
+    }
+
+    bool ArenaModel::spawn(std::size_t index) {
+        for (int attempt = 0; attempt < SPAWN_ATTEMPTS; ++attempt) {
+            Cell head = sampleFree();
+            if (NO_CELL == head) {
+                return false;
+            }
+            if (0 == head % width || EMPTY != board[head - 1]) {
+                continue;
+            }
+            SnakeState &snake = snakes[index];
+            snake.tail = 0;
+            snake.length = 0;
+            snake.push(head - 1);
+            snake.push(head);
+            snake.direction = Util::Direction::RIGHT;
+            snake.alive = true;
+            occupy(head - 1, static_cast<Cell>(index + 1));
+            occupy(head, static_cast<Cell>(index + 1));
+            ++alive;
+            return true;
+        }
+        return false;
+    }
+
+    void ArenaModel::putFood(std::size_t index) {
+        Cell cell = sampleFree();
+        foods[index] = cell;
+        if (NO_CELL != cell) {
+            occupy(cell, FOOD | static_cast<Cell>(index));
+        }
+    }
+
+    void ArenaModel::removeSnake(std::size_t index) {
+        SnakeState &snake = snakes[index];
+        for (std::size_t i = 0; i < snake.length; ++i) {
+            Cell cell = snake.cellAt(i);
+            // a head of this tick may be on the tail already
+            if (board[cell] == index + 1) {
+                release(cell);
+            }
+        }
+        snake.length = 0;
+        snake.alive = false;
+        ++snake.deaths;
+        --alive;
+    }
+
+} // end namespace Snake
@@ -0,0 +1,169 @@
+#ifndef ArenaModel_h
+#define ArenaModel_h
+
+#include <cstdint>
+#include <vector>
+#include "Random.h"
+#include "Util.h"
+#include "WorkerPool.h"
+
+namespace Snake {
+
+    /* Many snakes and foods on one shared board.
+     *
+     * Every tick moves all the snakes at once, against the board as it is
+     * once every snake moved: a head dies off the board, on a body cell
+     * (a tail moving on is free), or on the same cell as another head,
+     * food included. Dead snakes are removed, eaten foods put again.
+     * A snake starts as in Model: a head with one body cell on its left,
+     * heading RIGHT, reversed commands are discarded.
+     *
+     * A tick runs on a WorkerPool in three phases:
+     *   moves     each snake alone: its target cell, food, tail, in chunks
+     *   regions   the board is cut in bands of rows, each band on a worker
+     *             resolves the heads and applies the tails / heads of its
+     *             own cells, so no two workers write the same cell
+     *   merge     one thread: dead snakes, new foods, respawns, in order
+     * Chunks and bands only depend on the sizes, so the same seed and the
+     * same commands give the same arena for any number of threads. */
+    class ArenaModel {
+    public:
+        using Cell = std::uint32_t;
+
+        static constexpr std::size_t NO_SNAKE = ~std::size_t(0);
+
+        /**********************************************************************
+         * snakes snakes and foods foods on a width * height board, 2*2 at    *
+         * least. Snakes go where they fit, in order, some may not be placed  *
+         * on a crowded board and start dead                                  *
+         * threads = 0 means one worker per hardware thread                   *
+         **********************************************************************/
+        ArenaModel(std::size_t width, std::size_t height, std::size_t snakes, std::size_t foods,
+                   std::size_t threads = 0, std::uint64_t seed = 0);
+
+        /* commands[k] is the command of snake #k, UNDEFINED to keep going,
+         * dead snakes ignore theirs. Return #snakes alive */
+        std::size_t step(const Util::Direction *commands);
+
+        // put dead snakes back on the board at the end of every tick
+        inline void setRespawn(bool respawn) { this->respawn = respawn; }
+
+        inline std::size_t size() const { return snakes.size(); }
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+        inline std::uint64_t getTick() const { return tick; }
+        inline std::size_t getAlive() const { return alive; }
+        inline std::size_t getRegionCount() const { return regions.size(); }
+
+        inline bool isAlive(std::size_t index) const { return snakes[index].alive; }
+        inline Util::Direction getDirection(std::size_t index) const { return snakes[index].direction; }
+        inline std::size_t getLength(std::size_t index) const { return snakes[index].length; }
+        inline std::size_t getFoodEaten(std::size_t index) const { return snakes[index].foodEaten; }
+        inline std::size_t getDeaths(std::size_t index) const { return snakes[index].deaths; }
+        // alive snakes only
+        inline Cell getHeadCell(std::size_t index) const { return snakes[index].cellAt(snakes[index].length - 1); }
+
+        inline std::size_t getFoodCount() const { return foods.size(); }
+        inline Cell getFoodCell(std::size_t index) const { return foods[index]; }
+
+        // snake on cell, NO_SNAKE if none
+        inline std::size_t getSnakeAt(Cell cell) const {
+            return isSnake(board[cell]) ? board[cell] - 1 : NO_SNAKE;
+        }
+        inline bool isFood(Cell cell) const { return 0 != (board[cell] & FOOD); }
+
+        // disable
+        ArenaModel(const ArenaModel&) = delete;
+        ArenaModel operator=(const ArenaModel&) = delete;
+    private:
+        // board[cell]: EMPTY, snake index + 1, or FOOD | food index
+        static constexpr Cell EMPTY = 0;
+        static constexpr Cell FOOD = Cell(1) << 31;
+        static constexpr Cell NO_CELL = ~Cell(0);
+
+        struct SnakeState {
+            // ring buffer, body[(tail + i) % body.size()] is node #i, the
+            // head is the last one, grows by doubling
+            std::vector<Cell> body;
+            std::size_t tail = 0;
+            std::size_t length = 0;
+            Util::Direction direction = Util::Direction::RIGHT;
+            std::size_t foodEaten = 0;
+            std::size_t deaths = 0;
+            bool alive = false;
+
+            inline Cell cellAt(std::size_t index) const { return body[(tail + index) % body.size()]; }
+            void push(Cell cell);
+            inline void pop() { tail = (tail + 1) % body.size(); --length; }
+        };
+
+        // the move of one snake in the current tick
+        struct Move {
+            Cell target;
+            Cell tail;
+            bool eating;
+            bool dead;
+        };
+
+        // band of rows, cells [begin, end)
+        struct Region {
+            Cell begin;
+            Cell end;
+            // #cells of the band neither snake nor food
+            std::size_t freeCount;
+            // foods eaten in the band this tick
+            std::vector<std::size_t> eaten;
+        };
+
+        std::size_t width;
+        std::size_t height;
+        std::size_t boardSize;
+        std::vector<Cell> board;
+        std::vector<SnakeState> snakes;
+        std::vector<Cell> foods;
+        std::vector<Region> regions;
+        std::size_t rowsPerRegion;
+        Util::Random generator;
+        std::uint64_t tick;
+        std::size_t alive;
+        bool respawn;
+
+        /************************ Tick *********************/
+
+        Util::WorkerPool pool;
+        // snakes per chunk of the moves phase
+        std::size_t grain;
+        std::vector<Move> moves;
+        // heads[chunk * regions + region]: snakes of the chunk heading to
+        // a cell of the region, tails[]: snakes of the chunk leaving one
+        std::vector<std::vector<std::uint32_t>> heads;
+        std::vector<std::vector<std::uint32_t>> tails;
+        // #heads on a cell this tick, valid if claimTicks[cell] == tick + 1
+        std::vector<std::uint32_t> claims;
+        std::vector<std::uint64_t> claimTicks;
+
+        static inline bool isSnake(Cell value) { return EMPTY != value && 0 == (value & FOOD); }
+        inline std::size_t regionOf(Cell cell) const { return cell / width / rowsPerRegion; }
+
+        void moveSnakes(std::size_t chunk, std::size_t begin, std::size_t end, const Util::Direction *commands);
+        void resolveHeads(std::size_t region);
+        void applyMoves(std::size_t region);
+        void merge();
+
+        /************************ Board *********************/
+
+        void occupy(Cell cell, Cell value);
+        void release(Cell cell);
+        /* a free cell drawn uniformly, NO_CELL if none. A few draws over the
+         * whole board first, the arena is mostly empty, then one draw among
+         * the free cells counted per region, found by scanning that region */
+        Cell sampleFree();
+        // put snake #index on the board, return false if no place was found
+        bool spawn(std::size_t index);
+        void putFood(std::size_t index);
+        void removeSnake(std::size_t index);
+    };
+
+} // end namespace Snake
+
+#endif /* ArenaModel_h */
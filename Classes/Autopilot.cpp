@@ -0,0 +1,367 @@
+#include "Autopilot.h"
+#include <algorithm>
+
+namespace Snake {
+
+    Autopilot::Autopilot(std::size_t width, std::size_t height)
+    : width(width), height(height), boardSize(width * height),
+      occupied(width, height), body(width * height), tail(0), length(0), food(NO_CELL),
+      distances(width * height, UNREACHABLE), distancesFood(NO_CELL), lastDistance(UNREACHABLE),
+      flood(occupied.wordCount()), search(occupied.wordCount()), searchDistance(0), searchDone(false),
+      cellsVisited(0) {
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+    }
+
+    void Autopilot::reset() {
+        occupied.clear();
+        tail = 0;
+        length = 0;
+        food = NO_CELL;
+        distancesFood = NO_CELL;
+        lastDistance = UNREACHABLE;
+        search.clear();
+    }
+
+    void Autopilot::apply(Util::DeltaView delta) {
+        for (const Util::CellChange &change : delta) {
+            switch (change.to) {
+                case Util::NodeType::HEAD:
+                    body[(tail + length) % boardSize] = change.cell;
+                    ++length;
+                    occupied.set(change.cell);
+                    break;
+                case Util::NodeType::BODY:
+                    // a new node, otherwise the old head
+                    if (Util::NodeType::UNINIT == change.from) {
+                        body[(tail + length) % boardSize] = change.cell;
+                        ++length;
+                        occupied.set(change.cell);
+                    }
+                    break;
+                case Util::NodeType::FOOD:
+                    food = change.cell;
+                    break;
+                default:
+                    // the tail moving on
+                    occupied.reset(body[tail]);
+                    tail = (tail + 1) % boardSize;
+                    --length;
+                    break;
+            }
+        }
+    }
+
+    bool Autopilot::neighbour(Cell cell, Util::Direction heading, Cell &result) const {
+        std::size_t x = cell % width;
+        std::size_t y = cell / width;
+        switch (heading) {
+            case Util::Direction::LEFT:
+                if (0 == x) return false;
+                result = cell - 1;
+                return true;
+            case Util::Direction::RIGHT:
+                if (width - 1 == x) return false;
+                result = cell + 1;
+                return true;
+            case Util::Direction::UP:
+                if (height - 1 == y) return false;
+                result = static_cast<Cell>(cell + width);
+                return true;
+            case Util::Direction::DOWN:
+                if (0 == y) return false;
+                result = static_cast<Cell>(cell - width);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    Util::Direction Autopilot::decide(Util::Direction direction) {
+        struct Option {
+            Util::Direction heading;
+            Cell cell;
+            bool eating;
+            std::uint32_t distance;
+            std::size_t room;
+            bool safe;
+        };
+        if (0 == length) {
+            return direction;
+        }
+
+        Cell head = getHeadCell();
+        Cell tailCell = body[tail];
+        Option options[4];
+        std::size_t count = 0;
+        for (int i = 0; i < 4; ++i) {
+            Util::Direction heading = static_cast<Util::Direction>(i);
+            Cell cell;
+            // turning back is discarded by the model
+            if (heading != direction && 0 == ((heading ^ direction) & 1)) {
+                continue;
+            }
+            if (!neighbour(head, heading, cell)) {
+                continue;
+            }
+            bool eating = cell == food;
+            // the tail moves on unless the snake grows
+            if (occupied.test(cell) && (cell != tailCell || eating)) {
+                continue;
+            }
+            options[count++] = { heading, cell, eating, UNREACHABLE, 0, false };
+        }
+        if (0 == count) {
+            return direction;
+        }
+
+        bool anySafe = false;
+        for (std::size_t i = 0; i < count; ++i) {
+            options[i].room = floodFrom(options[i].cell, options[i].eating, options[i].safe);
+            anySafe = anySafe || options[i].safe;
+        }
+
+        bool ready = false;
+        if (NO_CELL != food) {
+            Cell cells[4];
+            for (std::size_t i = 0; i < count; ++i) {
+                cells[i] = options[i].cell;
+            }
+            bool fresh = distancesFood != food;
+            ready = updateDistances(cells, count);
+            std::uint32_t nearest = UNREACHABLE;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (options[i].safe || !anySafe) {
+                    nearest = std::min(nearest, distances[options[i].cell]);
+                }
+            }
+            // the way was blocked by the snake since: no move gets closer
+            if (ready && !fresh && (UNREACHABLE == nearest || nearest >= lastDistance)) {
+                distancesFood = NO_CELL;
+                ready = updateDistances(cells, count);
+            }
+            std::size_t foodX = food % width;
+            std::size_t foodY = food / width;
+            for (std::size_t i = 0; i < count; ++i) {
+                Option &option = options[i];
+                if (option.eating) {
+                    option.distance = 0;
+                } else if (ready) {
+                    option.distance = distances[option.cell];
+                } else {
+                    std::size_t x = option.cell % width;
+                    std::size_t y = option.cell / width;
+                    option.distance = static_cast<std::uint32_t>((x > foodX ? x - foodX : foodX - x)
+                                                                 + (y > foodY ? y - foodY : foodY - y));
+                }
+            }
+        }
+
+        const Option *best = &options[0];
+        for (std::size_t i = 1; i < count; ++i) {
+            const Option &option = options[i];
+            bool better;
+            if (option.safe != best->safe) {
+                better = option.safe;
+            } else if (option.safe && option.distance != best->distance) {
+                better = option.distance < best->distance;
+            } else if (!option.safe && option.room != best->room) {
+                better = option.room > best->room;
+            } else {
+                // keep going straight rather than turning for nothing
+                better = option.heading == direction;
+            }
+            if (better) {
+                best = &option;
+            }
+        }
+        lastDistance = ready ? best->distance : UNREACHABLE;
+        return best->heading;
+    }
+
+    /************************ Waves *********************/
+
+    Autopilot::Waves::Waves(std::size_t words)
+    : frontier(words, 0), next(words, 0), visited(words, 0), stamps(words, 0), stamp(0) {
+    }
+
+    void Autopilot::Waves::seed(const Util::BitBoard &board, Cell cell) {
+        std::size_t index = board.wordOf(cell);
+        Util::BitWord bit = board.bitOf(cell);
+        frontier[index] = bit;
+        if (0 == visited[index]) {
+            touched.push_back(static_cast<std::uint32_t>(index));
+        }
+        visited[index] |= bit;
+        active.assign(1, static_cast<std::uint32_t>(index));
+    }
+
+    std::size_t Autopilot::Waves::wave(const Util::BitBoard &board, bool fillRows) {
+        const std::size_t wordsPerRow = board.getWordsPerRow();
+        const std::size_t words = board.wordCount();
+        if (0 == ++stamp) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+
+        // the words of the frontier and their 4 neighbours, once each
+        targets.clear();
+        for (std::uint32_t index : active) {
+            std::size_t column = index % wordsPerRow;
+            std::uint32_t around[5] = { index, index, index, index, index };
+            if (column > 0) around[1] = index - 1;
+            if (column + 1 < wordsPerRow) around[2] = index + 1;
+            if (index >= wordsPerRow) around[3] = static_cast<std::uint32_t>(index - wordsPerRow);
+            if (index + wordsPerRow < words) around[4] = static_cast<std::uint32_t>(index + wordsPerRow);
+            for (std::uint32_t target : around) {
+                if (stamps[target] != stamp) {
+                    stamps[target] = stamp;
+                    targets.push_back(target);
+                }
+            }
+        }
+
+        std::size_t reached = 0;
+        for (std::uint32_t index : targets) {
+            std::size_t column = index % wordsPerRow;
+            Util::BitWord word = frontier[index];
+            // 64 cells at a time: left, right, then the carries across
+            // words of the row, then the rows below and above
+            Util::BitWord grown = word | (word << 1) | (word >> 1);
+            if (column > 0) grown |= frontier[index - 1] >> 63;
+            if (column + 1 < wordsPerRow) grown |= frontier[index + 1] << 63;
+            if (index >= wordsPerRow) grown |= frontier[index - wordsPerRow];
+            if (index + wordsPerRow < words) grown |= frontier[index + wordsPerRow];
+
+            Util::BitWord open = board.boardMask(index) & ~board[index] & ~visited[index];
+            Util::BitWord found = grown & open;
+            if (fillRows && 0 != found) {
+                found = Util::fillUp(found, open) | Util::fillDown(found, open);
+            }
+            next[index] = found;
+            if (0 != found) {
+                if (0 == visited[index]) {
+                    touched.push_back(index);
+                }
+                visited[index] |= found;
+                reached += Util::popCount(found);
+            }
+        }
+
+        for (std::uint32_t index : active) {
+            frontier[index] = 0;
+        }
+        active.clear();
+        for (std::uint32_t index : targets) {
+            if (0 != next[index]) {
+                active.push_back(index);
+            }
+        }
+        // next is all clear again, the old frontier words were just cleared
+        frontier.swap(next);
+        return reached;
+    }
+
+    void Autopilot::Waves::clear() {
+        for (std::uint32_t index : active) {
+            frontier[index] = 0;
+        }
+        active.clear();
+        for (std::uint32_t index : touched) {
+            visited[index] = 0;
+        }
+        touched.clear();
+    }
+
+    /************************ Searches *********************/
+
+    bool Autopilot::updateDistances(const Cell *cells, std::size_t count) {
+        if (distancesFood != food) {
+            std::fill(distances.begin(), distances.end(), UNREACHABLE);
+            distancesFood = food;
+            search.clear();
+            search.seed(occupied, food);
+            distances[food] = 0;
+            searchDistance = 0;
+            searchDone = false;
+        }
+
+        std::size_t budget = 0;
+        for (;;) {
+            bool pending = false;
+            for (std::size_t i = 0; i < count && !pending; ++i) {
+                pending = UNREACHABLE == distances[cells[i]] && cells[i] != food;
+            }
+            if (!pending || searchDone) {
+                return true;
+            }
+            if (budget >= SEARCH_BUDGET) {
+                return false;
+            }
+
+            // the board moved on since the last waves, the distances are
+            // those of the board they were found on
+            std::size_t reached = search.wave(occupied, false);
+            budget += reached;
+            cellsVisited += reached;
+            ++searchDistance;
+            for (std::uint32_t index : search.active) {
+                for (Util::BitWord word = search.frontier[index]; 0 != word; word &= word - 1) {
+                    distances[occupied.cellOf(index, Util::countTrailingZeros(word))] = searchDistance;
+                }
+            }
+            searchDone = search.active.empty();
+        }
+    }
+
+    std::size_t Autopilot::floodFrom(Cell cell, bool eating, bool &tailReached) {
+        // the board once the head moved to cell
+        Cell tailCell = body[tail];
+        bool wasOccupied = occupied.test(cell);
+        if (!eating) {
+            occupied.reset(tailCell);
+        }
+        occupied.set(cell);
+
+        // a free tail is reached by the fill, a growing one is next to it
+        Cell targets[4];
+        std::size_t targetCount = 0;
+        if (eating) {
+            for (int i = 0; i < 4; ++i) {
+                if (neighbour(tailCell, static_cast<Util::Direction>(i), targets[targetCount])) {
+                    ++targetCount;
+                }
+            }
+        } else {
+            targets[targetCount++] = tailCell;
+        }
+        auto reachedTail = [&]() {
+            for (std::size_t i = 0; i < targetCount; ++i) {
+                if (flood.reached(occupied, targets[i])) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        flood.seed(occupied, cell);
+        std::size_t room = 0;
+        tailReached = reachedTail();
+        while (!tailReached && !flood.active.empty()) {
+            room += flood.wave(occupied, true);
+            tailReached = reachedTail();
+        }
+        flood.clear();
+        cellsVisited += room;
+
+        if (!eating) {
+            occupied.set(tailCell);
+        }
+        if (!wasOccupied) {
+            occupied.reset(cell);
+        }
+        return room;
+    }
+
+} // end namespace Snake
@@ -0,0 +1,135 @@
+#ifndef Autopilot_h
+#define Autopilot_h
+
+#include <cstdint>
+#include <vector>
+#include "BitBoard.h"
+#include "Delta.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* Computer player, works with any model through its deltas.
+     *
+     * Each move goes to the neighbour closest to the food by BFS distance,
+     * among the neighbours from which the head still reaches the tail
+     * (flood fill): following its own tail, the snake can never be walled
+     * in. If no neighbour is safe, it takes the one with the most room.
+     *
+     * BFS and flood fill run on a BitBoard: a wave grows every word of the
+     * frontier at once (shift by one, rows above and below), only the words
+     * around the last wave are visited, and a flood also fills along rows
+     * within a word (fillUp / fillDown), so open areas take few waves.
+     * The distance field of the food only spans the cells up to the head,
+     * and is kept until the food moves or the way it gives is blocked: the
+     * body only ever follows that way, so it stays valid in between and
+     * most steps cost the flood fills only. Growing it is spread over the
+     * steps (SEARCH_BUDGET), the Manhattan distance stands in meanwhile.
+     *
+     *     Autopilot pilot(width, height);
+     *     pilot.apply(model.getDelta());
+     *     while (NORMAL == status) {
+     *         status = model.update(pilot.decide(model.getDirection()));
+     *         pilot.apply(model.getDelta());
+     *     } */
+    class Autopilot {
+    public:
+        using Cell = std::uint32_t;
+
+        Autopilot(std::size_t width, std::size_t height);
+
+        // follow the model, call with the delta of every update and the
+        // one after construction
+        void apply(Util::DeltaView delta);
+        // forget the board, call before applying the delta of a restore
+        void reset();
+
+        // command for the next step of a snake heading to direction
+        Util::Direction decide(Util::Direction direction);
+
+        inline std::size_t getLength() const { return length; }
+        inline Cell getHeadCell() const { return body[(tail + length - 1) % boardSize]; }
+        inline Cell getFoodCell() const { return food; }
+        // cells reached by the BFS and flood fills so far, for profiling
+        inline std::uint64_t getCellsVisited() const { return cellsVisited; }
+
+        // disable
+        Autopilot(const Autopilot&) = delete;
+        Autopilot operator=(const Autopilot&) = delete;
+    private:
+        static constexpr std::uint32_t UNREACHABLE = ~std::uint32_t(0);
+        static constexpr Cell NO_CELL = ~Cell(0);
+        // cells the distance BFS may reach per decide(), it goes on at the
+        // next one, so a new food far away does not stall one step
+        static constexpr std::size_t SEARCH_BUDGET = 1 << 16;
+
+        std::size_t width;
+        std::size_t height;
+        std::size_t boardSize;
+
+        // board as known from the deltas
+        Util::BitBoard occupied;
+        // snake body, ring buffer, body[tail] is the tail
+        std::vector<Cell> body;
+        std::size_t tail;
+        std::size_t length;
+        Cell food;
+
+        // BFS distance to food of every cell, UNREACHABLE if none (yet)
+        std::vector<std::uint32_t> distances;
+        // food the distances lead to, NO_CELL if they are stale
+        Cell distancesFood;
+        // distance of the last move, UNREACHABLE if not from the BFS
+        std::uint32_t lastDistance;
+
+        /************************ Waves *********************/
+
+        // frontier of a BFS or flood fill over the free cells of the board
+        struct Waves {
+            // last wave, next wave, everything reached, one word per board word
+            std::vector<Util::BitWord> frontier;
+            std::vector<Util::BitWord> next;
+            std::vector<Util::BitWord> visited;
+            // words of frontier set, words to compute in the next wave
+            std::vector<std::uint32_t> active;
+            std::vector<std::uint32_t> targets;
+            // words of visited set, to clear them afterwards
+            std::vector<std::uint32_t> touched;
+            // targets[] dedup, stamp of the wave that added the word
+            std::vector<std::uint32_t> stamps;
+            std::uint32_t stamp;
+
+            explicit Waves(std::size_t words);
+            // start from a single cell
+            void seed(const Util::BitBoard &board, Cell cell);
+            // grow the frontier by one wave through the cells clear on board,
+            // fill along rows if fillRows, return #cells reached
+            std::size_t wave(const Util::BitBoard &board, bool fillRows);
+            // clear frontier and visited
+            void clear();
+            inline bool reached(const Util::BitBoard &board, Cell cell) const {
+                return 0 != (visited[board.wordOf(cell)] & board.bitOf(cell));
+            }
+        };
+        Waves flood;
+        Waves search;
+        // wave the distance BFS is at, 0 if not started
+        std::uint32_t searchDistance;
+        // the distance BFS ran out of cells
+        bool searchDone;
+        std::uint64_t cellsVisited;
+
+        // cell one step from cell towards heading, false if off the board
+        bool neighbour(Cell cell, Util::Direction heading, Cell &result) const;
+
+        // BFS from the food, resumes where the last call stopped, return
+        // true once all of cells are reached or nothing is left to reach
+        bool updateDistances(const Cell *cells, std::size_t count);
+        // cells reachable from cell once the head moved there, the fill
+        // stops early once the tail is reached
+        std::size_t floodFrom(Cell cell, bool eating, bool &tailReached);
+    };
+
+} // end namespace Snake
+
+#endif /* Autopilot_h */
@@ -0,0 +1,110 @@
+#include "BatchSimulator.h"
+#include <chrono>
+
+namespace Snake {
+
+    namespace {
+        // a few chunks per worker, so that stealing has something to balance
+        constexpr std::size_t CHUNKS_PER_WORKER = 8;
+
+        using Clock = std::chrono::steady_clock;
+
+        inline double elapsed(Clock::time_point since) {
+            return std::chrono::duration<double>(Clock::now() - since).count();
+        }
+    }
+
+    BatchSimulator::BatchSimulator(std::size_t count, std::size_t width, std::size_t height,
+                                   std::size_t threads, std::uint64_t seed)
+    : pool(threads), seconds(0) {
+        games.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Game &game = games[i];
+            game.model.reset(new GridModel(width, height, seed + i));
+            game.status = GameStatus::NORMAL;
+            game.steps = 0;
+        }
+        std::size_t chunks = pool.size() * CHUNKS_PER_WORKER;
+        grain = count / chunks + 1;
+    }
+
+    void BatchSimulator::setPolicy(const Policy &policy) {
+        for (Game &game : games) {
+            game.policy = policy;
+        }
+    }
+
+    void BatchSimulator::setPolicy(std::size_t index, const Policy &policy) {
+        games[index].policy = policy;
+    }
+
+    std::size_t BatchSimulator::step() {
+        Clock::time_point start = Clock::now();
+        pool.parallelFor(games.size(), grain, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                stepGame(i);
+            }
+        });
+        seconds += elapsed(start);
+        return countRunning();
+    }
+
+    std::size_t BatchSimulator::run(std::size_t maxSteps) {
+        Clock::time_point start = Clock::now();
+        pool.parallelFor(games.size(), grain, [this, maxSteps](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                while (games[i].steps < maxSteps && stepGame(i)) {}
+            }
+        });
+        seconds += elapsed(start);
+        return countRunning();
+    }
+
+    bool BatchSimulator::stepGame(std::size_t index) {
+        Game &game = games[index];
+        if (GameStatus::NORMAL != game.status) {
+            return false;
+        }
+        Util::Direction command = game.policy ? game.policy(index, *game.model) : Util::Direction::UNDEFINED;
+        game.status = game.model->update(command);
+        ++game.steps;
+        return GameStatus::NORMAL == game.status;
+    }
+
+    std::size_t BatchSimulator::countRunning() const {
+        std::size_t running = 0;
+        for (const Game &game : games) {
+            if (GameStatus::NORMAL == game.status) {
+                ++running;
+            }
+        }
+        return running;
+    }
+
+    BatchSimulator::Statistics BatchSimulator::getStatistics() const {
+        Statistics statistics;
+        statistics.games = games.size();
+        statistics.seconds = seconds;
+        for (const Game &game : games) {
+            switch (game.status) {
+                case GameStatus::WIN:
+                    ++statistics.wins;
+                    break;
+                case GameStatus::LOSE:
+                    ++statistics.loses;
+                    break;
+                default:
+                    ++statistics.running;
+                    break;
+            }
+            statistics.steps += game.steps;
+            std::size_t food = game.model->getFoodEaten();
+            if (statistics.food.size() <= food) {
+                statistics.food.resize(food + 1, 0);
+            }
+            ++statistics.food[food];
+        }
+        return statistics;
+    }
+
+} // end namespace Snake
@@ -0,0 +1,91 @@
+#ifndef BatchSimulator_h
+#define BatchSimulator_h
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "GridModel.h"
+#include "WorkerPool.h"
+
+namespace Snake {
+
+    /* Headless runner of many independent games.
+     * No cocos2d dependency: every game is a GridModel driven by a
+     * policy callback, and the games are spread over a WorkerPool. */
+    class BatchSimulator {
+    public:
+
+        using GameStatus = GridModel::GameStatus;
+        // decide the next command of game #index, called once per step
+        // from any worker thread, never twice at a time for the same game
+        using Policy = std::function<Util::Direction(std::size_t index, const GridModel &model)>;
+
+        // aggregate statistics over all the games
+        struct Statistics {
+            std::size_t games = 0;
+            std::size_t running = 0;
+            std::size_t wins = 0;
+            std::size_t loses = 0;
+            // game-steps done by all the games
+            std::size_t steps = 0;
+            // wall time spent in step() / run()
+            double seconds = 0;
+            // food[n] = #games having eaten n food
+            std::vector<std::size_t> food;
+
+            inline double stepsPerSecond() const { return seconds > 0 ? steps / seconds : 0; }
+        };
+
+        /**********************************************************************
+         * games of width * height boards, threads = 0 means one worker per   *
+         * hardware thread. Game #index is seeded with seed + index, so a     *
+         * batch is reproducible. Every game starts with no policy, i.e. the  *
+         * snake keeps going straight                                         *
+         **********************************************************************/
+        BatchSimulator(std::size_t games, std::size_t width, std::size_t height,
+                       std::size_t threads = 0, std::uint64_t seed = 0);
+
+        void setPolicy(const Policy &policy);
+        void setPolicy(std::size_t index, const Policy &policy);
+
+        // advance every running game by one step, lock-step across games
+        // return #games still running
+        std::size_t step();
+        // advance every running game until it ends or has done maxSteps
+        // steps in total, games do not wait for each other
+        // return #games still running
+        std::size_t run(std::size_t maxSteps);
+
+        Statistics getStatistics() const;
+
+        inline std::size_t size() const { return games.size(); }
+        inline const GridModel& getModel(std::size_t index) const { return *games[index].model; }
+        inline GameStatus getStatus(std::size_t index) const { return games[index].status; }
+        inline std::size_t getSteps(std::size_t index) const { return games[index].steps; }
+
+        // disable
+        BatchSimulator(const BatchSimulator&) = delete;
+        BatchSimulator operator=(const BatchSimulator&) = delete;
+    private:
+        struct Game {
+            std::unique_ptr<GridModel> model;
+            Policy policy;
+            GameStatus status;
+            std::size_t steps;
+        };
+
+        std::vector<Game> games;
+        Util::WorkerPool pool;
+        // games handed to a worker at a time
+        std::size_t grain;
+        double seconds;
+
+        // one step of game #index, return false if it is over
+        bool stepGame(std::size_t index);
+        std::size_t countRunning() const;
+    };
+
+} // end namespace Snake
+
+#endif /* BatchSimulator_h */
@@ -0,0 +1,206 @@
+#ifndef BitBoard_h
+#define BitBoard_h
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace Util {
+
+    using BitWord = std::uint64_t;
+
+    inline unsigned popCount(BitWord word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<unsigned>((word * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // index of the lowest bit set, word != 0
+    inline unsigned countTrailingZeros(BitWord word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        return popCount((word & (0 - word)) - 1);
+#endif
+    }
+
+    // index of the set bit of rank #rank in word (from the lowest), rank < popCount(word)
+    inline unsigned selectBit(BitWord word, unsigned rank) noexcept {
+        unsigned base = 0;
+        for (unsigned half = 32; half >= 8; half /= 2) {
+            unsigned low = popCount(word & ((BitWord(1) << half) - 1));
+            if (rank >= low) {
+                rank -= low;
+                word >>= half;
+                base += half;
+            }
+        }
+        for (; rank > 0; --rank) {
+            word &= word - 1;
+        }
+        return base + countTrailingZeros(word);
+    }
+
+    /* Clear bits of a bitmap counted per word in a Fenwick tree, so that the
+     * clear bit of a given rank is found in O(log words), and a bit set or
+     * reset costs as much to account for. tree has wordCount + 1 entries,
+     * tree[0] is unused. size is the number of bits, the padding bits past
+     * it in the last word are not counted */
+    inline void buildClearCounts(std::uint32_t *tree, const BitWord *words, std::size_t wordCount,
+                                 std::size_t size) noexcept {
+        tree[0] = 0;
+        for (std::size_t index = 0; index < wordCount; ++index) {
+            std::size_t used = size - index * 64;
+            BitWord mask = used >= 64 ? ~BitWord(0) : (BitWord(1) << used) - 1;
+            tree[index + 1] = popCount(~words[index] & mask);
+        }
+        for (std::size_t i = 1; i <= wordCount; ++i) {
+            std::size_t parent = i + (i & (0 - i));
+            if (parent <= wordCount) {
+                tree[parent] += tree[i];
+            }
+        }
+    }
+    // word #index lost (-1) or got (+1) a clear bit
+    inline void addClearCount(std::uint32_t *tree, std::size_t wordCount, std::size_t index, int delta) noexcept {
+        for (std::size_t i = index + 1; i <= wordCount; i += i & (0 - i)) {
+            tree[i] += static_cast<std::uint32_t>(delta);
+        }
+    }
+
+    /* A clear bit of words, packed as Util::Bitmap, picked uniformly in one
+     * draw whatever the occupancy: a rank among the clear bits, located by
+     * descending the tree of buildClearCounts(), then inside its word.
+     * clear is the number of clear bits, which should not be 0. The pick
+     * only depends on the bits and the engine */
+    template <typename Engine>
+    std::size_t sampleClearBit(const BitWord *words, const std::uint32_t *tree, std::size_t wordCount,
+                               std::size_t clear, Engine &generator) {
+        std::uniform_int_distribution<std::size_t> anyClear(0, clear - 1);
+        std::size_t rank = anyClear(generator);
+        std::size_t step = 1;
+        while (2 * step <= wordCount) {
+            step *= 2;
+        }
+        std::size_t index = 0;
+        for (; step > 0; step /= 2) {
+            if (index + step <= wordCount && tree[index + step] <= rank) {
+                index += step;
+                rank -= tree[index];
+            }
+        }
+        // the padding bits are above the clear bits of the board, rank stops before them
+        return index * 64 + selectBit(~words[index], static_cast<unsigned>(rank));
+    }
+
+    /* Spread seeds through the runs of mask they sit in, towards the
+     * higher / lower bits, in 6 shift-and-mask rounds whatever the run
+     * length (occluded fill). seeds should be inside mask */
+    inline BitWord fillUp(BitWord seeds, BitWord mask) noexcept {
+        seeds |= mask & (seeds << 1);
+        mask &= mask << 1;
+        seeds |= mask & (seeds << 2);
+        mask &= mask << 2;
+        seeds |= mask & (seeds << 4);
+        mask &= mask << 4;
+        seeds |= mask & (seeds << 8);
+        mask &= mask << 8;
+        seeds |= mask & (seeds << 16);
+        mask &= mask << 16;
+        return seeds | (mask & (seeds << 32));
+    }
+    inline BitWord fillDown(BitWord seeds, BitWord mask) noexcept {
+        seeds |= mask & (seeds >> 1);
+        mask &= mask >> 1;
+        seeds |= mask & (seeds >> 2);
+        mask &= mask >> 2;
+        seeds |= mask & (seeds >> 4);
+        mask &= mask >> 4;
+        seeds |= mask & (seeds >> 8);
+        mask &= mask >> 8;
+        seeds |= mask & (seeds >> 16);
+        mask &= mask >> 16;
+        return seeds | (mask & (seeds >> 32));
+    }
+
+    /* One bit per cell, each row of the board starts on a new word, so
+     * cell (x, y) is bit x % 64 of word y * wordsPerRow + x / 64.
+     * The 4 neighbours of a whole word of cells are then a shift by one
+     * (left / right, plus one bit carried from the next word) and the
+     * words one row above and below. Padding bits past width are never
+     * set by set(), fills should mask them out with boardMask() */
+    class BitBoard {
+    public:
+        explicit BitBoard(std::size_t width = 0, std::size_t height = 0) { resize(width, height); }
+
+        void resize(std::size_t width, std::size_t height) {
+            this->width = width;
+            this->height = height;
+            wordsPerRow = (width + 63) / 64;
+            words.assign(wordsPerRow * height, 0);
+        }
+
+        inline std::size_t getWidth() const noexcept { return width; }
+        inline std::size_t getHeight() const noexcept { return height; }
+        inline std::size_t getWordsPerRow() const noexcept { return wordsPerRow; }
+        inline std::size_t wordCount() const noexcept { return words.size(); }
+
+        // cell = y * width + x, as everywhere else
+        inline std::size_t wordOf(std::size_t cell) const noexcept {
+            return (cell / width) * wordsPerRow + (cell % width) / 64;
+        }
+        inline BitWord bitOf(std::size_t cell) const noexcept { return BitWord(1) << (cell % width % 64); }
+        // cell of bit #bit of word #index
+        inline std::size_t cellOf(std::size_t index, unsigned bit) const noexcept {
+            return (index / wordsPerRow) * width + (index % wordsPerRow) * 64 + bit;
+        }
+
+        inline bool test(std::size_t cell) const noexcept { return 0 != (words[wordOf(cell)] & bitOf(cell)); }
+        inline void set(std::size_t cell) noexcept { words[wordOf(cell)] |= bitOf(cell); }
+        inline void reset(std::size_t cell) noexcept { words[wordOf(cell)] &= ~bitOf(cell); }
+
+        inline void clear() noexcept {
+            for (BitWord &word : words) {
+                word = 0;
+            }
+        }
+        // every cell of the board set, padding left clear
+        void fill() noexcept {
+            for (std::size_t index = 0; index < words.size(); ++index) {
+                words[index] = boardMask(index);
+            }
+        }
+        std::size_t count() const noexcept {
+            std::size_t total = 0;
+            for (BitWord word : words) {
+                total += popCount(word);
+            }
+            return total;
+        }
+
+        // bits of word #index that are cells of the board
+        inline BitWord boardMask(std::size_t index) const noexcept {
+            std::size_t used = width - (index % wordsPerRow) * 64;
+            return used >= 64 ? ~BitWord(0) : (BitWord(1) << used) - 1;
+        }
+
+        inline BitWord& operator[](std::size_t index) noexcept { return words[index]; }
+        inline BitWord operator[](std::size_t index) const noexcept { return words[index]; }
+        inline BitWord* data() noexcept { return words.data(); }
+        inline const BitWord* data() const noexcept { return words.data(); }
+
+    private:
+        std::size_t width;
+        std::size_t height;
+        std::size_t wordsPerRow;
+        std::vector<BitWord> words;
+    };
+
+}
+
+#endif /* BitBoard_h */
@@ -0,0 +1,81 @@
+#ifndef Bitmap_h
+#define Bitmap_h
+
+#include <cstdint>
+#include <vector>
+#include "BitBoard.h"
+
+namespace Util {
+
+    /* Packed bitmap, one bit per cell of the board.
+     * Storage is allocated once in the constructor (or resize),
+     * set/reset/test never allocate. The clear bits are counted per word
+     * (buildClearCounts, BitBoard.h), so that sampleClear() picks a clear
+     * bit in one draw, set/reset update the counts in O(log words) */
+    class Bitmap {
+    public:
+        using Word = std::uint64_t;
+        static constexpr std::size_t WORD_BITS = 64;
+
+        explicit Bitmap(std::size_t size = 0) { resize(size); }
+
+        // resize the bitmap, all the bits are cleared
+        void resize(std::size_t size) {
+            bits = size;
+            words.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+            counts.resize(words.size() + 1);
+            clear();
+        }
+
+        inline bool test(std::size_t index) const noexcept {
+            return 0 != (words[index / WORD_BITS] & (Word(1) << (index % WORD_BITS)));
+        }
+        inline void set(std::size_t index) noexcept {
+            Word &word = words[index / WORD_BITS];
+            Word bit = Word(1) << (index % WORD_BITS);
+            if (0 == (word & bit)) {
+                word |= bit;
+                addClearCount(counts.data(), words.size(), index / WORD_BITS, -1);
+                --clearBits;
+            }
+        }
+        inline void reset(std::size_t index) noexcept {
+            Word &word = words[index / WORD_BITS];
+            Word bit = Word(1) << (index % WORD_BITS);
+            if (0 != (word & bit)) {
+                word &= ~bit;
+                addClearCount(counts.data(), words.size(), index / WORD_BITS, 1);
+                ++clearBits;
+            }
+        }
+        // clear all the bits, keep the storage
+        inline void clear() noexcept {
+            for (Word &word : words) {
+                word = 0;
+            }
+            buildClearCounts(counts.data(), words.data(), words.size(), bits);
+            clearBits = bits;
+        }
+
+        // a clear bit picked uniformly, there should be one at least
+        template <typename Engine>
+        inline std::size_t sampleClear(Engine &generator) const {
+            return sampleClearBit(words.data(), counts.data(), words.size(), clearBits, generator);
+        }
+
+        inline std::size_t size() const noexcept { return bits; }
+        inline std::size_t clearCount() const noexcept { return clearBits; }
+        inline std::size_t wordCount() const noexcept { return words.size(); }
+        inline const Word* data() const noexcept { return words.data(); }
+
+    private:
+        std::size_t bits;
+        std::size_t clearBits;
+        std::vector<Word> words;
+        // clear bits per word, Fenwick tree
+        std::vector<std::uint32_t> counts;
+    };
+
+}
+
+#endif /* Bitmap_h */
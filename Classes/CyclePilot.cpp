@@ -0,0 +1,122 @@
+#include "CyclePilot.h"
+
+namespace Snake {
+
+    CyclePilot::CyclePilot(std::size_t width, std::size_t height, std::size_t shortcutLength)
+    : width(width), height(height), boardSize(width * height),
+      shortcutLength(0 == shortcutLength ? width * height / 2 : shortcutLength),
+      cycle(HamiltonianCycle::get(width, height)),
+      occupied(width, height), body(width * height), tail(0), length(0), food(NO_CELL),
+      forward(true), oriented(false) {
+    }
+
+    void CyclePilot::reset() {
+        occupied.clear();
+        tail = 0;
+        length = 0;
+        food = NO_CELL;
+        oriented = false;
+    }
+
+    void CyclePilot::apply(Util::DeltaView delta) {
+        for (const Util::CellChange &change : delta) {
+            switch (change.to) {
+                case Util::NodeType::HEAD:
+                    body[(tail + length) % boardSize] = change.cell;
+                    ++length;
+                    occupied.set(change.cell);
+                    break;
+                case Util::NodeType::BODY:
+                    // a new node, otherwise the old head
+                    if (Util::NodeType::UNINIT == change.from) {
+                        body[(tail + length) % boardSize] = change.cell;
+                        ++length;
+                        occupied.set(change.cell);
+                    }
+                    break;
+                case Util::NodeType::FOOD:
+                    food = change.cell;
+                    break;
+                default:
+                    // the tail moving on
+                    occupied.reset(body[tail]);
+                    tail = (tail + 1) % boardSize;
+                    --length;
+                    break;
+            }
+        }
+    }
+
+    bool CyclePilot::neighbour(Cell cell, Util::Direction heading, Cell &result) const {
+        std::size_t x = cell % width;
+        std::size_t y = cell / width;
+        switch (heading) {
+            case Util::Direction::LEFT:
+                if (0 == x) return false;
+                result = cell - 1;
+                return true;
+            case Util::Direction::RIGHT:
+                if (width - 1 == x) return false;
+                result = cell + 1;
+                return true;
+            case Util::Direction::UP:
+                if (height - 1 == y) return false;
+                result = static_cast<Cell>(cell + width);
+                return true;
+            case Util::Direction::DOWN:
+                if (0 == y) return false;
+                result = static_cast<Cell>(cell - width);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    Util::Direction CyclePilot::decide(Util::Direction direction) {
+        if (0 == length) {
+            return direction;
+        }
+        Cell head = getHeadCell();
+        Cell tailCell = body[tail];
+        if (!oriented) {
+            // the shorter way from the tail to the head, so the next cell
+            // on the cycle is not the tail: that would be turning back
+            forward = cycle->distance(tailCell, head) <= boardSize / 2;
+            oriented = true;
+        }
+
+        Cell best = following(head);
+        std::size_t bestAhead = 1;
+        if (length < shortcutLength) {
+            std::size_t tailAhead = ahead(head, tailCell);
+            std::size_t foodAhead = NO_CELL == food ? 1 : ahead(head, food);
+            for (int i = 0; i < 4; ++i) {
+                Util::Direction heading = static_cast<Util::Direction>(i);
+                Cell cell;
+                // turning back is discarded by the model
+                if (heading != direction && 0 == ((heading ^ direction) & 1)) {
+                    continue;
+                }
+                if (!neighbour(head, heading, cell) || occupied.test(cell)) {
+                    continue;
+                }
+                // past the tail would leave a part of the body ahead
+                std::size_t steps = ahead(head, cell);
+                if (steps > bestAhead && steps < tailAhead && steps <= foodAhead) {
+                    best = cell;
+                    bestAhead = steps;
+                }
+            }
+        }
+
+        if (best == head + 1) {
+            return Util::Direction::RIGHT;
+        } else if (best + 1 == head) {
+            return Util::Direction::LEFT;
+        } else if (best > head) {
+            return Util::Direction::UP;
+        }
+        return Util::Direction::DOWN;
+    }
+
+} // end namespace Snake
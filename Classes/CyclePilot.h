@@ -0,0 +1,92 @@
+#ifndef CyclePilot_h
+#define CyclePilot_h
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BitBoard.h"
+#include "Delta.h"
+#include "HamiltonianCycle.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* Computer player that always wins, on boards of even width or height.
+     *
+     * The snake follows a Hamiltonian cycle (HamiltonianCycle.h), so its
+     * body always lies along the cycle between the tail and the head, and
+     * the cells after the head up to the tail are free. Going to any of
+     * them is then safe as well: while the snake is shorter than
+     * shortcutLength, the head jumps to the neighbour furthest along the
+     * cycle that is neither past the food nor past the tail. Longer, it
+     * just follows the cycle, which reaches every food in turn.
+     *
+     * Like Autopilot, it follows any model through its deltas:
+     *
+     *     CyclePilot pilot(width, height);
+     *     pilot.apply(model.getDelta());
+     *     while (NORMAL == status) {
+     *         status = model.update(pilot.decide(model.getDirection()));
+     *         pilot.apply(model.getDelta());
+     *     }
+     *
+     * A restored game whose body does not lie along the cycle is not
+     * guaranteed to be won. */
+    class CyclePilot {
+    public:
+        using Cell = HamiltonianCycle::Cell;
+
+        // shortcutLength: 0 for half of the board
+        CyclePilot(std::size_t width, std::size_t height, std::size_t shortcutLength = 0);
+
+        // follow the model, call with the delta of every update and the
+        // one after construction
+        void apply(Util::DeltaView delta);
+        // forget the board, call before applying the delta of a restore
+        void reset();
+
+        // command for the next step of a snake heading to direction
+        Util::Direction decide(Util::Direction direction);
+
+        inline std::size_t getLength() const { return length; }
+        inline Cell getHeadCell() const { return body[(tail + length - 1) % boardSize]; }
+        inline const HamiltonianCycle& getCycle() const { return *cycle; }
+
+        // disable
+        CyclePilot(const CyclePilot&) = delete;
+        CyclePilot operator=(const CyclePilot&) = delete;
+    private:
+        static constexpr Cell NO_CELL = ~Cell(0);
+
+        std::size_t width;
+        std::size_t height;
+        std::size_t boardSize;
+        std::size_t shortcutLength;
+        std::shared_ptr<const HamiltonianCycle> cycle;
+
+        // board as known from the deltas
+        Util::BitBoard occupied;
+        // snake body, ring buffer, body[tail] is the tail
+        std::vector<Cell> body;
+        std::size_t tail;
+        std::size_t length;
+        Cell food;
+
+        // way round the cycle, picked at the first decide() so that the
+        // tail comes before the head
+        bool forward;
+        bool oriented;
+
+        // steps from cell from to cell to along the way round
+        inline std::size_t ahead(Cell from, Cell to) const {
+            std::size_t steps = cycle->distance(from, to);
+            return forward || 0 == steps ? steps : boardSize - steps;
+        }
+        inline Cell following(Cell cell) const { return forward ? cycle->next(cell) : cycle->previous(cell); }
+        // cell one step from cell towards heading, false if off the board
+        bool neighbour(Cell cell, Util::Direction heading, Cell &result) const;
+    };
+
+} // end namespace Snake
+
+#endif /* CyclePilot_h */
@@ -0,0 +1,47 @@
+#ifndef Delta_h
+#define Delta_h
+
+#include <cstdint>
+#include <vector>
+#include "Util.h"
+
+namespace Util {
+
+    /* One cell touched by an update, cell index = y * width + x.
+     * UNINIT stands for an empty cell, so
+     *   from == UNINIT          : a node is added
+     *   to == UNINIT            : a node is removed
+     *   otherwise               : the type of a node is changed */
+    struct CellChange {
+        std::uint32_t cell;
+        NodeType from;
+        NodeType to;
+    };
+
+    using CellChangesVector = std::vector<CellChange>;
+
+    /* Read-only view over the changes of the last update.
+     * Points into a buffer owned by the model and reused every step,
+     * valid until the next update / restore of that model.
+     * Applying the changes in order turns the previous board into the
+     * current one. */
+    class DeltaView {
+    public:
+        DeltaView() : first(nullptr), count(0) {}
+        DeltaView(const CellChange *first, std::size_t count) : first(first), count(count) {}
+        explicit DeltaView(const CellChangesVector &changes) : first(changes.data()), count(changes.size()) {}
+
+        inline const CellChange* begin() const noexcept { return first; }
+        inline const CellChange* end() const noexcept { return first + count; }
+        inline std::size_t size() const noexcept { return count; }
+        inline bool empty() const noexcept { return 0 == count; }
+        inline const CellChange& operator[](std::size_t index) const noexcept { return first[index]; }
+
+    private:
+        const CellChange *first;
+        std::size_t count;
+    };
+
+}
+
+#endif /* Delta_h */
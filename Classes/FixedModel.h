@@ -0,0 +1,265 @@
+#ifndef FixedModel_h
+#define FixedModel_h
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+#include "BitBoard.h"
+#include "Bitmap.h"
+#include "Delta.h"
+#include "Model.h"
+#include "Random.h"
+#include "Snapshot.h"
+#include "Util.h"
+
+namespace Snake {
+
+    namespace Detail {
+        // smallest power of 2 >= value
+        constexpr std::size_t nextPowerOfTwo(std::size_t value, std::size_t power = 1) {
+            return power >= value ? power : nextPowerOfTwo(value, power * 2);
+        }
+        constexpr std::size_t log2(std::size_t value) {
+            return value <= 1 ? 0 : 1 + log2(value / 2);
+        }
+    }
+
+    /* Model of the game with the board size fixed at compile time.
+     * Same rules and interface as GridModel, for the board sizes we ship.
+     *
+     * Rows are packed with a power of 2 stride larger than W, the extra
+     * columns are never part of the board. So x and y are a mask and a
+     * shift, a step is one add of a per-direction offset, and leaving the
+     * board on any side is caught by one unsigned compare and one mask:
+     * going left from x = 0 lands in the padding of the row below.
+     *
+     * Cells reported outside (delta, snapshot, accessors) are y * W + x,
+     * the same as the other models, snapshots are interchangeable. */
+    template <std::size_t W, std::size_t H>
+    class FixedModel {
+        static_assert(W >= 2 && H >= 2, "Board is too small, 2*2 at least");
+    public:
+
+        using GameStatus = Model::GameStatus;
+        using NodesVector = Model::NodesVector;
+        using Cell = std::uint32_t;
+
+        static constexpr std::size_t WIDTH = W;
+        static constexpr std::size_t HEIGHT = H;
+        static constexpr std::size_t BOARD_SIZE = W * H;
+
+        explicit FixedModel(std::uint64_t seed = 0);
+
+        // same semantics as Model::update
+        inline GameStatus update(Util::Direction command);
+
+        inline Util::Direction getDirection() const { return direction; }
+        inline std::size_t getFoodEaten() const { return foodEaten; }
+        inline Util::DeltaView getDelta() const { return Util::DeltaView(changes); }
+        NodesVector getNodesAdded() const { return copyChanges(true, false); }
+        NodesVector getNodesRemoved() const { return copyChanges(false, true); }
+        NodesVector getNodesChanged() const { return copyChanges(false, false); }
+
+        void snapshot(Util::Snapshot &buffer) const;
+        void restore(const std::uint8_t *data, std::size_t size);
+        inline void restore(const Util::Snapshot &buffer) { restore(buffer.data(), buffer.size()); }
+
+        inline std::size_t getWidth() const { return W; }
+        inline std::size_t getHeight() const { return H; }
+        inline std::size_t getLength() const { return length; }
+        inline Cell getHeadCell() const { return toCell(body[(tail + length - 1) & RING_MASK]); }
+        inline Cell getFoodCell() const { return toCell(food); }
+        inline bool isOccupied(Cell cell) const { return occupied[toPacked(cell)]; }
+
+        // disable
+        FixedModel(const FixedModel&) = delete;
+        FixedModel operator=(const FixedModel&) = delete;
+    private:
+        // packed cell = y * STRIDE + x
+        static constexpr std::size_t STRIDE = Detail::nextPowerOfTwo(W + 1);
+        static constexpr std::size_t SHIFT = Detail::log2(STRIDE);
+        static constexpr Cell X_MASK = static_cast<Cell>(STRIDE - 1);
+        static constexpr Cell PACKED_SIZE = static_cast<Cell>(STRIDE * H);
+        // ring capacity, a power of 2 so that wrapping is a mask
+        static constexpr std::size_t RING_SIZE = Detail::nextPowerOfTwo(W * H);
+        static constexpr std::size_t RING_MASK = RING_SIZE - 1;
+
+        std::size_t foodEaten;
+        std::array<Cell, RING_SIZE> body;
+        std::size_t tail;
+        std::size_t length;
+        Cell food;
+        std::bitset<STRIDE * H> occupied;
+        // occupied again, indexed by y * W + x, the food is sampled from it
+        Util::Bitmap cells;
+        Util::Direction direction;
+        Util::Random generator;
+        Util::CellChangesVector changes;
+        // scratch of restore()
+        std::vector<Cell> spareBody;
+        Util::Bitmap spareCells;
+
+        static inline Cell toCell(Cell packed) { return (packed >> SHIFT) * W + (packed & X_MASK); }
+        static inline Cell toPacked(Cell cell) { return static_cast<Cell>(((cell / W) << SHIFT) + cell % W); }
+        static inline Cell offset(Util::Direction heading) {
+            // LEFT, UP, RIGHT, DOWN, unsigned wrap for the negative ones
+            static const Cell offsets[4] = { Cell(0) - 1, Cell(STRIDE), 1, Cell(0) - Cell(STRIDE) };
+            return offsets[heading & 3];
+        }
+
+        inline void record(Cell packed, Util::NodeType from, Util::NodeType to) {
+            changes.push_back({ toCell(packed), from, to });
+        }
+        inline void pushHead(Cell packed) {
+            body[(tail + length) & RING_MASK] = packed;
+            ++length;
+            occupied[packed] = true;
+            cells.set(toCell(packed));
+        }
+        inline void popTail() {
+            Cell packed = body[tail];
+            tail = (tail + 1) & RING_MASK;
+            --length;
+            occupied[packed] = false;
+            cells.reset(toCell(packed));
+            record(packed, Util::NodeType::BODY, Util::NodeType::UNINIT);
+        }
+        inline void updateFood() {
+            food = toPacked(static_cast<Cell>(cells.sampleClear(generator)));
+            record(food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+        }
+        NodesVector copyChanges(bool fromEmpty, bool toEmpty) const;
+    };
+
+    // the board GameScene builds on desktop, 480 * 320 with RATIO 10
+    using DesktopModel = FixedModel<48, 32>;
+
+    template <std::size_t W, std::size_t H>
+    FixedModel<W, H>::FixedModel(std::uint64_t seed)
+    : foodEaten(0), tail(0), length(0), food(0), cells(W * H),
+      direction(Util::Direction::RIGHT), generator(seed), spareBody(W * H), spareCells(W * H) {
+        changes.reserve(4);
+        // put snake, same place as Model
+        Cell head = static_cast<Cell>(((H / 2) << SHIFT) + W / 2);
+        pushHead(head - 1);
+        pushHead(head);
+        record(head - 1, Util::NodeType::UNINIT, Util::NodeType::BODY);
+        record(head, Util::NodeType::UNINIT, Util::NodeType::HEAD);
+        updateFood();
+    }
+
+    template <std::size_t W, std::size_t H>
+    inline typename FixedModel<W, H>::GameStatus FixedModel<W, H>::update(Util::Direction command) {
+        changes.clear();
+
+        // UNDEFINED keeps going, UP <-> DOWN, LEFT <-> RIGHT are discarded
+        if (command < Util::Direction::UNDEFINED && 0 != ((command ^ direction) & 1)) {
+            direction = command;
+        }
+
+        Cell oldHead = body[(tail + length - 1) & RING_MASK];
+        record(oldHead, Util::NodeType::HEAD, Util::NodeType::BODY);
+
+        Cell newHead = oldHead + offset(direction);
+        // the padding columns catch left / right, unsigned wrap catches down
+        if (newHead >= PACKED_SIZE || (newHead & X_MASK) >= W) {
+            return GameStatus::LOSE;
+        }
+
+        if (newHead == food) {
+            pushHead(newHead);
+            record(newHead, Util::NodeType::FOOD, Util::NodeType::HEAD);
+            if (BOARD_SIZE == length) {
+                return GameStatus::WIN;
+            }
+            ++foodEaten;
+            updateFood();
+            return GameStatus::NORMAL;
+        }
+
+        // Move Tail First!! see Model::update
+        popTail();
+        if (occupied[newHead]) {
+            record(newHead, Util::NodeType::BODY, Util::NodeType::HEAD);
+            return GameStatus::LOSE;
+        }
+        pushHead(newHead);
+        record(newHead, Util::NodeType::UNINIT, Util::NodeType::HEAD);
+        return GameStatus::NORMAL;
+    }
+
+    template <std::size_t W, std::size_t H>
+    typename FixedModel<W, H>::NodesVector FixedModel<W, H>::copyChanges(bool fromEmpty, bool toEmpty) const {
+        NodesVector copyOfNodes;
+        for (const Util::CellChange &change : changes) {
+            if (fromEmpty == (Util::NodeType::UNINIT == change.from)
+                && toEmpty == (Util::NodeType::UNINIT == change.to)) {
+                copyOfNodes.push_back(Util::Node(change.cell % W, change.cell / W,
+                                                 toEmpty ? change.from : change.to));
+            }
+        }
+        return copyOfNodes;
+    }
+
+    template <std::size_t W, std::size_t H>
+    void FixedModel<W, H>::snapshot(Util::Snapshot &buffer) const {
+        Util::SnapshotWriter writer(buffer);
+        writer.write(Util::SNAPSHOT_MAGIC);
+        writer.write(static_cast<std::uint32_t>(W));
+        writer.write(static_cast<std::uint32_t>(H));
+        writer.write(static_cast<std::uint64_t>(foodEaten));
+        writer.write(static_cast<std::uint8_t>(direction));
+        writer.write(toCell(food));
+        writer.write(generator.getState());
+        writer.write(static_cast<std::uint32_t>(length));
+        Util::writeBody(writer, length, [this](std::size_t index) { return toCell(body[(tail + index) & RING_MASK]); });
+    }
+
+    template <std::size_t W, std::size_t H>
+    void FixedModel<W, H>::restore(const std::uint8_t *data, std::size_t size) {
+        Util::SnapshotReader reader(data, size);
+        if (Util::SNAPSHOT_MAGIC != reader.read<std::uint32_t>()
+            || W != reader.read<std::uint32_t>()
+            || H != reader.read<std::uint32_t>()) {
+            throw Util::Exception("Snapshot does not match the board");
+        }
+        std::uint64_t eaten = reader.read<std::uint64_t>();
+        std::uint8_t heading = reader.read<std::uint8_t>();
+        Cell foodCell = reader.read<Cell>();
+        std::uint64_t state = reader.read<std::uint64_t>();
+        std::uint32_t count = reader.read<std::uint32_t>();
+        if (count < 1 || count > BOARD_SIZE || foodCell >= BOARD_SIZE
+            || heading >= Util::Direction::UNDEFINED) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+        spareCells.clear();
+        Util::readBody(reader, W, H, count, spareBody.data(), spareCells);
+        if (count < BOARD_SIZE && spareCells.test(foodCell)) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+
+        changes.clear();
+        std::swap(cells, spareCells);
+        occupied.reset();
+        tail = 0;
+        length = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            Cell packed = toPacked(spareBody[i]);
+            body[length++] = packed;
+            occupied[packed] = true;
+            record(packed, Util::NodeType::UNINIT, Util::NodeType::BODY);
+        }
+        changes.back().to = Util::NodeType::HEAD;
+        food = toPacked(foodCell);
+        if (length < BOARD_SIZE) {
+            record(food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+        }
+        foodEaten = static_cast<std::size_t>(eaten);
+        direction = static_cast<Util::Direction>(heading);
+        generator.setState(state);
+    }
+
+} // end namespace Snake
+
+#endif /* FixedModel_h */
@@ -0,0 +1,200 @@
+#include "GameClient.h"
+#include <algorithm>
+
+namespace Snake {
+
+    GameClient::GameClient(std::size_t lead)
+    : width(0), height(0), synchronized(false), tail(0), length(0), food(NO_CELL),
+      lead(lead), sequence(0), hits(0), misses(0), bytesReceived(0), keyframes(0), resyncs(0) {
+    }
+
+    bool GameClient::receive(const std::uint8_t *data, std::size_t size) {
+        bytesReceived += size;
+        FrameHeader frame;
+        try {
+            frame = decodeFrame(data, size, keyframe, changes);
+            if (MessageType::KEYFRAME == frame.type) {
+                applyKeyframe();
+                synchronized = true;
+                ++keyframes;
+            } else if (!synchronized || frame.tick != header.tick + 1) {
+                // a frame was lost or came out of order
+                requestKeyframe();
+                return false;
+            } else {
+                applyDelta();
+            }
+        } catch (const Util::Exception&) {
+            requestKeyframe();
+            return false;
+        }
+        header = frame;
+        reconcile();
+        return true;
+    }
+
+    void GameClient::pushCommand(Util::Direction direction) {
+        ++sequence;
+        pending.push_back({ sequence, direction, header.tick + lead + 1 });
+        encodeInput(sequence, direction, outgoing);
+        if (send) {
+            send(outgoing.data(), outgoing.size());
+        }
+        predict();
+    }
+
+    void GameClient::applyKeyframe() {
+        std::size_t boardSize = std::size_t(keyframe.width) * keyframe.height;
+        if (width != keyframe.width || height != keyframe.height) {
+            width = keyframe.width;
+            height = keyframe.height;
+            body.resize(boardSize);
+        }
+        cells.assign(boardSize, Util::NodeType::UNINIT);
+        tail = 0;
+        length = keyframe.body.size();
+        for (std::size_t i = 0; i < length; ++i) {
+            Cell cell = keyframe.body[i];
+            body[i] = cell;
+            cells[cell] = length - 1 == i ? Util::NodeType::HEAD : Util::NodeType::BODY;
+        }
+        food = keyframe.food;
+        if (NO_CELL != food) {
+            cells[food] = Util::NodeType::FOOD;
+        }
+    }
+
+    void GameClient::applyDelta() {
+        // check first, a bad delta leaves the board as it was
+        for (const Util::CellChange &change : changes) {
+            if (change.cell >= cells.size()) {
+                throw Util::Exception("Delta is off the board");
+            }
+        }
+        for (const Util::CellChange &change : changes) {
+            cells[change.cell] = change.to;
+            switch (change.to) {
+                case Util::NodeType::HEAD:
+                    // BODY -> HEAD: bumped into itself, the head is not pushed
+                    if (Util::NodeType::BODY != change.from && length < body.size()) {
+                        body[(tail + length) % body.size()] = change.cell;
+                        ++length;
+                    }
+                    break;
+                case Util::NodeType::BODY:
+                    // a new node, otherwise the old head
+                    if (Util::NodeType::UNINIT == change.from && length < body.size()) {
+                        body[(tail + length) % body.size()] = change.cell;
+                        ++length;
+                    }
+                    break;
+                case Util::NodeType::FOOD:
+                    food = change.cell;
+                    break;
+                default:
+                    // the tail moving on
+                    if (length > 0) {
+                        tail = (tail + 1) % body.size();
+                        --length;
+                    }
+                    break;
+            }
+        }
+    }
+
+    void GameClient::requestKeyframe() {
+        if (!synchronized) {
+            // asked already, or the keyframe of the join is on its way
+            return;
+        }
+        synchronized = false;
+        ++resyncs;
+        encodeResync(outgoing);
+        if (send) {
+            send(outgoing.data(), outgoing.size());
+        }
+    }
+
+    void GameClient::reconcile() {
+        // sequences only grow, the acknowledged ones are in front
+        std::size_t done = 0;
+        while (done < pending.size() && pending[done].sequence <= header.ack) {
+            ++done;
+        }
+        pending.erase(pending.begin(), pending.begin() + done);
+
+        std::size_t checked = 0;
+        for (const Check &check : checks) {
+            if (check.tick > header.tick) {
+                break;
+            }
+            if (check.tick == header.tick) {
+                if (check.head == getHeadCell()) {
+                    ++hits;
+                } else {
+                    ++misses;
+                }
+            }
+            ++checked;
+        }
+        checks.erase(checks.begin(), checks.begin() + checked);
+
+        predict();
+        if (lead > 0 && prediction.size() == lead) {
+            checks.push_back({ header.tick + lead, prediction.back() });
+        }
+    }
+
+    void GameClient::predict() {
+        prediction.clear();
+        if (!synchronized || Model::GameStatus::NORMAL != getStatus() || 0 == length) {
+            return;
+        }
+        Util::Direction direction = header.direction;
+        Cell head = getHeadCell();
+        std::size_t next = 0;
+        for (std::size_t step = 0; step < lead; ++step) {
+            if (next < pending.size() && pending[next].tick <= header.tick + 1 + step) {
+                Util::Direction command = pending[next++].direction;
+                // UP <-> DOWN, LEFT <-> RIGHT are discarded, as in the model
+                if (Util::Direction::UNDEFINED != command && command % 2 != direction % 2) {
+                    direction = command;
+                }
+            }
+            std::size_t x = head % width;
+            std::size_t y = head / width;
+            Cell cell;
+            switch (direction) {
+                case Util::Direction::LEFT:
+                    if (0 == x) return;
+                    cell = head - 1;
+                    break;
+                case Util::Direction::RIGHT:
+                    if (width - 1 == x) return;
+                    cell = head + 1;
+                    break;
+                case Util::Direction::UP:
+                    if (height - 1 == y) return;
+                    cell = static_cast<Cell>(head + width);
+                    break;
+                default:
+                    if (0 == y) return;
+                    cell = static_cast<Cell>(head - width);
+                    break;
+            }
+            // the tail is one node shorter each step, unless it eats
+            bool occupied = Util::NodeType::BODY == cells[cell] || Util::NodeType::HEAD == cells[cell];
+            if (occupied) {
+                for (std::size_t i = 0; i <= step && i < length; ++i) {
+                    occupied = occupied && getBodyCell(i) != cell;
+                }
+            }
+            if (occupied || prediction.end() != std::find(prediction.begin(), prediction.end(), cell)) {
+                return;
+            }
+            prediction.push_back(cell);
+            head = cell;
+        }
+    }
+
+} // end namespace Snake
@@ -0,0 +1,128 @@
+#ifndef GameClient_h
+#define GameClient_h
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Delta.h"
+#include "Model.h"
+#include "TickCodec.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* Client side of GameServer: the board of the last frame received,
+     * and where the snake is going to be.
+     *
+     * Frames are applied as they come: a keyframe replaces the board, a
+     * delta must follow the tick of the board, otherwise the client asks
+     * for a keyframe (RESYNC) and drops deltas until it comes.
+     *
+     * Prediction: the server is lead ticks ahead of what the client
+     * shows (about the round trip), and applies one queued input per
+     * tick. An input sent on the confirmed tick T is expected on tick
+     * T + lead + 1. From the confirmed board, the client replays the
+     * inputs the server did not acknowledge yet, one per tick from the
+     * tick expected, for lead ticks, and shows the predicted heads. Each prediction is checked
+     * once the frame of its tick arrives (getPredictionMisses()).
+     *
+     * Not thread safe, the transport calls receive() on the thread that
+     * reads the client. */
+    class GameClient {
+    public:
+        using Cell = std::uint32_t;
+        using Send = std::function<void(const std::uint8_t *data, std::size_t size)>;
+
+        explicit GameClient(std::size_t lead = 0);
+
+        inline void setSend(const Send &send) { this->send = send; }
+        inline void setLead(std::size_t lead) { this->lead = lead; predict(); }
+
+        /* a message from the server, return false if it was dropped:
+         * malformed, or a delta that does not follow the board */
+        bool receive(const std::uint8_t *data, std::size_t size);
+        // send a command, predicted at once
+        void pushCommand(Util::Direction direction);
+
+        // a keyframe was received since the last RESYNC
+        inline bool isSynchronized() const { return synchronized; }
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+        inline std::uint64_t getTick() const { return header.tick; }
+        inline Model::GameStatus getStatus() const { return static_cast<Model::GameStatus>(header.status); }
+        inline Util::Direction getDirection() const { return header.direction; }
+        inline std::uint64_t getFoodEaten() const { return header.foodEaten; }
+        inline Util::NodeType getCell(Cell cell) const { return cells[cell]; }
+        inline std::size_t getLength() const { return length; }
+        inline Cell getHeadCell() const { return body[(tail + length - 1) % body.size()]; }
+        // node #index of the body, 0 is the tail
+        inline Cell getBodyCell(std::size_t index) const { return body[(tail + index) % body.size()]; }
+        inline Cell getFoodCell() const { return food; }
+
+        // predicted heads of the next ticks, [0] is the next one, stops
+        // where the snake would hit a wall or itself
+        inline const std::vector<Cell>& getPrediction() const { return prediction; }
+        inline std::uint64_t getPredictionHits() const { return hits; }
+        inline std::uint64_t getPredictionMisses() const { return misses; }
+        inline std::uint64_t getBytesReceived() const { return bytesReceived; }
+        inline std::uint64_t getKeyframes() const { return keyframes; }
+        inline std::uint64_t getResyncs() const { return resyncs; }
+
+        // disable
+        GameClient(const GameClient&) = delete;
+        GameClient operator=(const GameClient&) = delete;
+    private:
+        static constexpr Cell NO_CELL = ~Cell(0);
+
+        struct Pending {
+            std::uint32_t sequence;
+            Util::Direction direction;
+            // expected to be applied by the server on that tick
+            std::uint64_t tick;
+        };
+        // predicted head of a tick, checked when that tick is confirmed
+        struct Check {
+            std::uint64_t tick;
+            Cell head;
+        };
+
+        std::size_t width;
+        std::size_t height;
+        FrameHeader header;
+        bool synchronized;
+        // the confirmed board
+        std::vector<Util::NodeType> cells;
+        // ring buffer, body[tail] is the tail
+        std::vector<Cell> body;
+        std::size_t tail;
+        std::size_t length;
+        Cell food;
+
+        Send send;
+        std::size_t lead;
+        std::uint32_t sequence;
+        std::vector<Pending> pending;
+        std::vector<Cell> prediction;
+        std::vector<Check> checks;
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t bytesReceived;
+        std::uint64_t keyframes;
+        std::uint64_t resyncs;
+
+        // scratch of receive()
+        Keyframe keyframe;
+        Util::CellChangesVector changes;
+        Message outgoing;
+
+        void applyKeyframe();
+        void applyDelta();
+        void requestKeyframe();
+        // drop the inputs acknowledged, check and redo the prediction
+        void reconcile();
+        void predict();
+    };
+
+} // end namespace Snake
+
+#endif /* GameClient_h */
@@ -9,12 +9,20 @@
 #ifndef GameScene_h
 #define GameScene_h
 
+#include <memory>
+#include <vector>
 #include "cocos2d.h"
 #include "Util.h"
+#include "Delta.h"
+#include "InputQueue.h"
+#include "LatencyHistogram.h"
 
 
+class GridRenderer;
+
 namespace Snake {
     class Model;
+    class SimulationThread;
 }
 /*
 namespace Util {
@@ -24,7 +32,14 @@ namespace Util {
 class GameScene : public cocos2d::Layer
 {
 public:
-    static cocos2d::Scene* createScene();
+    static cocos2d::Scene* createScene(bool threadedSimulation = false);
+    
+    // the model steps on its own thread, see SimulationThread.h
+    static GameScene* createWithSimulationThread();
+    
+    // out of line, Model and SimulationThread are incomplete here
+    GameScene();
+    virtual ~GameScene();
     
     virtual bool init();
     
@@ -41,7 +56,8 @@ private:
     std::size_t height;
     std::size_t width;
     float speed;
-    Util::Direction userCommand;
+    // commands of the user, the tick takes one per step
+    Snake::InputQueue inputQueue{ Snake::INPUT_QUEUE_CAPACITY };
     
     cocos2d::Point touchBeginPoint;
     cocos2d::Point touchEndPoint;
@@ -50,11 +66,38 @@ private:
     cocos2d::Size visiblesize;
     cocos2d::Menu* menu;
     
-    Snake::Model* modelPtr;
+    std::unique_ptr<Snake::Model> modelPtr;
+    // the whole board, one draw call
+    GridRenderer* board;
+    
+    // threaded mode, modelPtr is not used then
+    bool threadedSimulation = false;
+    std::unique_ptr<Snake::SimulationThread> simulation;
+    // board as drawn from the last frame, heads drawn as body
+    std::vector<Util::NodeType> drawnCells;
+    Util::CellChangesVector frameChanges;
+    // head moving smoothly between the cells of the last two frames
+    cocos2d::Sprite* headSprite = nullptr;
+    
+    // latency of the input path, reported on game over
+    // input to step, scheduler mode only, the simulation keeps its own
+    Util::LatencyHistogram inputLatency;
+    // step to the end of the first draw showing it
+    Util::LatencyHistogram presentLatency;
+    bool stepPending = false;
+    std::chrono::steady_clock::time_point stepTime;
+    cocos2d::EventListenerCustom* afterDrawListener = nullptr;
     
     // main function
     void update(float dt);
+    // threaded mode, every frame: draw the latest frame of the simulation
+    void updateFromSimulation(float dt);
     void gameOver();
+    void onAfterDraw();
+    void reportLatency();
+    
+    // queue a command of the user, timestamped now
+    void pushCommand(Util::Direction direction);
     
     // keyboard controller
     void createKeyboardListener();
@@ -66,9 +109,8 @@ private:
     void onTouchEnded(cocos2d::Touch* touch, cocos2d::Event* event);
     void parseTouchCommand();
     
-    int createAndPutSprite(const Util::Node& node);
-    int removeSprite(const Util::Node& node);
-    int updateSprite(const Util::Node& node);
+    // apply the changes of the model to the board, in order
+    void applyDelta(Util::DeltaView delta);
 };
 
 #endif /* GameScene_h */
@@ -0,0 +1,189 @@
+#include "GameServer.h"
+#include <chrono>
+#include "InputQueue.h"
+
+namespace Snake {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+    }
+
+    GameServer::GameServer(std::size_t width, std::size_t height, std::size_t keyframeInterval, std::size_t threads)
+    : width(width), height(height), keyframeInterval(keyframeInterval), restart(false),
+      pool(threads), rejected(0) {
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+    }
+
+    GameServer::RoomId GameServer::createRoom(std::uint64_t seed) {
+        std::unique_ptr<Room> room(new Room());
+        room->seed = seed;
+        room->model.reset(new GridModel(width, height, seed));
+        room->status = GameStatus::NORMAL;
+        room->tick = 0;
+        room->ack = 0;
+        room->sendKeyframes = false;
+        rooms.push_back(std::move(room));
+        return static_cast<RoomId>(rooms.size() - 1);
+    }
+
+    void GameServer::join(ClientId client, RoomId room) {
+        if (room >= rooms.size()) {
+            throw Util::Exception("No such room");
+        }
+        leave(client);
+        members[client] = room;
+        rooms[room]->clients.push_back({ client, true });
+    }
+
+    void GameServer::leave(ClientId client) {
+        auto found = members.find(client);
+        if (members.end() == found) {
+            return;
+        }
+        Room &room = *rooms[found->second];
+        for (auto it = room.clients.begin(); it != room.clients.end(); ++it) {
+            if (it->id == client) {
+                // the next one plays, its inputs start from now on
+                if (room.clients.begin() == it) {
+                    room.inputs.clear();
+                }
+                room.clients.erase(it);
+                break;
+            }
+        }
+        members.erase(found);
+    }
+
+    void GameServer::receive(ClientId client, const std::uint8_t *data, std::size_t size) {
+        auto found = members.find(client);
+        if (members.end() == found) {
+            ++rejected;
+            return;
+        }
+        Room &room = *rooms[found->second];
+        try {
+            switch (peekType(data, size)) {
+                case MessageType::INPUT: {
+                    Input input;
+                    decodeInput(data, size, input.sequence, input.direction);
+                    // spectators do not play, a flood of inputs is cut
+                    if (room.clients.empty() || room.clients[0].id != client
+                        || room.inputs.size() >= INPUT_QUEUE_CAPACITY) {
+                        ++rejected;
+                        return;
+                    }
+                    room.inputs.push_back(input);
+                    break;
+                }
+                case MessageType::RESYNC:
+                    for (Member &member : room.clients) {
+                        if (member.id == client) {
+                            member.needsKeyframe = true;
+                        }
+                    }
+                    break;
+                default:
+                    ++rejected;
+                    break;
+            }
+        } catch (const Util::Exception&) {
+            ++rejected;
+        }
+    }
+
+    void GameServer::tick() {
+        pool.parallelFor(rooms.size(), 1, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                stepRoom(*rooms[i]);
+            }
+        });
+        // one thread only through the transport
+        for (std::unique_ptr<Room> &room : rooms) {
+            sendFrames(*room);
+        }
+    }
+
+    void GameServer::stepRoom(Room &room) {
+        Clock::time_point start = Clock::now();
+        room.delta.clear();
+        room.keyframe.clear();
+        room.sendKeyframes = false;
+
+        if (GameStatus::NORMAL == room.status) {
+            Util::Direction command = Util::Direction::UNDEFINED;
+            if (!room.inputs.empty()) {
+                command = room.inputs.front().direction;
+                room.ack = room.inputs.front().sequence;
+                room.inputs.pop_front();
+            }
+            room.status = room.model->update(command);
+            ++room.tick;
+            encodeDelta(headerOf(room), room.model->getDelta(), room.delta);
+            room.sendKeyframes = 0 != keyframeInterval && 0 == room.tick % keyframeInterval;
+        } else if (restart) {
+            ++room.statistics.games;
+            room.model.reset(new GridModel(width, height, room.seed + room.statistics.games));
+            room.status = GameStatus::NORMAL;
+            room.inputs.clear();
+            ++room.tick;
+            room.sendKeyframes = true;
+        }
+
+        bool needed = room.sendKeyframes;
+        for (const Member &member : room.clients) {
+            needed = needed || member.needsKeyframe;
+        }
+        if (needed) {
+            encodeKeyframe(room);
+        }
+        ++room.statistics.ticks;
+        room.statistics.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void GameServer::sendFrames(Room &room) {
+        for (Member &member : room.clients) {
+            bool keyframe = room.sendKeyframes || member.needsKeyframe;
+            const Message *frame = keyframe ? &room.keyframe : &room.delta;
+            // a game over and not restarted sends nothing
+            if (frame->empty()) {
+                continue;
+            }
+            member.needsKeyframe = false;
+            if (keyframe) {
+                ++room.statistics.keyframes;
+            }
+            ++room.statistics.frames;
+            room.statistics.bytes += frame->size();
+            if (send) {
+                send(member.id, frame->data(), frame->size());
+            }
+        }
+    }
+
+    FrameHeader GameServer::headerOf(const Room &room) const {
+        FrameHeader header;
+        header.tick = room.tick;
+        header.status = static_cast<std::uint8_t>(room.status);
+        header.direction = room.model->getDirection();
+        header.foodEaten = room.model->getFoodEaten();
+        header.ack = room.ack;
+        return header;
+    }
+
+    void GameServer::encodeKeyframe(Room &room) {
+        const GridModel &model = *room.model;
+        Keyframe keyframe;
+        keyframe.width = static_cast<std::uint32_t>(width);
+        keyframe.height = static_cast<std::uint32_t>(height);
+        // no food once the board is full
+        keyframe.food = model.getLength() < width * height ? model.getFoodCell() : Keyframe::NO_FOOD;
+        keyframe.body.resize(model.getLength());
+        for (std::size_t i = 0; i < keyframe.body.size(); ++i) {
+            keyframe.body[i] = model.getBodyCell(i);
+        }
+        Snake::encodeKeyframe(headerOf(room), keyframe, room.keyframe);
+    }
+
+} // end namespace Snake
@@ -0,0 +1,123 @@
+#ifndef GameServer_h
+#define GameServer_h
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "GridModel.h"
+#include "TickCodec.h"
+#include "WorkerPool.h"
+
+namespace Snake {
+
+    /* Authoritative server of many rooms, one game per room.
+     *
+     * Every tick() steps each room once, rooms spread over a WorkerPool,
+     * then sends each client of a room that tick as one frame (see
+     * TickCodec.h): a delta of the cells the step changed, or a keyframe
+     * every keyframeInterval ticks, to a client that just joined, and to
+     * one that asked for it (RESYNC). The first client of a room plays,
+     * the others watch; its inputs are queued and applied one per tick.
+     *
+     * The transport is a Send callback, see LoopbackTransport.h for an
+     * in-process one. Not thread safe: call everything from the thread
+     * running the server loop, tick() uses the pool by itself. */
+    class GameServer {
+    public:
+        using ClientId = std::uint32_t;
+        using RoomId = std::uint32_t;
+        using GameStatus = GridModel::GameStatus;
+        using Send = std::function<void(ClientId client, const std::uint8_t *data, std::size_t size)>;
+
+        // what a room cost so far
+        struct RoomStatistics {
+            std::uint64_t ticks = 0;
+            std::uint64_t games = 0;
+            std::uint64_t frames = 0;
+            std::uint64_t keyframes = 0;
+            // bytes of the frames sent to all the clients of the room
+            std::uint64_t bytes = 0;
+            // time spent stepping and encoding the room
+            double seconds = 0;
+        };
+
+        /**********************************************************************
+         * rooms of width * height boards, a keyframe every keyframeInterval  *
+         * ticks (0 for only when needed), threads = 0 means one worker per   *
+         * hardware thread                                                    *
+         **********************************************************************/
+        GameServer(std::size_t width, std::size_t height, std::size_t keyframeInterval = 64,
+                   std::size_t threads = 0);
+
+        inline void setSend(const Send &send) { this->send = send; }
+        // start a new game in a room once its game is over, seeded seed + #games
+        inline void setRestart(bool restart) { this->restart = restart; }
+
+        RoomId createRoom(std::uint64_t seed);
+        // a client is in one room at most, joining another one leaves the first
+        void join(ClientId client, RoomId room);
+        void leave(ClientId client);
+
+        // a message from a client, malformed ones are counted and dropped
+        void receive(ClientId client, const std::uint8_t *data, std::size_t size);
+
+        // step every room and send the frames
+        void tick();
+
+        inline std::size_t getRoomCount() const { return rooms.size(); }
+        inline const GridModel& getModel(RoomId room) const { return *rooms[room]->model; }
+        inline GameStatus getStatus(RoomId room) const { return rooms[room]->status; }
+        inline const RoomStatistics& getStatistics(RoomId room) const { return rooms[room]->statistics; }
+        inline std::uint64_t getRejected() const { return rejected; }
+
+        // disable
+        GameServer(const GameServer&) = delete;
+        GameServer operator=(const GameServer&) = delete;
+    private:
+        struct Input {
+            std::uint32_t sequence;
+            Util::Direction direction;
+        };
+        struct Member {
+            ClientId id;
+            bool needsKeyframe;
+        };
+        struct Room {
+            std::uint64_t seed;
+            std::unique_ptr<GridModel> model;
+            GameStatus status;
+            std::uint64_t tick;
+            std::deque<Input> inputs;
+            // sequence of the last input applied
+            std::uint32_t ack;
+            // clients[0] plays
+            std::vector<Member> clients;
+            // frames of the last tick, keyframe only if someone needs it
+            Message delta;
+            Message keyframe;
+            bool sendKeyframes;
+            RoomStatistics statistics;
+        };
+
+        std::size_t width;
+        std::size_t height;
+        std::size_t keyframeInterval;
+        bool restart;
+        Send send;
+        Util::WorkerPool pool;
+        std::vector<std::unique_ptr<Room>> rooms;
+        std::unordered_map<ClientId, RoomId> members;
+        std::uint64_t rejected;
+
+        void stepRoom(Room &room);
+        void sendFrames(Room &room);
+        FrameHeader headerOf(const Room &room) const;
+        void encodeKeyframe(Room &room);
+    };
+
+} // end namespace Snake
+
+#endif /* GameServer_h */
@@ -0,0 +1,218 @@
+#include "GridModel.h"
+#include <algorithm>
+#include <limits>
+#include "BitBoard.h"
+
+namespace Snake {
+
+    GridModel::GridModel(std::size_t width, std::size_t height, std::uint64_t seed)
+    : height(height), width(width), boardSize(height * width), foodEaten(0),
+      tail(0), length(0), headX(width / 2), headY(height / 2), food(0),
+      direction(Util::Direction::RIGHT), generator(seed) {
+        // check the board size, should be greater than 2*2
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+        if (boardSize > std::numeric_limits<Cell>::max()) {
+            throw Util::Exception("Board is too large");
+        }
+
+        // the only allocations of the model
+        body.resize(boardSize);
+        occupied.resize(boardSize);
+        spareBody.resize(boardSize);
+        spareOccupied.resize(boardSize);
+        // at most four changes each frame
+        changes.reserve(4);
+
+        // put snake, same place as Model
+        pushHead(toCell(headX - 1, headY));
+        pushHead(toCell(headX, headY));
+        record(toCell(headX - 1, headY), Util::NodeType::UNINIT, Util::NodeType::BODY);
+        record(toCell(headX, headY), Util::NodeType::UNINIT, Util::NodeType::HEAD);
+        // put food
+        updateFood();
+        SNAKE_EVENT(MODEL_CREATED, width, height);
+    }
+
+    GridModel::GameStatus GridModel::update(Util::Direction command) {
+
+        changes.clear();
+
+        updateDirection(command);
+
+        // the origin head becomes one part of the body
+        record(getHeadCell(), Util::NodeType::HEAD, Util::NodeType::BODY);
+
+        std::size_t x = headX;
+        std::size_t y = headY;
+        if (!generateSnakeHead(x, y)) {
+            return GameStatus::LOSE;
+        }
+        Cell newHead = toCell(x, y);
+
+        if (newHead == food) {
+            // size of snake increases, no need to remove the snake tail
+            // the food node is changed into the head
+            pushHead(newHead);
+            record(newHead, Util::NodeType::FOOD, Util::NodeType::HEAD);
+            headX = x;
+            headY = y;
+            if (boardSize == length) {
+                return GameStatus::WIN;
+            }
+            ++foodEaten;
+            updateFood();
+            return GameStatus::NORMAL;
+        }
+
+        // Move Tail First!! see Model::update
+        popTail();
+        if (occupied.test(newHead)) {
+            // bump into itself
+            record(newHead, Util::NodeType::BODY, Util::NodeType::HEAD);
+            return GameStatus::LOSE;
+        }
+        pushHead(newHead);
+        record(newHead, Util::NodeType::UNINIT, Util::NodeType::HEAD);
+        headX = x;
+        headY = y;
+        return GameStatus::NORMAL;
+    }
+
+    void GridModel::updateDirection(Util::Direction command) noexcept {
+        // if command == undefined, use the privious direction
+        if (Util::Direction::UNDEFINED == command) {
+            return;
+        }
+        if (static_cast<short>(command) % 2 == static_cast<short>(direction) % 2) {
+            // UP <-> DOWN, LEFT <-> RIGHT
+            // junk info, discard
+            return;
+        }
+        direction = command;
+    }
+
+    bool GridModel::generateSnakeHead(std::size_t &x, std::size_t &y) const noexcept {
+        // unsigned arithmetic, 0 - 1 wraps and fails the bound check
+        switch (direction) {
+            case Util::LEFT:
+                --x;
+                break;
+            case Util::RIGHT:
+                ++x;
+                break;
+            case Util::UP:
+                ++y;
+                break;
+            case Util::DOWN:
+                --y;
+                break;
+            default:
+                // should never go into here :)
+                return false;
+        }
+        return width > x && height > y;
+    }
+
+    void GridModel::updateFood() {
+        food = static_cast<Cell>(occupied.sampleClear(generator));
+        SNAKE_TRACE_DEBUG("Put food at " << toNode(food, Util::NodeType::FOOD));
+        SNAKE_EVENT(FOOD_PUT, food % width, food / width);
+        record(food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+    }
+
+    void GridModel::pushHead(Cell cell) noexcept {
+        body[(tail + length) % boardSize] = cell;
+        ++length;
+        occupied.set(cell);
+    }
+
+    void GridModel::popTail() noexcept {
+        Cell cell = body[tail];
+        tail = (tail + 1) % boardSize;
+        --length;
+        occupied.reset(cell);
+        record(cell, Util::NodeType::BODY, Util::NodeType::UNINIT);
+    }
+
+    void GridModel::snapshot(Util::Snapshot &buffer) const {
+        Util::SnapshotWriter writer(buffer);
+        writer.write(Util::SNAPSHOT_MAGIC);
+        writer.write(static_cast<std::uint32_t>(width));
+        writer.write(static_cast<std::uint32_t>(height));
+        writer.write(static_cast<std::uint64_t>(foodEaten));
+        writer.write(static_cast<std::uint8_t>(direction));
+        writer.write(food);
+        writer.write(generator.getState());
+        writer.write(static_cast<std::uint32_t>(length));
+        Util::writeBody(writer, length, [this](std::size_t index) { return getBodyCell(index); });
+    }
+
+    void GridModel::restore(const std::uint8_t *data, std::size_t size) {
+        // parse into the spare buffers, the model is untouched on failure
+        Util::SnapshotReader reader(data, size);
+        if (Util::SNAPSHOT_MAGIC != reader.read<std::uint32_t>()
+            || width != reader.read<std::uint32_t>()
+            || height != reader.read<std::uint32_t>()) {
+            throw Util::Exception("Snapshot does not match the board");
+        }
+        std::uint64_t eaten = reader.read<std::uint64_t>();
+        std::uint8_t heading = reader.read<std::uint8_t>();
+        Cell foodCell = reader.read<Cell>();
+        std::uint64_t state = reader.read<std::uint64_t>();
+        std::uint32_t count = reader.read<std::uint32_t>();
+        if (count < 1 || count > boardSize || foodCell >= boardSize
+            || heading >= Util::Direction::UNDEFINED) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+        spareOccupied.clear();
+        Util::readBody(reader, width, height, count, spareBody.data(), spareOccupied);
+        if (count < boardSize && spareOccupied.test(foodCell)) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+
+        changes.clear();
+        body.swap(spareBody);
+        std::swap(occupied, spareOccupied);
+        for (std::size_t i = 0; i < count; ++i) {
+            record(body[i], Util::NodeType::UNINIT, Util::NodeType::BODY);
+        }
+        changes.back().to = Util::NodeType::HEAD;
+        tail = 0;
+        length = count;
+        headX = body[count - 1] % width;
+        headY = body[count - 1] / width;
+        food = foodCell;
+        if (length < boardSize) {
+            record(food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+        }
+        foodEaten = static_cast<std::size_t>(eaten);
+        direction = static_cast<Util::Direction>(heading);
+        generator.setState(state);
+    }
+
+    GridModel::NodesVector GridModel::copyChanges(bool fromEmpty, bool toEmpty) const {
+        NodesVector copyOfNodes;
+        for (const Util::CellChange &change : changes) {
+            if (fromEmpty == (Util::NodeType::UNINIT == change.from)
+                && toEmpty == (Util::NodeType::UNINIT == change.to)) {
+                copyOfNodes.push_back(toNode(change.cell, toEmpty ? change.from : change.to));
+            }
+        }
+        return copyOfNodes;
+    }
+
+    GridModel::NodesVector GridModel::getNodesAdded() const {
+        return copyChanges(true, false);
+    }
+
+    GridModel::NodesVector GridModel::getNodesRemoved() const {
+        return copyChanges(false, true);
+    }
+
+    GridModel::NodesVector GridModel::getNodesChanged() const {
+        return copyChanges(false, false);
+    }
+
+} // end namespace Snake
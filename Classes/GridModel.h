@@ -0,0 +1,132 @@
+#ifndef GridModel_h
+#define GridModel_h
+
+#include <cstdint>
+#include <vector>
+#include "Bitmap.h"
+#include "Delta.h"
+#include "Model.h"
+#include "Random.h"
+#include "Snapshot.h"
+#include "Trace.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* Model of the game with flat storage.
+     * Same interface as Snake::Model, but the board is a packed occupancy
+     * bitmap and the snake body is a ring buffer of cell indices sized to
+     * the board, so update() never touches the heap and collision checks
+     * are a single bit test. Cell index = y * width + x */
+    class GridModel {
+    public:
+
+        using GameStatus = Model::GameStatus;
+        using NodesVector = Model::NodesVector;
+        using Cell = std::uint32_t;
+
+        /**********************************************************************
+         * Constructor, arguments for size of the game area                   *
+         * Note: size should be greater than 2*2, otherwise throws exceptions *
+         * seed: see Model                                                    *
+         **********************************************************************/
+        GridModel(std::size_t width = 2, std::size_t height = 2, std::uint64_t seed = 0);
+
+        // same semantics as Model::update
+        GameStatus update(Util::Direction command);
+
+        // getter of direction
+        inline Util::Direction getDirection() const { return direction; }
+        // getter of the foodEaten
+        inline std::size_t getFoodEaten() const { return foodEaten; }
+
+        // changes of the last update, no copy, see Delta.h
+        inline Util::DeltaView getDelta() const { return Util::DeltaView(changes); }
+
+        // after calling update(), should call these
+        // functions to get lists of nodes changed
+        // Note, these copy, getDelta() is cheaper
+        NodesVector getNodesAdded() const;
+        NodesVector getNodesRemoved() const;
+        NodesVector getNodesChanged() const;
+
+        // same format and semantics as Model::snapshot / Model::restore,
+        // snapshots of both models are interchangeable
+        void snapshot(Util::Snapshot &buffer) const;
+        void restore(const std::uint8_t *data, std::size_t size);
+        inline void restore(const Util::Snapshot &buffer) { restore(buffer.data(), buffer.size()); }
+
+        /************************ Headless Accessors *********************/
+
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+        inline std::size_t getLength() const { return length; }
+        inline Cell getHeadCell() const { return body[(tail + length - 1) % boardSize]; }
+        // node #index of the body, 0 is the tail, getLength() - 1 the head
+        inline Cell getBodyCell(std::size_t index) const { return body[(tail + index) % boardSize]; }
+        inline Cell getFoodCell() const { return food; }
+        inline bool isOccupied(Cell cell) const { return occupied.test(cell); }
+        inline const Util::Bitmap& getOccupied() const { return occupied; }
+        inline Cell toCell(std::size_t x, std::size_t y) const { return static_cast<Cell>(y * width + x); }
+        inline Util::Node toNode(Cell cell, Util::NodeType type) const {
+            return Util::Node(cell % width, cell / width, type);
+        }
+
+        // disable
+        GridModel(const GridModel&) = delete;
+        GridModel operator=(const GridModel&) = delete;
+    private:
+        // board size
+        std::size_t height;
+        std::size_t width;
+        std::size_t boardSize;
+        // #food eaten
+        std::size_t foodEaten;
+        /* snake body, ring buffer with capacity boardSize
+         * body[tail] is the tail of the snake
+         * body[(tail + length - 1) % boardSize] is the head */
+        std::vector<Cell> body;
+        std::size_t tail;
+        std::size_t length;
+        // head position, kept to avoid div/mod on every step
+        std::size_t headX;
+        std::size_t headY;
+        // food position
+        Cell food;
+        // one bit per cell, set if the snake is there, the food is sampled from it
+        Util::Bitmap occupied;
+        // direction the snake heading to
+        Util::Direction direction;
+        // engine placing the food, owned by this model only
+        Util::Random generator;
+        // scratch of restore(), swapped with body / occupied on success
+        std::vector<Cell> spareBody;
+        Util::Bitmap spareOccupied;
+        // cells changed by the last update, capacity reserved in the constructor
+        Util::CellChangesVector changes;
+
+        /************************ Utility Functions *********************/
+
+        void updateDirection(Util::Direction command) noexcept;
+        // check the capacity before calling this function
+        // i.e check if there is enough room to put a food
+        void updateFood();
+        // position one step from the head towards the direction,
+        // return false if that position is out of the board
+        bool generateSnakeHead(std::size_t &x, std::size_t &y) const noexcept;
+        // put a cell into the bitmap and the head of the ring
+        void pushHead(Cell cell) noexcept;
+        // pop the tail of the ring, remove it from the bitmap
+        // and record the removal
+        void popTail() noexcept;
+        inline void record(Cell cell, Util::NodeType from, Util::NodeType to) {
+            changes.push_back({ cell, from, to });
+        }
+        // copy the additions / removals / type changes among the changes,
+        // a removed node keeps its old type
+        NodesVector copyChanges(bool fromEmpty, bool toEmpty) const;
+    };
+
+} // end namespace Snake
+
+#endif /* GridModel_h */
@@ -0,0 +1,248 @@
+//
+//  GridRenderer.cpp
+//  Snake
+//
+
+#include "GridRenderer.h"
+#include <algorithm>
+#include <cstring>
+
+USING_NS_CC;
+
+namespace {
+    // tile of each drawable NodeType, same files as the sprites
+    const char* const TILE_FILES[Util::NodeType::UNINIT] = {
+        "SnakeHead.png",  // HEAD
+        "Snake.png",      // BODY
+        "Food.png",       // FOOD
+    };
+
+    // RGBA8888, premultiplied, whatever the file was
+    bool loadTile(Image &image, const char *file, std::vector<unsigned char> &pixels) {
+        if (!image.initWithImageFile(file)) {
+            return false;
+        }
+        std::size_t count = static_cast<std::size_t>(image.getWidth()) * image.getHeight();
+        const unsigned char *data = image.getData();
+        pixels.resize(count * 4);
+        switch (image.getRenderFormat()) {
+            case Texture2D::PixelFormat::RGBA8888:
+                std::memcpy(pixels.data(), data, count * 4);
+                if (!image.hasPremultipliedAlpha()) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        unsigned alpha = pixels[4 * i + 3];
+                        for (std::size_t c = 0; c < 3; ++c) {
+                            pixels[4 * i + c] = static_cast<unsigned char>(pixels[4 * i + c] * alpha / 255);
+                        }
+                    }
+                }
+                return true;
+            case Texture2D::PixelFormat::RGB888:
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::memcpy(&pixels[4 * i], data + 3 * i, 3);
+                    pixels[4 * i + 3] = 255;
+                }
+                return true;
+            default:
+                CCLOG("GridRenderer: unsupported pixel format of %s", file);
+                return false;
+        }
+    }
+}
+
+GridRenderer* GridRenderer::create(std::size_t width, std::size_t height, float cellSize)
+{
+    GridRenderer *renderer = new (std::nothrow) GridRenderer();
+    if (renderer && renderer->init(width, height, cellSize)) {
+        renderer->autorelease();
+        return renderer;
+    }
+    CC_SAFE_DELETE(renderer);
+    return nullptr;
+}
+
+GridRenderer::GridRenderer()
+: width(0), height(0), cellSize(0), atlas(nullptr), vbo(0), dirtyAll(true) {}
+
+GridRenderer::~GridRenderer()
+{
+    CC_SAFE_RELEASE(atlas);
+    if (vbo) {
+        glDeleteBuffers(1, &vbo);
+    }
+}
+
+bool GridRenderer::init(std::size_t width, std::size_t height, float cellSize)
+{
+    if (!Node::init()) {
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    this->cellSize = cellSize;
+    setContentSize(Size(width * cellSize, height * cellSize));
+    setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE));
+
+    if (!createAtlas()) {
+        return false;
+    }
+    vertices.assign(width * height * VERTICES_PER_CELL, Vertex());
+    createBuffer();
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // the GL context is gone, the buffer with it, the copy is still here
+    auto listener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom* event){
+        createBuffer();
+    });
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+#endif
+    return true;
+}
+
+bool GridRenderer::createAtlas()
+{
+    // tiles side by side in one row
+    std::vector<unsigned char> tiles[Util::NodeType::UNINIT];
+    int tileWidths[Util::NodeType::UNINIT];
+    int tileHeights[Util::NodeType::UNINIT];
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    for (int type = 0; type < Util::NodeType::UNINIT; ++type) {
+        Image image;
+        if (!loadTile(image, TILE_FILES[type], tiles[type])) {
+            return false;
+        }
+        tileWidths[type] = image.getWidth();
+        tileHeights[type] = image.getHeight();
+        atlasWidth += tileWidths[type];
+        atlasHeight = std::max(atlasHeight, tileHeights[type]);
+    }
+
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(atlasWidth) * atlasHeight * 4, 0);
+    float scale = Director::getInstance()->getContentScaleFactor();
+    int left = 0;
+    for (int type = 0; type < Util::NodeType::UNINIT; ++type) {
+        for (int row = 0; row < tileHeights[type]; ++row) {
+            std::memcpy(&pixels[(static_cast<std::size_t>(row) * atlasWidth + left) * 4],
+                        &tiles[type][static_cast<std::size_t>(row) * tileWidths[type] * 4],
+                        static_cast<std::size_t>(tileWidths[type]) * 4);
+        }
+        tileTexCoords[type] = Rect(static_cast<float>(left) / atlasWidth, 0,
+                                   static_cast<float>(tileWidths[type]) / atlasWidth,
+                                   static_cast<float>(tileHeights[type]) / atlasHeight);
+        tileSizes[type] = Size(tileWidths[type] / scale, tileHeights[type] / scale);
+        left += tileWidths[type];
+    }
+
+    Image image;
+    if (!image.initWithRawData(pixels.data(), static_cast<ssize_t>(pixels.size()), atlasWidth, atlasHeight, 8, true)) {
+        return false;
+    }
+    atlas = new (std::nothrow) Texture2D();
+    if (!atlas || !atlas->initWithImage(&image)) {
+        CC_SAFE_RELEASE_NULL(atlas);
+        return false;
+    }
+    return true;
+}
+
+void GridRenderer::createBuffer()
+{
+    if (!vbo) {
+        glGenBuffers(1, &vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirtyCells.clear();
+    dirtyAll = false;
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void GridRenderer::applyDelta(Util::DeltaView delta)
+{
+    for (const Util::CellChange& change : delta) {
+        setCell(change.cell, change.to);
+    }
+}
+
+void GridRenderer::clearCells()
+{
+    std::fill(vertices.begin(), vertices.end(), Vertex());
+    dirtyAll = true;
+}
+
+void GridRenderer::setCell(std::uint32_t cell, Util::NodeType type)
+{
+    Vertex *quad = &vertices[cell * VERTICES_PER_CELL];
+    if (Util::NodeType::UNINIT == type) {
+        // zero area, nothing rasterized
+        std::fill(quad, quad + VERTICES_PER_CELL, Vertex());
+    } else {
+        const Rect &tex = tileTexCoords[type];
+        const Size &size = tileSizes[type];
+        float x = (cell % width) * cellSize;
+        float y = (cell / width) * cellSize;
+        // image rows go top down, so the top of the quad is the top of the tile
+        Vertex bottomLeft  = { Vec2(x, y),                             Tex2F(tex.getMinX(), tex.getMaxY()) };
+        Vertex bottomRight = { Vec2(x + size.width, y),                Tex2F(tex.getMaxX(), tex.getMaxY()) };
+        Vertex topLeft     = { Vec2(x, y + size.height),               Tex2F(tex.getMinX(), tex.getMinY()) };
+        Vertex topRight    = { Vec2(x + size.width, y + size.height),  Tex2F(tex.getMaxX(), tex.getMinY()) };
+        quad[0] = bottomLeft;
+        quad[1] = bottomRight;
+        quad[2] = topLeft;
+        quad[3] = topRight;
+        quad[4] = topLeft;
+        quad[5] = bottomRight;
+    }
+    if (!dirtyAll) {
+        if (dirtyCells.size() < MAX_PARTIAL_UPLOADS) {
+            dirtyCells.push_back(cell);
+        } else {
+            dirtyAll = true;
+        }
+    }
+}
+
+void GridRenderer::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    customCommand.init(_globalZOrder, transform, flags);
+    customCommand.func = CC_CALLBACK_0(GridRenderer::onDraw, this, transform, flags);
+    renderer->addCommand(&customCommand);
+}
+
+void GridRenderer::onDraw(const Mat4 &transform, uint32_t flags)
+{
+    auto glProgram = getGLProgram();
+    glProgram->use();
+    glProgram->setUniformsForBuiltins(transform);
+
+    GL::blendFunc(BlendFunc::ALPHA_PREMULTIPLIED.src, BlendFunc::ALPHA_PREMULTIPLIED.dst);
+    GL::bindTexture2D(atlas->getName());
+
+    // attributes are set by hand below, a VAO left bound by another node would take them
+    if (Configuration::getInstance()->supportsShareableVAO()) {
+        GL::bindVAO(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (dirtyAll) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * vertices.size(), vertices.data());
+    } else {
+        for (std::uint32_t cell : dirtyCells) {
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * cell * VERTICES_PER_CELL,
+                            sizeof(Vertex) * VERTICES_PER_CELL, &vertices[cell * VERTICES_PER_CELL]);
+        }
+    }
+    dirtyCells.clear();
+    dirtyAll = false;
+
+    GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POSITION | GL::VERTEX_ATTRIB_FLAG_TEX_COORD);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, position));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, texCoords));
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, vertices.size());
+    CHECK_GL_ERROR_DEBUG();
+}
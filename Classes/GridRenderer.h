@@ -0,0 +1,74 @@
+//
+//  GridRenderer.h
+//  Snake
+//
+
+#ifndef GridRenderer_h
+#define GridRenderer_h
+
+#include <cstdint>
+#include <vector>
+#include "cocos2d.h"
+#include "Delta.h"
+#include "Util.h"
+
+/* Draws the whole board in one draw call.
+ * Every cell owns a fixed slot of 6 vertices (2 triangles) in one vertex
+ * buffer, an empty cell is a quad of zero area. applyDelta() rewrites only
+ * the slots of the cells in the delta and uploads just those, so the cost
+ * of a frame does not depend on the length of the snake: no node per cell
+ * to visit, one CustomCommand per frame.
+ *
+ * The tiles (Food.png, Snake.png, SnakeHead.png) are packed into one
+ * texture at init, each tile is drawn at its own size from the corner of
+ * its cell, as the sprites were. */
+class GridRenderer : public cocos2d::Node
+{
+public:
+    // width * height cells, cellSize points apart
+    static GridRenderer* create(std::size_t width, std::size_t height, float cellSize);
+
+    // same order and meaning as the delta of the model
+    void applyDelta(Util::DeltaView delta);
+    // empty every cell
+    void clearCells();
+
+    virtual void draw(cocos2d::Renderer *renderer, const cocos2d::Mat4 &transform, uint32_t flags) override;
+
+CC_CONSTRUCTOR_ACCESS:
+    GridRenderer();
+    virtual ~GridRenderer();
+    bool init(std::size_t width, std::size_t height, float cellSize);
+
+private:
+    struct Vertex {
+        cocos2d::Vec2 position;
+        cocos2d::Tex2F texCoords;
+    };
+    static constexpr std::size_t VERTICES_PER_CELL = 6;
+    // past this many dirty cells, the whole buffer is uploaded at once
+    static constexpr std::size_t MAX_PARTIAL_UPLOADS = 64;
+
+    std::size_t width;
+    std::size_t height;
+    float cellSize;
+    // texture rectangle and size in points of each NodeType, UNINIT unused
+    cocos2d::Rect tileTexCoords[Util::NodeType::UNINIT];
+    cocos2d::Size tileSizes[Util::NodeType::UNINIT];
+
+    cocos2d::Texture2D *atlas;
+    cocos2d::CustomCommand customCommand;
+    GLuint vbo;
+    // copy of the vertex buffer, VERTICES_PER_CELL per cell, by cell index
+    std::vector<Vertex> vertices;
+    // cells changed since the last upload
+    std::vector<std::uint32_t> dirtyCells;
+    bool dirtyAll;
+
+    bool createAtlas();
+    void createBuffer();
+    void setCell(std::uint32_t cell, Util::NodeType type);
+    void onDraw(const cocos2d::Mat4 &transform, uint32_t flags);
+};
+
+#endif /* GridRenderer_h */
@@ -0,0 +1,70 @@
+#include "HamiltonianCycle.h"
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace Snake {
+
+    namespace {
+        using Key = std::pair<std::size_t, std::size_t>;
+
+        std::mutex cacheMutex;
+        std::map<Key, std::shared_ptr<const HamiltonianCycle>> cache;
+    }
+
+    HamiltonianCycle::HamiltonianCycle(std::size_t width, std::size_t height)
+    : width(width), height(height), position(width * height), cells(width * height) {
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+        if (0 != width % 2 && 0 != height % 2) {
+            throw Util::Exception("No Hamiltonian cycle on a board of odd width and height");
+        }
+
+        // rows when the height is even, columns otherwise: lanes of
+        // length cross, lanes stacked along the other side
+        bool rows = 0 == height % 2;
+        std::size_t lanes = rows ? height : width;
+        std::size_t across = rows ? width : height;
+        auto toCell = [&](std::size_t lane, std::size_t offset) {
+            return static_cast<Cell>(rows ? lane * width + offset : offset * width + lane);
+        };
+
+        std::size_t index = 0;
+        // lane by lane through offsets 1.., back and forth
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            for (std::size_t step = 1; step < across; ++step) {
+                std::size_t offset = 0 == lane % 2 ? step : across - step;
+                cells[index++] = toCell(lane, offset);
+            }
+        }
+        // then back to the first lane through offset 0
+        for (std::size_t lane = lanes; lane > 0; --lane) {
+            cells[index++] = toCell(lane - 1, 0);
+        }
+
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            position[cells[i]] = static_cast<Cell>(i);
+        }
+    }
+
+    std::shared_ptr<const HamiltonianCycle> HamiltonianCycle::get(std::size_t width, std::size_t height) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::shared_ptr<const HamiltonianCycle> &cycle = cache[Key(width, height)];
+        if (!cycle) {
+            try {
+                cycle = std::make_shared<const HamiltonianCycle>(width, height);
+            } catch (...) {
+                cache.erase(Key(width, height));
+                throw;
+            }
+        }
+        return cycle;
+    }
+
+    void HamiltonianCycle::clearCache() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.clear();
+    }
+
+} // end namespace Snake
@@ -0,0 +1,64 @@
+#ifndef HamiltonianCycle_h
+#define HamiltonianCycle_h
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Util.h"
+
+namespace Snake {
+
+    /* A closed path through every cell of the board, one step each.
+     * It exists when the width or the height is even:
+     *
+     *     height even                 width even, height odd
+     *     0 > > > > v                 the same, transposed
+     *     ^ v < < < <
+     *     ^ > > > > v                 rows snake through the columns 1..,
+     *     ^ < < < < <                 column 0 is the way back
+     *
+     * Stored as position[cell] (index on the cycle) and its inverse
+     * cells[index], so the successor of a cell and the distance between
+     * two cells along the cycle are both one lookup.
+     * Immutable once built, get() shares one per board size */
+    class HamiltonianCycle {
+    public:
+        using Cell = std::uint32_t;
+
+        // throws if both sizes are odd or the board is smaller than 2*2
+        HamiltonianCycle(std::size_t width, std::size_t height);
+
+        /* the cycle of that size, built at the first call only, then kept
+         * for the next games. Thread safe */
+        static std::shared_ptr<const HamiltonianCycle> get(std::size_t width, std::size_t height);
+        // drop the cycles kept by get(), those in use stay alive
+        static void clearCache();
+
+        inline std::size_t getWidth() const noexcept { return width; }
+        inline std::size_t getHeight() const noexcept { return height; }
+        inline std::size_t size() const noexcept { return cells.size(); }
+
+        inline Cell positionOf(Cell cell) const noexcept { return position[cell]; }
+        inline Cell cellAt(std::size_t index) const noexcept { return cells[index]; }
+        inline Cell next(Cell cell) const noexcept { return cells[(position[cell] + 1) % cells.size()]; }
+        inline Cell previous(Cell cell) const noexcept {
+            return cells[(position[cell] + cells.size() - 1) % cells.size()];
+        }
+        // steps from cell from to cell to, going along the cycle
+        inline std::size_t distance(Cell from, Cell to) const noexcept {
+            return (position[to] + cells.size() - position[from]) % cells.size();
+        }
+
+        // disable
+        HamiltonianCycle(const HamiltonianCycle&) = delete;
+        HamiltonianCycle operator=(const HamiltonianCycle&) = delete;
+    private:
+        std::size_t width;
+        std::size_t height;
+        std::vector<Cell> position;
+        std::vector<Cell> cells;
+    };
+
+} // end namespace Snake
+
+#endif /* HamiltonianCycle_h */
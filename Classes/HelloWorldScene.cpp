@@ -3,6 +3,10 @@
 
 USING_NS_CC;
 
+namespace {
+    const char* const THREADED_SIMULATION_KEY = "threadedSimulation";
+}
+
 Scene* HelloWorld::createScene()
 {
     // 'scene' is an autorelease object
@@ -64,7 +68,14 @@ bool HelloWorld::init()
     playbutton = MenuItemImage::create("PlayButtonNormal.png","PlayButtonPressed.png",CC_CALLBACK_0(HelloWorld::changeScene,this));
     playbutton ->setPosition(Point(visibleSize.width/2,visibleSize.height/2-1.5*playbutton->getContentSize().height));
     
-    menu = Menu::create(playbutton, NULL);
+    auto threadedToggle = MenuItemToggle::createWithCallback(CC_CALLBACK_1(HelloWorld::toggleThreadedSimulation, this),
+                                                             MenuItemFont::create("Simulation: scheduler"),
+                                                             MenuItemFont::create("Simulation: thread"),
+                                                             NULL);
+    threadedToggle->setSelectedIndex(UserDefault::getInstance()->getBoolForKey(THREADED_SIMULATION_KEY, false) ? 1 : 0);
+    threadedToggle->setPosition(Point(visibleSize.width/2,playbutton->getPositionY()-playbutton->getContentSize().height));
+    
+    menu = Menu::create(playbutton, threadedToggle, NULL);
     menu->setPosition(Point::ZERO);
     this->addChild(menu);
     
@@ -73,7 +84,12 @@ bool HelloWorld::init()
 
 void HelloWorld::changeScene() {
     log("change scene");
-    Director::getInstance()->replaceScene(TransitionProgressInOut::create(0.5f, GameScene::createScene()));
+    Director::getInstance()->replaceScene(TransitionProgressInOut::create(0.5f, GameScene::createScene(UserDefault::getInstance()->getBoolForKey(THREADED_SIMULATION_KEY, false))));
+}
+
+void HelloWorld::toggleThreadedSimulation(Ref* sender) {
+    auto toggle = static_cast<MenuItemToggle*>(sender);
+    UserDefault::getInstance()->setBoolForKey(THREADED_SIMULATION_KEY, 1 == toggle->getSelectedIndex());
 }
 
 void HelloWorld::menuCloseCallback(Ref* pSender)
@@ -20,6 +20,8 @@ private:
     cocos2d::MenuItemImage* playbutton;
     cocos2d::Menu* menu;
     void changeScene();
+    // the game steps the model on its own thread when on, saved in UserDefault
+    void toggleThreadedSimulation(cocos2d::Ref* sender);
 };
 
 #endif // __HELLOWORLD_SCENE_H__
@@ -0,0 +1,27 @@
+#ifndef InputQueue_h
+#define InputQueue_h
+
+#include <chrono>
+#include "SpscQueue.h"
+#include "Util.h"
+
+namespace Snake {
+
+    // a command and the time of the event it comes from
+    struct InputCommand {
+        Util::Direction direction = Util::Direction::UNDEFINED;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    /* Commands from the event handlers to the model tick.
+     * The tick takes one command per step, so two quick turns are two
+     * steps instead of the second one overwriting the first.
+     * One producer thread, one consumer thread */
+    using InputQueue = Util::SpscQueue<InputCommand>;
+
+    // commands queued ahead of the tick, further ones are dropped
+    constexpr std::size_t INPUT_QUEUE_CAPACITY = 16;
+
+} // end namespace Snake
+
+#endif /* InputQueue_h */
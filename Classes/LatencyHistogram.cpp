@@ -0,0 +1,100 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+
+namespace Util {
+
+    namespace {
+        void writeDuration(std::ostream &out, std::uint64_t nanoseconds) {
+            if (nanoseconds < 1000) {
+                out << nanoseconds << "ns";
+            } else if (nanoseconds < 1000000) {
+                out << nanoseconds / 1000.0 << "us";
+            } else {
+                out << nanoseconds / 1000000.0 << "ms";
+            }
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram() {
+        reset();
+    }
+
+    std::size_t LatencyHistogram::toBucket(std::uint64_t nanoseconds) noexcept {
+        if (nanoseconds < SUB_BUCKETS) {
+            return static_cast<std::size_t>(nanoseconds);
+        }
+        unsigned top = 0;
+        while (nanoseconds >> (top + 1)) {
+            ++top;
+        }
+        // top bit at 2^top: row top - SUB_BITS + 1, the next SUB_BITS bits pick the column
+        unsigned shift = top - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((nanoseconds >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    std::uint64_t LatencyHistogram::upperBound(std::size_t bucket) noexcept {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        unsigned shift = static_cast<unsigned>(bucket / SUB_BUCKETS - 1);
+        std::uint64_t column = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + column + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(std::uint64_t nanoseconds) noexcept {
+        buckets[toBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (nanoseconds > seen
+               && !maximum.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    void LatencyHistogram::reset() noexcept {
+        for (std::atomic<std::uint64_t> &bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t LatencyHistogram::count() const noexcept {
+        std::uint64_t total = 0;
+        for (const std::atomic<std::uint64_t> &bucket : buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::uint64_t LatencyHistogram::percentile(double fraction) const noexcept {
+        std::uint64_t total = count();
+        if (0 == total) {
+            return 0;
+        }
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(fraction * total));
+        if (rank < 1) {
+            rank = 1;
+        }
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                // the bucket may be wider than anything seen
+                std::uint64_t bound = upperBound(i);
+                return bound < max() ? bound : max();
+            }
+        }
+        return max();
+    }
+
+    void LatencyHistogram::report(std::ostream &out) const {
+        out << "count " << count();
+        const double fractions[] = { 0.5, 0.9, 0.99 };
+        const char* const names[] = { " p50 ", " p90 ", " p99 " };
+        for (std::size_t i = 0; i < 3; ++i) {
+            out << names[i];
+            writeDuration(out, percentile(fractions[i]));
+        }
+        out << " max ";
+        writeDuration(out, max());
+    }
+
+}
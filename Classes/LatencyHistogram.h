@@ -0,0 +1,55 @@
+#ifndef LatencyHistogram_h
+#define LatencyHistogram_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace Util {
+
+    /* Histogram of durations in nanoseconds for percentiles.
+     * Buckets are log-linear: 16 linear buckets per power of 2, so any
+     * value is reported within 1/16 of itself, from 1 ns up to centuries,
+     * in a fixed 8 KB. record() is a relaxed atomic increment, any thread
+     * may record while another one reads. */
+    class LatencyHistogram {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        LatencyHistogram();
+
+        void record(std::uint64_t nanoseconds) noexcept;
+        inline void record(Clock::duration duration) noexcept {
+            std::int64_t count = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            record(count > 0 ? static_cast<std::uint64_t>(count) : 0);
+        }
+        void reset() noexcept;
+
+        std::uint64_t count() const noexcept;
+        // upper bound of the bucket holding the given fraction of the values,
+        // e.g. 0.99 for the 99th percentile, 0 if nothing was recorded
+        std::uint64_t percentile(double fraction) const noexcept;
+        inline std::uint64_t max() const noexcept { return maximum.load(std::memory_order_relaxed); }
+
+        // "count 12 p50 1.2ms p90 ... max ...", one line
+        void report(std::ostream &out) const;
+
+        // disable
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram operator=(const LatencyHistogram&) = delete;
+    private:
+        static constexpr unsigned SUB_BITS = 4;
+        static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BITS;
+        static constexpr std::size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        std::atomic<std::uint64_t> buckets[BUCKETS];
+        std::atomic<std::uint64_t> maximum;
+
+        static std::size_t toBucket(std::uint64_t nanoseconds) noexcept;
+        static std::uint64_t upperBound(std::size_t bucket) noexcept;
+    };
+
+}
+
+#endif /* LatencyHistogram_h */
@@ -0,0 +1,43 @@
+#include "LoopbackTransport.h"
+
+namespace Snake {
+
+    LoopbackTransport::LoopbackTransport(GameServer &server, std::size_t latency, std::size_t dropInterval)
+    : server(server), latency(latency), dropInterval(dropInterval), now(0),
+      bytesToClients(0), bytesToServer(0), messagesToClients(0), dropped(0) {
+        server.setSend([this](ClientId client, const std::uint8_t *data, std::size_t size) {
+            bytesToClients += size;
+            ++messagesToClients;
+            if (0 != this->dropInterval && 0 == messagesToClients % this->dropInterval) {
+                ++dropped;
+                return;
+            }
+            toClients.push_back({ this->now + this->latency, client, Message(data, data + size) });
+        });
+    }
+
+    LoopbackTransport::ClientId LoopbackTransport::connect(GameClient &client) {
+        ClientId id = static_cast<ClientId>(clients.size());
+        clients.push_back(&client);
+        client.setSend([this, id](const std::uint8_t *data, std::size_t size) {
+            bytesToServer += size;
+            toServer.push_back({ this->now + this->latency, id, Message(data, data + size) });
+        });
+        return id;
+    }
+
+    void LoopbackTransport::advance() {
+        while (!toServer.empty() && toServer.front().due <= now) {
+            Packet packet = std::move(toServer.front());
+            toServer.pop_front();
+            server.receive(packet.client, packet.data.data(), packet.data.size());
+        }
+        while (!toClients.empty() && toClients.front().due <= now) {
+            Packet packet = std::move(toClients.front());
+            toClients.pop_front();
+            clients[packet.client]->receive(packet.data.data(), packet.data.size());
+        }
+        ++now;
+    }
+
+} // end namespace Snake
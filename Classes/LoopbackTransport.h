@@ -0,0 +1,63 @@
+#ifndef LoopbackTransport_h
+#define LoopbackTransport_h
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "GameClient.h"
+#include "GameServer.h"
+
+namespace Snake {
+
+    /* GameServer and its GameClients in one process, standing in for the
+     * network: a message sent before the Nth advance() is delivered by
+     * advance() N + latency, in order, and counted. Optionally, one message in dropInterval to
+     * the clients is lost, to exercise RESYNC.
+     *
+     *     LoopbackTransport loopback(server, 2);
+     *     server.join(loopback.connect(client), room);
+     *     for (;;) { server.tick(); loopback.advance(); } */
+    class LoopbackTransport {
+    public:
+        using ClientId = GameServer::ClientId;
+
+        // takes over the Send callback of server
+        LoopbackTransport(GameServer &server, std::size_t latency = 0, std::size_t dropInterval = 0);
+
+        // takes over the Send callback of client, which must outlive this
+        ClientId connect(GameClient &client);
+
+        // deliver the messages due, then one tick later
+        void advance();
+
+        inline std::uint64_t getBytesToClients() const { return bytesToClients; }
+        inline std::uint64_t getBytesToServer() const { return bytesToServer; }
+        inline std::uint64_t getMessagesToClients() const { return messagesToClients; }
+        inline std::uint64_t getDropped() const { return dropped; }
+
+        // disable
+        LoopbackTransport(const LoopbackTransport&) = delete;
+        LoopbackTransport operator=(const LoopbackTransport&) = delete;
+    private:
+        struct Packet {
+            std::uint64_t due;
+            ClientId client;
+            Message data;
+        };
+
+        GameServer &server;
+        std::vector<GameClient*> clients;
+        std::size_t latency;
+        std::size_t dropInterval;
+        std::uint64_t now;
+        std::deque<Packet> toClients;
+        std::deque<Packet> toServer;
+        std::uint64_t bytesToClients;
+        std::uint64_t bytesToServer;
+        std::uint64_t messagesToClients;
+        std::uint64_t dropped;
+    };
+
+} // end namespace Snake
+
+#endif /* LoopbackTransport_h */
@@ -0,0 +1,59 @@
+#include "MappedFile.h"
+#include <fstream>
+#include "Util.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAKE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SNAKE_HAS_MMAP 0
+#endif
+
+namespace Util {
+
+    MappedFile::MappedFile(const std::string &path) : bytes(nullptr), length(0), mapped(false) {
+#if SNAKE_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw Exception("Cannot open " + path);
+        }
+        struct stat info;
+        if (0 != ::fstat(fd, &info)) {
+            ::close(fd);
+            throw Exception("Cannot stat " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length > 0) {
+            void *address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED != address) {
+                bytes = static_cast<const std::uint8_t*>(address);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        if (mapped || 0 == length) {
+            return;
+        }
+        // mmap failed, e.g. on a pipe, read it instead
+#endif
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) {
+            throw Exception("Cannot open " + path);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+    }
+
+    MappedFile::~MappedFile() {
+#if SNAKE_HAS_MMAP
+        if (mapped) {
+            ::munmap(const_cast<std::uint8_t*>(bytes), length);
+        }
+#endif
+    }
+
+}
@@ -0,0 +1,34 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Util {
+
+    /* Read-only file mapped into memory.
+     * Uses mmap where available, otherwise reads the whole file.
+     * Throws if the file cannot be opened */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+
+        inline const std::uint8_t* data() const { return bytes; }
+        inline std::size_t size() const { return length; }
+
+        // disable
+        MappedFile(const MappedFile&) = delete;
+        MappedFile operator=(const MappedFile&) = delete;
+    private:
+        const std::uint8_t *bytes;
+        std::size_t length;
+        bool mapped;
+        // fallback storage when the file is not mapped
+        std::vector<std::uint8_t> buffer;
+    };
+
+}
+
+#endif /* MappedFile_h */
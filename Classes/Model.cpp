@@ -1,6 +1,5 @@
 #include "Model.h"
 #include <iostream>
-#include <random>
 
 namespace Snake {
     Model::GameStatus Model::update(Util::Direction command) {
@@ -8,6 +7,7 @@ namespace Snake {
         resetNodesChanged();
         resetNodesAdded();
         resetNodesRemoved();
+        changes.clear();
         
         updateDirection(command);
         
@@ -15,6 +15,7 @@ namespace Snake {
         
         Util::Node *newHead = generateSnakeHead();
         if (!isInBoard(newHead)) {
+            nodes.destroy(newHead);
             return GameStatus::LOSE;
         }
         
@@ -61,7 +62,7 @@ namespace Snake {
         // origin head has already been one part of the body
         Util::Node *oriHead = getSnakeHead();
         // make a new head
-        Util::Node *newHead = new Util::Node(0, 0, Util::NodeType::HEAD);
+        Util::Node *newHead = nodes.create(0, 0, Util::NodeType::HEAD);
         
         switch (direction) {
             case Util::LEFT:
@@ -83,7 +84,7 @@ namespace Snake {
             case Util::UNDEFINED:
                 // should never go into here :)
             default:
-                delete newHead;
+                nodes.destroy(newHead);
                 throw Util::Exception("Command not readable.");
                 break;
         }
@@ -93,6 +94,7 @@ namespace Snake {
     
     void Model::changeSnakeHeadToBody() noexcept {
         Util::Node *node = getSnakeHead();
+        recordChange(node, node->type, Util::NodeType::BODY);
         node->type = Util::NodeType::BODY;
         nodesChanged.push_back(node);
     }
@@ -107,20 +109,22 @@ namespace Snake {
     }
     
     void Model::updateFood() {
-        while (!putFood()) {}
-        nodesAdded.push_back(&food);
+        if (putFood()) {
+            nodesAdded.push_back(&food);
+            recordChange(&food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+        }
     }
     
     bool Model::putFood() {
-        static std::default_random_engine generator;
-        std::uniform_int_distribution<std::size_t> distributionH(0, height - 1);
-        std::uniform_int_distribution<std::size_t> distributionW(0, width - 1);
-        food.x = distributionW(generator);
-        food.y = distributionH(generator);
-        std::cerr << "Put food at (" << food.x << ", " << food.y << ")";
-        std::cerr << " valid ? " << (occupied.end() == occupied.find(&food)) <<
-        std::endl;
-        return occupied.end() == occupied.find(&food);
+        if (boardSize == snake.size()) {
+            return false;
+        }
+        std::size_t cell = cells.sampleClear(generator);
+        food.x = static_cast<int>(cell % width);
+        food.y = static_cast<int>(cell / width);
+        SNAKE_TRACE_DEBUG("Put food at (" << food.x << ", " << food.y << ")");
+        SNAKE_EVENT(FOOD_PUT, food.x, food.y);
+        return true;
     }
     
     Model::NodesVector Model::getNodesAdded() {
@@ -152,32 +156,38 @@ namespace Snake {
         auto ret = occupied.insert(node);
         if (ret.second) {
             // success
-            snake.push(node);
+            snake.push_back(node);
+            cells.set(toCell(node));
             if (*node == food) {
                 // if the position of the node(usually head)
                 // is the same as the position of food
                 // change the food node
                 nodesChanged.push_back(node);
+                recordChange(node, Util::NodeType::FOOD, node->type);
             } else {
                 // else adding a new node
                 nodesAdded.push_back(node);
+                recordChange(node, Util::NodeType::UNINIT, node->type);
             }
         }
         else {
             auto collision = *(ret.first);
+            recordChange(collision, collision->type, Util::NodeType::HEAD);
             collision->type = Util::NodeType::HEAD;
             nodesChanged.push_back(collision);
             // fail, destroy the node
-            delete node;
+            nodes.destroy(node);
         }
         return ret.second;
     }
     
     void Model::popNodePtr() noexcept {
         Util::Node *node = snake.front();
-        snake.pop();
+        snake.pop_front();
         occupied.erase(node);
+        cells.reset(toCell(node));
         nodesRemoved.push_back(node);
+        recordChange(node, node->type, Util::NodeType::UNINIT);
     }
     
     void Model::resetNodesAdded() noexcept {
@@ -189,7 +199,7 @@ namespace Snake {
             if (*node == food) {
                 continue;
             }
-            delete node;
+            nodes.destroy(node);
         }
         nodesRemoved.clear();
     }
@@ -198,6 +208,73 @@ namespace Snake {
         nodesChanged.clear();
     }
     
+    void Model::snapshot(Util::Snapshot &buffer) const {
+        Util::SnapshotWriter writer(buffer);
+        writer.write(Util::SNAPSHOT_MAGIC);
+        writer.write(static_cast<std::uint32_t>(width));
+        writer.write(static_cast<std::uint32_t>(height));
+        writer.write(static_cast<std::uint64_t>(foodEaten));
+        writer.write(static_cast<std::uint8_t>(direction));
+        writer.write(toCell(&food));
+        writer.write(generator.getState());
+        writer.write(static_cast<std::uint32_t>(snake.size()));
+        Util::writeBody(writer, snake.size(), [this](std::size_t index) { return toCell(snake[index]); });
+    }
+    
+    void Model::restore(const std::uint8_t *data, std::size_t size) {
+        // parse everything before touching the model
+        Util::SnapshotReader reader(data, size);
+        if (Util::SNAPSHOT_MAGIC != reader.read<std::uint32_t>()
+            || width != reader.read<std::uint32_t>()
+            || height != reader.read<std::uint32_t>()) {
+            throw Util::Exception("Snapshot does not match the board");
+        }
+        std::uint64_t eaten = reader.read<std::uint64_t>();
+        std::uint8_t heading = reader.read<std::uint8_t>();
+        std::uint32_t foodCell = reader.read<std::uint32_t>();
+        std::uint64_t state = reader.read<std::uint64_t>();
+        std::uint32_t length = reader.read<std::uint32_t>();
+        if (length < 1 || length > boardSize || foodCell >= boardSize
+            || heading >= Util::Direction::UNDEFINED) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+        // check the cells before rebuilding, so that a bad snapshot
+        // leaves the model as it was, the scratch is sized once
+        spareBody.resize(boardSize);
+        spareCells.resize(boardSize);
+        Util::readBody(reader, width, height, length, spareBody.data(), spareCells);
+        if (length < boardSize && spareCells.test(foodCell)) {
+            throw Util::Exception("Snapshot is corrupted");
+        }
+        
+        while (!snake.empty()) {
+            popNodePtr();
+        }
+        resetNodesRemoved();
+        resetNodesAdded();
+        resetNodesChanged();
+        changes.clear();
+        
+        std::swap(cells, spareCells);
+        for (std::size_t i = 0; i < length; ++i) {
+            Util::NodeType type = length - 1 == i ? Util::NodeType::HEAD : Util::NodeType::BODY;
+            Util::Node *node = nodes.create(spareBody[i] % width, spareBody[i] / width, type);
+            occupied.insert(node);
+            snake.push_back(node);
+            nodesAdded.push_back(node);
+            recordChange(node, Util::NodeType::UNINIT, type);
+        }
+        food.x = static_cast<int>(foodCell % width);
+        food.y = static_cast<int>(foodCell / width);
+        if (length < boardSize) {
+            nodesAdded.push_back(&food);
+            recordChange(&food, Util::NodeType::UNINIT, Util::NodeType::FOOD);
+        }
+        foodEaten = static_cast<std::size_t>(eaten);
+        direction = static_cast<Util::Direction>(heading);
+        generator.setState(state);
+    }
+    
     bool Model::isInBoard(Util::Node * node) noexcept {
         return 0 <= node->x && width > node->x && 0 <= node->y && height > node->y;
     }
@@ -2,9 +2,17 @@
 #define Engine_h
 
 #include <stdio.h>
-#include <queue>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include "Util.h"
+#include "Bitmap.h"
+#include "Delta.h"
+#include "NodePool.h"
+#include "Random.h"
+#include "Snapshot.h"
+#include "Trace.h"
 #include <iostream>
 
 namespace Snake {
@@ -19,8 +27,10 @@ namespace Snake {
         /**********************************************************************
          * Constructor, arguments for size of the game area                   *
          * Note: size should be greater than 2*2, otherwise throws exceptions *
+         * seed: seed of the engine placing the food, the same seed and the   *
+         * same commands always give the same game                            *
          **********************************************************************/
-        Model(std::size_t width = 2, std::size_t height = 2);
+        Model(std::size_t width = 2, std::size_t height = 2, std::uint64_t seed = 0);
         
         ~Model();
         
@@ -35,6 +45,10 @@ namespace Snake {
         // getter of the foodEaten
         inline std::size_t getFoodEaten() const { return foodEaten; }
         
+        // changes of the last update as one list, without copying,
+        // see Delta.h. Valid until the next update / restore
+        inline Util::DeltaView getDelta() const { return Util::DeltaView(changes); }
+        
         // after calling update(), should call these
         // two functionsto get lists of nodes changed
         // Note, the nodes returned are copies of the original one
@@ -42,6 +56,19 @@ namespace Snake {
         NodesVector getNodesRemoved();
         NodesVector getNodesChanged();
         
+        /* save the full state of the game into buffer, see Snapshot.h,
+         * the buffer is reused, no allocation once it is large enough */
+        void snapshot(Util::Snapshot &buffer) const;
+        /* load a state saved by snapshot() of a game of the same size,
+         * throws if the data does not match, the model is unchanged then.
+         * After restoring, getNodesAdded() returns every node of the board,
+         * as after construction */
+        void restore(const std::uint8_t *data, std::size_t size);
+        inline void restore(const Util::Snapshot &buffer) { restore(buffer.data(), buffer.size()); }
+        
+        // the nodes of the snake, count and high-water mark, see NodePool.h
+        inline const Util::NodePool& getNodePool() const { return nodes; }
+        
         // disable
         Model(const Model&) = delete;
         Model operator=(const Model&) = delete;
@@ -49,6 +76,10 @@ namespace Snake {
         Model operator=(Model&&) = delete;
     private:
         using NodePtrsVector = std::vector<Util::Node*>;
+        // nodes per page of the pool, the whole snake on small boards
+        static constexpr std::size_t NODE_PAGE_SIZE = 256;
+        // every Node of the snake, first so that it goes last
+        Util::NodePool nodes;
         // board size
         std::size_t height;
         std::size_t width;
@@ -58,17 +89,27 @@ namespace Snake {
         /* snake body
          * head of the queue is the tail of the snake
          * tail of the queue is the head of the snake */
-        std::queue<Util::Node*> snake;
+        std::deque<Util::Node*> snake;
         // food position
         Util::Node food;
         // hashset, std::unordered_set<Node*, Hash, Equal>
         Util::Hashset occupied;
+        // one bit per cell occupied by the snake, index = y * width + x,
+        // the food is sampled from it
+        Util::Bitmap cells;
+        // engine placing the food, owned by this model only
+        Util::Random generator;
         // direction the snake heading to
         Util::Direction direction;
         // nodes changed
         NodePtrsVector nodesAdded;
         NodePtrsVector nodesRemoved;
         NodePtrsVector nodesChanged;
+        // the same changes as one list of cells, reused every frame
+        Util::CellChangesVector changes;
+        // scratch of restore(), cells of the body and their bitmap
+        std::vector<std::uint32_t> spareBody;
+        Util::Bitmap spareCells;
         
         /************************ Utility Functions *********************/
         
@@ -86,8 +127,8 @@ namespace Snake {
         Util::Node* generateSnakeHead();
         void changeSnakeHeadToBody() noexcept;
         void moveSnakeTail();
-        // put food at arbitary place,
-        // if success return true, otherwise false
+        // put food at a random free place in one draw, see Bitmap::sampleClear,
+        // return false only if there is no free place
         bool putFood();
         
         Util::Node* getSnakeHead();
@@ -105,12 +146,21 @@ namespace Snake {
         // call before each frame
         void resetNodesRemoved() noexcept;
         void resetNodesChanged() noexcept;
+        inline void recordChange(const Util::Node *node, Util::NodeType from, Util::NodeType to) {
+            changes.push_back({ toCell(node), from, to });
+        }
         
         bool isInBoard(Util::Node *node) noexcept;
+        // index of the node in cells
+        inline std::uint32_t toCell(const Util::Node *node) const noexcept {
+            return static_cast<std::uint32_t>(node->y * width + node->x);
+        }
     };
     
-    inline Model::Model(std::size_t width, std::size_t height)
-    : height(height), width(width), boardSize(height * width), foodEaten(0) {
+    inline Model::Model(std::size_t width, std::size_t height, std::uint64_t seed)
+    : nodes(std::min<std::size_t>(height * width + 1, NODE_PAGE_SIZE)),
+      height(height), width(width), boardSize(height * width), foodEaten(0),
+      cells(height * width), generator(seed) {
         // check the board size, should be greater than 2*2
         if (height < 2 || width < 2) {
             throw Util::Exception("Board is too small, 2*2 at least");
@@ -118,13 +168,14 @@ namespace Snake {
         
         // usually, only two nodes would be added each frame
         nodesAdded.reserve(3);
+        changes.reserve(4);
         
         // put snake
-        Util::Node *head = new Util::Node(width / 2, height / 2, Util::NodeType::HEAD);
-        Util::Node *body = new Util::Node(width / 2 - 1, height / 2, Util::NodeType::BODY);
+        Util::Node *head = nodes.create(width / 2, height / 2, Util::NodeType::HEAD);
+        Util::Node *body = nodes.create(width / 2 - 1, height / 2, Util::NodeType::BODY);
         
-        std::cerr << head->x << "," << head->y << std::endl;
-        std::cerr << body->x << "," << body->y << std::endl;
+        SNAKE_TRACE_DEBUG("Snake " << *head << " " << *body);
+        SNAKE_EVENT(MODEL_CREATED, width, height);
         // no need to check return code because the nodes are calculated, cannot be dup
         pushNodePtr(body);
         pushNodePtr(head);
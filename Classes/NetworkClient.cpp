@@ -0,0 +1,63 @@
+//
+//  NetworkClient.cpp
+//  Snake
+//
+
+#include "NetworkClient.h"
+
+USING_NS_CC;
+using cocos2d::network::WebSocket;
+
+NetworkClient::NetworkClient(std::size_t lead)
+: client(lead), socket(nullptr), open_(false) {
+    client.setSend([this](const std::uint8_t *data, std::size_t size) {
+        // inputs before the socket is open are lost, as on a dropped link
+        if (open_) {
+            socket->send(data, static_cast<unsigned int>(size));
+        }
+    });
+}
+
+NetworkClient::~NetworkClient() {
+    close();
+}
+
+bool NetworkClient::open(const std::string &url) {
+    close();
+    socket = new (std::nothrow) WebSocket();
+    std::vector<std::string> protocols(1, Snake::MESSAGE_PROTOCOL);
+    if (nullptr == socket || !socket->init(*this, url, &protocols)) {
+        CC_SAFE_DELETE(socket);
+        return false;
+    }
+    return true;
+}
+
+void NetworkClient::close() {
+    if (nullptr != socket) {
+        // onClose() deletes it
+        socket->close();
+    }
+}
+
+void NetworkClient::onOpen(WebSocket *ws) {
+    open_ = true;
+}
+
+void NetworkClient::onMessage(WebSocket *ws, const WebSocket::Data &data) {
+    if (data.isBinary) {
+        client.receive(reinterpret_cast<const std::uint8_t*>(data.bytes), data.len);
+    }
+}
+
+void NetworkClient::onClose(WebSocket *ws) {
+    open_ = false;
+    if (socket == ws) {
+        socket = nullptr;
+    }
+    delete ws;
+}
+
+void NetworkClient::onError(WebSocket *ws, const WebSocket::ErrorCode &error) {
+    CCLOG("NetworkClient: WebSocket error %d", static_cast<int>(error));
+}
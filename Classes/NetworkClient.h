@@ -0,0 +1,49 @@
+//
+//  NetworkClient.h
+//  Snake
+//
+
+#ifndef NetworkClient_h
+#define NetworkClient_h
+
+#include <string>
+#include "network/WebSocket.h"
+#include "GameClient.h"
+
+/* GameClient over the WebSocket of the engine: binary messages of the
+ * server go to GameClient::receive(), the inputs and RESYNC of the client
+ * are sent back as binary messages. The WebSocket calls back on the cocos
+ * thread, the thread the scene reads the client on. The server is
+ * proj.headless/server.cpp, the path of the URL picks the room.
+ *
+ *     NetworkClient network(2 * latencyInTicks + 1);
+ *     network.open("ws://localhost:9000/3");
+ *     network.getClient().pushCommand(Util::Direction::UP); */
+class NetworkClient : public cocos2d::network::WebSocket::Delegate
+{
+public:
+    explicit NetworkClient(std::size_t lead = 0);
+    virtual ~NetworkClient();
+
+    bool open(const std::string &url);
+    void close();
+    inline bool isOpen() const { return open_; }
+
+    inline Snake::GameClient& getClient() { return client; }
+    inline const Snake::GameClient& getClient() const { return client; }
+
+    virtual void onOpen(cocos2d::network::WebSocket *ws) override;
+    virtual void onMessage(cocos2d::network::WebSocket *ws, const cocos2d::network::WebSocket::Data &data) override;
+    virtual void onClose(cocos2d::network::WebSocket *ws) override;
+    virtual void onError(cocos2d::network::WebSocket *ws, const cocos2d::network::WebSocket::ErrorCode &error) override;
+
+    // disable
+    NetworkClient(const NetworkClient&) = delete;
+    NetworkClient operator=(const NetworkClient&) = delete;
+private:
+    Snake::GameClient client;
+    cocos2d::network::WebSocket *socket;
+    bool open_;
+};
+
+#endif /* NetworkClient_h */
@@ -0,0 +1,131 @@
+#ifndef NodePool_h
+#define NodePool_h
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Util.h"
+#if SNAKE_COCOS_ALLOCATOR
+#include "base/allocator/CCAllocatorStrategyFixedBlock.h"
+#endif
+
+namespace Util {
+
+    /* The Nodes of one Snake::Model, from fixed-size blocks: blocks come
+     * in pages of pageSize, a destroyed node goes to a free list and is
+     * the next one created, so once the snake has been as long as it
+     * gets, a game does not allocate any more. Not thread safe, as the
+     * model.
+     *
+     * With SNAKE_COCOS_ALLOCATOR (game builds with SNAKE_COCOS_NODE_POOL,
+     * which turns on CC_ENABLE_ALLOCATOR), the blocks come from
+     * cocos2d::allocator::AllocatorStrategyFixedBlock, and each pool is
+     * listed by cocos2d::allocator::AllocatorDiagnostics (the "allocator"
+     * command of the console) under tag. Otherwise, the headless library
+     * stays free of cocos2d and the pool keeps its own free list. */
+    class NodePool {
+    public:
+        explicit NodePool(std::size_t pageSize = 64, const char *tag = "Snake::Model nodes")
+        : tag(tag), pageSize(0 == pageSize ? 1 : pageSize), count(0), highest(0),
+#if SNAKE_COCOS_ALLOCATOR
+          blocks(tag, this->pageSize) {
+            // the allocator does not expect to be destroyed without a page
+            blocks.deallocate(blocks.allocate(BLOCK_SIZE), BLOCK_SIZE);
+#else
+          freeList(nullptr) {
+#endif
+        }
+
+        inline Node* create(std::size_t x, std::size_t y, NodeType type) {
+            void *block = allocate();
+            ++count;
+            if (count > highest) {
+                highest = count;
+            }
+            return new (block) Node(x, y, type);
+        }
+
+        inline void destroy(Node *node) noexcept {
+            if (nullptr == node) {
+                return;
+            }
+            node->~Node();
+            deallocate(node);
+            --count;
+        }
+
+        // nodes alive
+        inline std::size_t getCount() const { return count; }
+        // high-water mark of getCount()
+        inline std::size_t getHighest() const { return highest; }
+        // nodes the pages hold
+        inline std::size_t getCapacity() const {
+#if SNAKE_COCOS_ALLOCATOR
+            return (highest + pageSize - 1) / pageSize * pageSize;
+#else
+            return pages.size() * pageSize;
+#endif
+        }
+        // the line of AllocatorDiagnostics, for headless builds as well
+        inline std::string diagnostics() const {
+            std::stringstream s;
+            s << tag << " initial:" << pageSize << " count:" << count << " highest:" << highest << "\n";
+            return s.str();
+        }
+
+        // disable
+        NodePool(const NodePool&) = delete;
+        NodePool operator=(const NodePool&) = delete;
+    private:
+        static constexpr std::size_t BLOCK_SIZE = sizeof(Node);
+
+        std::string tag;
+        std::size_t pageSize;
+        std::size_t count;
+        std::size_t highest;
+
+#if SNAKE_COCOS_ALLOCATOR
+        // lockless, the model is used by one thread at a time
+        cocos2d::allocator::AllocatorStrategyFixedBlock<BLOCK_SIZE, alignof(Node),
+                                                        cocos2d::allocator::lockless_semantics> blocks;
+
+        inline void* allocate() { return blocks.allocate(BLOCK_SIZE); }
+        inline void deallocate(Node *node) noexcept { blocks.deallocate(node, BLOCK_SIZE); }
+#else
+        union Block {
+            Block *next;
+            alignas(Node) unsigned char node[sizeof(Node)];
+        };
+
+        std::vector<std::unique_ptr<Block[]>> pages;
+        Block *freeList;
+
+        inline void* allocate() {
+            if (nullptr == freeList) {
+                pages.emplace_back(new Block[pageSize]);
+                Block *page = pages.back().get();
+                // handed out in address order
+                for (std::size_t i = pageSize; i > 0; --i) {
+                    page[i - 1].next = freeList;
+                    freeList = page + i - 1;
+                }
+            }
+            Block *block = freeList;
+            freeList = block->next;
+            return block->node;
+        }
+
+        inline void deallocate(Node *node) noexcept {
+            Block *block = reinterpret_cast<Block*>(node);
+            block->next = freeList;
+            freeList = block;
+        }
+#endif
+    };
+
+}
+
+#endif /* NodePool_h */
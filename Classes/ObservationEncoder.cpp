@@ -0,0 +1,355 @@
+#include "ObservationEncoder.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SNAKE_OBSERVATION_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SNAKE_OBSERVATION_NEON 1
+#endif
+
+namespace Snake {
+
+    namespace {
+
+        constexpr float SCALE = 1.0f / 255.0f;
+
+        // out[i] = in[i] / 255, 16 at a time where the CPU has vectors
+        void convert(const std::uint8_t *in, float *out, std::size_t count) {
+            std::size_t i = 0;
+#if defined(SNAKE_OBSERVATION_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 scale = _mm_set1_ps(SCALE);
+            for (; i + 16 <= count; i += 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128i low = _mm_unpacklo_epi8(bytes, zero);
+                __m128i high = _mm_unpackhi_epi8(bytes, zero);
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+                _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+                _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+            }
+#elif defined(SNAKE_OBSERVATION_NEON)
+            for (; i + 16 <= count; i += 16) {
+                uint8x16_t bytes = vld1q_u8(in + i);
+                uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+                uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+                vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(low))), SCALE));
+                vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(low))), SCALE));
+                vst1q_f32(out + i + 8, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(high))), SCALE));
+                vst1q_f32(out + i + 12, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(high))), SCALE));
+            }
+#endif
+            for (; i < count; ++i) {
+                out[i] = in[i] * SCALE;
+            }
+        }
+
+    }
+
+    ObservationEncoder::ObservationEncoder(std::size_t boardWidth, std::size_t boardHeight, const View &view)
+    : boardWidth(boardWidth), boardHeight(boardHeight), boardSize(boardWidth * boardHeight), view(view) {
+        if (boardHeight < 2 || boardWidth < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+        if (Frame::BOARD == view.frame) {
+            viewWidth = boardWidth;
+            viewHeight = boardHeight;
+        } else {
+            if (0 == view.width || 0 == view.height) {
+                throw Util::Exception("View is empty");
+            }
+            viewWidth = view.width;
+            viewHeight = view.height;
+        }
+        planeSize = viewWidth * viewHeight;
+        stamps.resize(boardSize);
+        body.resize(boardSize);
+        planes.resize(PLANES * planeSize);
+        reset();
+    }
+
+    void ObservationEncoder::reset() {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        tail = 0;
+        length = 0;
+        tailStamp = 1;
+        nextStamp = 1;
+        head = NO_CELL;
+        food = NO_CELL;
+        direction = Util::Direction::UP;
+        std::memset(planes.data(), 0, planes.size());
+        dirty.clear();
+        redraw = true;
+        writeAll = true;
+        agesDirty = false;
+    }
+
+    void ObservationEncoder::apply(Util::DeltaView delta) {
+        for (const Util::CellChange &change : delta) {
+            if (change.cell >= boardSize) {
+                throw Util::Exception("Delta is off the board");
+            }
+        }
+        for (const Util::CellChange &change : delta) {
+            Cell cell = change.cell;
+            switch (change.to) {
+                case Util::NodeType::HEAD:
+                    // BODY -> HEAD: bumped into itself, no new node
+                    if (Util::NodeType::BODY == change.from) {
+                        moveHead(cell, length > 0 ? body[(tail + length - 1) % boardSize] : NO_CELL);
+                        break;
+                    }
+                    if (cell == food) {
+                        food = NO_CELL;
+                    }
+                    pushNode(cell);
+                    moveHead(cell, length > 1 ? body[(tail + length - 2) % boardSize] : NO_CELL);
+                    break;
+                case Util::NodeType::BODY:
+                    if (Util::NodeType::UNINIT == change.from) {
+                        pushNode(cell);
+                    } else if (cell == head) {
+                        // no head until the next one, as on the board of the model
+                        head = NO_CELL;
+                    }
+                    break;
+                case Util::NodeType::FOOD:
+                    food = cell;
+                    break;
+                default:
+                    if (Util::NodeType::FOOD == change.from) {
+                        food = NO_CELL;
+                    } else if (length > 0) {
+                        popNode(cell);
+                    }
+                    break;
+            }
+            markDirty(cell);
+        }
+
+        if (Frame::BOARD != view.frame) {
+            redraw = true;
+            return;
+        }
+        for (const Util::CellChange &change : delta) {
+            drawCell(change.cell);
+        }
+    }
+
+    void ObservationEncoder::write(std::uint8_t *out) {
+        drawPending();
+        std::memcpy(out, planes.data(), planes.size());
+        dirty.clear();
+        writeAll = false;
+    }
+
+    void ObservationEncoder::write(float *out) {
+        drawPending();
+        convert(planes.data(), out, planes.size());
+        dirty.clear();
+        writeAll = false;
+    }
+
+    void ObservationEncoder::writeChanges(std::uint8_t *out) {
+        if (writeAll || Frame::BOARD != view.frame || !fewChanges()) {
+            write(out);
+            return;
+        }
+        // the WALL plane of the board stays empty
+        bool ages = agesDirty;
+        for (Cell cell : dirty) {
+            out[HEAD * planeSize + cell] = planes[HEAD * planeSize + cell];
+            out[FOOD * planeSize + cell] = planes[FOOD * planeSize + cell];
+            if (!ages) {
+                out[BODY * planeSize + cell] = planes[BODY * planeSize + cell];
+            }
+        }
+        dirty.clear();
+        if (ages) {
+            drawAges();
+            std::memcpy(out + BODY * planeSize, &planes[BODY * planeSize], planeSize);
+        }
+    }
+
+    void ObservationEncoder::writeChanges(float *out) {
+        if (writeAll || Frame::BOARD != view.frame || !fewChanges()) {
+            write(out);
+            return;
+        }
+        bool ages = agesDirty;
+        for (Cell cell : dirty) {
+            out[HEAD * planeSize + cell] = planes[HEAD * planeSize + cell] * SCALE;
+            out[FOOD * planeSize + cell] = planes[FOOD * planeSize + cell] * SCALE;
+            if (!ages) {
+                out[BODY * planeSize + cell] = planes[BODY * planeSize + cell] * SCALE;
+            }
+        }
+        dirty.clear();
+        if (ages) {
+            drawAges();
+            convert(&planes[BODY * planeSize], out + BODY * planeSize, planeSize);
+        }
+    }
+
+    void ObservationEncoder::pushNode(Cell cell) {
+        if (length == boardSize) {
+            throw Util::Exception("Delta does not follow the board");
+        }
+        body[(tail + length) % boardSize] = cell;
+        ++length;
+        stamps[cell] = nextStamp++;
+        agesDirty = view.age;
+    }
+
+    void ObservationEncoder::popNode(Cell cell) {
+        // the tail, as the delta always removes it
+        stamps[cell] = 0;
+        tail = (tail + 1) % boardSize;
+        --length;
+        ++tailStamp;
+        agesDirty = view.age;
+    }
+
+    void ObservationEncoder::moveHead(Cell cell, Cell from) {
+        if (NO_CELL != from && from != cell) {
+            if (cell == from + 1) {
+                direction = Util::Direction::RIGHT;
+            } else if (cell + 1 == from) {
+                direction = Util::Direction::LEFT;
+            } else {
+                direction = cell > from ? Util::Direction::UP : Util::Direction::DOWN;
+            }
+        }
+        head = cell;
+    }
+
+    void ObservationEncoder::markDirty(Cell cell) {
+        if (Frame::BOARD != view.frame || writeAll) {
+            return;
+        }
+        if (dirty.size() >= planeSize) {
+            // never written since long, cheaper to write it whole
+            dirty.clear();
+            writeAll = true;
+            return;
+        }
+        dirty.push_back(cell);
+    }
+
+    std::uint8_t ObservationEncoder::bodyValue(Cell cell) const {
+        std::uint32_t stamp = stamps[cell];
+        if (0 == stamp) {
+            return 0;
+        }
+        if (!view.age || 0 == length) {
+            return ONE;
+        }
+        // 1 .. length from the tail to the head
+        std::uint64_t order = stamp - tailStamp + 1;
+        return static_cast<std::uint8_t>(order * ONE / length);
+    }
+
+    void ObservationEncoder::drawAges() {
+        agesDirty = false;
+        if (0 == length) {
+            return;
+        }
+        // bodyValue() of each node, without a division per node:
+        // (index + 1) * ONE = value * length + remainder
+        std::uint8_t *ages = &planes[BODY * planeSize];
+        const std::size_t length = this->length;
+        const std::size_t step = ONE / length;
+        const std::size_t stepRemainder = ONE % length;
+        std::size_t value = 0;
+        std::size_t remainder = 0;
+        forEachNode([ages, &value, &remainder, length, step, stepRemainder](Cell cell, std::size_t) {
+            value += step;
+            remainder += stepRemainder;
+            if (remainder >= length) {
+                remainder -= length;
+                ++value;
+            }
+            ages[cell] = static_cast<std::uint8_t>(value);
+        });
+    }
+
+    void ObservationEncoder::drawPending() {
+        if (Frame::BOARD != view.frame) {
+            if (redraw) {
+                drawView();
+            }
+        } else if (agesDirty) {
+            drawAges();
+        }
+    }
+
+    bool ObservationEncoder::fewChanges() const {
+        // past that, the scattered cells cost about what write() does
+        return (dirty.size() + (agesDirty ? length : 0)) * 4 <= planeSize * 3;
+    }
+
+    void ObservationEncoder::drawCell(Cell cell) {
+        planes[HEAD * planeSize + cell] = cell == head ? ONE : 0;
+        planes[BODY * planeSize + cell] = bodyValue(cell);
+        planes[FOOD * planeSize + cell] = cell == food ? ONE : 0;
+    }
+
+    void ObservationEncoder::drawView() {
+        std::memset(planes.data(), 0, planes.size());
+        redraw = false;
+        // around the head, the last node once it is gone, or the center
+        Cell center = NO_CELL != head ? head
+                    : length > 0 ? body[(tail + length - 1) % boardSize]
+                    : static_cast<Cell>(boardHeight / 2 * boardWidth + boardWidth / 2);
+        std::ptrdiff_t headX = center % boardWidth;
+        std::ptrdiff_t headY = center / boardWidth;
+        std::ptrdiff_t centerX = viewWidth / 2;
+        std::ptrdiff_t centerY = viewHeight / 2;
+        // board steps of +x and +y of the view: +y is the heading, +x its right hand
+        std::ptrdiff_t xStepX = 1, xStepY = 0, yStepX = 0, yStepY = 1;
+        if (Frame::EGOCENTRIC == view.frame) {
+            switch (direction) {
+                case Util::Direction::RIGHT:
+                    xStepX = 0; xStepY = -1; yStepX = 1; yStepY = 0;
+                    break;
+                case Util::Direction::DOWN:
+                    xStepX = -1; xStepY = 0; yStepX = 0; yStepY = -1;
+                    break;
+                case Util::Direction::LEFT:
+                    xStepX = 0; xStepY = 1; yStepX = -1; yStepY = 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+        std::ptrdiff_t rowX = headX - centerX * xStepX - centerY * yStepX;
+        std::ptrdiff_t rowY = headY - centerX * xStepY - centerY * yStepY;
+        const std::ptrdiff_t width = boardWidth;
+        const std::ptrdiff_t height = boardHeight;
+
+        std::size_t index = 0;
+        for (std::size_t y = 0; y < viewHeight; ++y, rowX += yStepX, rowY += yStepY) {
+            std::ptrdiff_t boardX = rowX;
+            std::ptrdiff_t boardY = rowY;
+            for (std::size_t x = 0; x < viewWidth; ++x, ++index, boardX += xStepX, boardY += xStepY) {
+                if (boardX < 0 || boardY < 0 || boardX >= width || boardY >= height) {
+                    planes[WALL * planeSize + index] = ONE;
+                    continue;
+                }
+                Cell cell = static_cast<Cell>(boardY * width + boardX);
+                if (0 != stamps[cell]) {
+                    planes[BODY * planeSize + index] = bodyValue(cell);
+                }
+                if (cell == head) {
+                    planes[HEAD * planeSize + index] = ONE;
+                }
+                if (cell == food) {
+                    planes[FOOD * planeSize + index] = ONE;
+                }
+            }
+        }
+    }
+
+} // end namespace Snake
@@ -0,0 +1,173 @@
+#ifndef ObservationEncoder_h
+#define ObservationEncoder_h
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Delta.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* Feature planes of a board for learning, written straight into a
+     * buffer of the caller, channels first: PLANES planes of
+     * viewHeight rows of viewWidth, row 0 is y = 0 of the view.
+     *
+     *   HEAD   the head
+     *   BODY   every node, head included; with View::age the value grows
+     *          from the tail (1 / length) to the head (1), so the plane
+     *          tells when each cell frees up; otherwise 1
+     *   FOOD   the food
+     *   WALL   cells of the view out of the board
+     *
+     * uint8 planes hold 0..255 for 0..1, float planes 0..1.
+     *
+     * The encoder follows the board through the deltas of the model
+     * (both Model and GridModel), never by reading the model back:
+     *
+     *     ObservationEncoder encoder(width, height, view);
+     *     GridModel model(width, height, seed);
+     *     encoder.apply(model.getDelta());     // from the empty board
+     *     encoder.write(buffer);
+     *     for (;;) {
+     *         model.update(command);
+     *         encoder.apply(model.getDelta());
+     *         encoder.writeChanges(buffer);   // buffer holds the last one
+     *     }
+     *
+     * With Frame::BOARD, apply() patches the planes at the cells of the
+     * delta, and writeChanges() copies only those. The ages of the body
+     * are drawn on the next write, however many steps were applied, and
+     * written as one plane; once the changes and the body cover most of
+     * the board, writeChanges() writes it whole. CENTERED and EGOCENTRIC
+     * views move with the head, they are redrawn on write from the board
+     * kept by the encoder, at the cost of the view only. After a
+     * restore() of the model, reset() then apply() its delta, which is a
+     * board from scratch.
+     *
+     * Not thread safe, one encoder per game. */
+    class ObservationEncoder {
+    public:
+        using Cell = std::uint32_t;
+
+        enum Plane { HEAD = 0, BODY = 1, FOOD = 2, WALL = 3, PLANES = 4 };
+
+        enum class Frame {
+            // the whole board, as it is
+            BOARD,
+            // width * height around the head, the head at (width / 2, height / 2)
+            CENTERED,
+            // CENTERED, turned so that the snake heads to +y of the view
+            EGOCENTRIC
+        };
+
+        struct View {
+            Frame frame;
+            // size of CENTERED / EGOCENTRIC views, ignored for BOARD
+            std::size_t width;
+            std::size_t height;
+            // body plane as age rather than occupancy
+            bool age;
+
+            View(Frame frame = Frame::BOARD, std::size_t width = 0, std::size_t height = 0, bool age = true)
+            : frame(frame), width(width), height(height), age(age) {}
+        };
+
+        ObservationEncoder(std::size_t boardWidth, std::size_t boardHeight, const View &view = View());
+
+        // the empty board, the next apply() starts a game
+        void reset();
+        // one step, or the whole board after reset()
+        void apply(Util::DeltaView delta);
+
+        // #values of one observation, PLANES * viewWidth * viewHeight
+        inline std::size_t getSize() const { return PLANES * planeSize; }
+        inline std::size_t getViewWidth() const { return viewWidth; }
+        inline std::size_t getViewHeight() const { return viewHeight; }
+
+        // the whole observation
+        void write(std::uint8_t *out);
+        void write(float *out);
+        /* only what changed since the last write, into the buffer of that
+         * write (one buffer per encoder); the whole observation if the view
+         * moves or after reset() */
+        void writeChanges(std::uint8_t *out);
+        void writeChanges(float *out);
+
+        // none once the game is lost on a wall, as on the board of the model
+        inline Cell getHeadCell() const { return head; }
+        inline std::size_t getLength() const { return length; }
+
+        // disable
+        ObservationEncoder(const ObservationEncoder&) = delete;
+        ObservationEncoder operator=(const ObservationEncoder&) = delete;
+    private:
+        static constexpr Cell NO_CELL = ~Cell(0);
+        static constexpr std::uint8_t ONE = 255;
+
+        std::size_t boardWidth;
+        std::size_t boardHeight;
+        std::size_t boardSize;
+        View view;
+        std::size_t viewWidth;
+        std::size_t viewHeight;
+        std::size_t planeSize;
+
+        /* the board: stamps[cell] is the number of the node there, in the
+         * order they were pushed from 1, 0 if empty. The age of a node
+         * follows from its stamp and the stamp of the tail */
+        std::vector<std::uint32_t> stamps;
+        // ring buffer of the body, body[tail] is the tail
+        std::vector<Cell> body;
+        std::size_t tail;
+        std::size_t length;
+        std::uint32_t tailStamp;
+        std::uint32_t nextStamp;
+        Cell head;
+        Cell food;
+        Util::Direction direction;
+
+        // the observation, as uint8
+        std::vector<std::uint8_t> planes;
+        // view cells changed since the last write, BOARD only
+        std::vector<Cell> dirty;
+        // planes must be redrawn (moving views) / written whole (BOARD)
+        bool redraw;
+        bool writeAll;
+        // BOARD with View::age: the body moved, its ages are to draw and write
+        bool agesDirty;
+
+        void pushNode(Cell cell);
+        void popNode(Cell cell);
+        // from: the cell of the last head, for the heading
+        void moveHead(Cell cell, Cell from);
+        // BOARD: cell must be written by the next writeChanges()
+        void markDirty(Cell cell);
+
+        std::uint8_t bodyValue(Cell cell) const;
+        // fn(cell, index) from the tail to the head, no modulo
+        template <typename F>
+        void forEachNode(F fn) const {
+            std::size_t first = std::min(length, boardSize - tail);
+            for (std::size_t i = 0; i < first; ++i) {
+                fn(body[tail + i], i);
+            }
+            for (std::size_t i = first; i < length; ++i) {
+                fn(body[i - first], i);
+            }
+        }
+        // BOARD: the planes of one cell
+        void drawCell(Cell cell);
+        // BOARD: the body plane of every node
+        void drawAges();
+        // what the planes miss before a write
+        void drawPending();
+        // BOARD: the changes (and the body to age) are within 3/4 of a plane
+        bool fewChanges() const;
+        // CENTERED / EGOCENTRIC: every plane
+        void drawView();
+    };
+
+} // end namespace Snake
+
+#endif /* ObservationEncoder_h */
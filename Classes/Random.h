@@ -0,0 +1,38 @@
+#ifndef Random_h
+#define Random_h
+
+#include <cstdint>
+
+namespace Util {
+
+    /* Small seedable engine (SplitMix64) with a 64-bit state.
+     * Meets the UniformRandomBitGenerator requirements, so it works with
+     * the <random> distributions, and the state can be saved and restored
+     * as one integer. Each model owns one, nothing is shared. */
+    class Random {
+    public:
+        using result_type = std::uint64_t;
+
+        explicit Random(std::uint64_t seed = 0) : state(seed) {}
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~result_type(0); }
+
+        inline result_type operator()() noexcept {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        inline void seed(std::uint64_t seed) noexcept { state = seed; }
+        inline std::uint64_t getState() const noexcept { return state; }
+        inline void setState(std::uint64_t value) noexcept { state = value; }
+
+    private:
+        std::uint64_t state;
+    };
+
+}
+
+#endif /* Random_h */
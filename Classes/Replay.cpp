@@ -0,0 +1,172 @@
+#include "Replay.h"
+#include <cstring>
+#include <fstream>
+
+namespace Snake {
+
+    namespace {
+        constexpr std::uint32_t REPLAY_MAGIC = 0x524B4E53; // "SNKR" on little endian hosts
+        constexpr std::uint32_t REPLAY_VERSION = 3;
+
+        inline std::size_t align8(std::size_t size) {
+            return (size + 7) & ~static_cast<std::size_t>(7);
+        }
+    }
+
+    /************************ ReplayRecorder *********************/
+
+    ReplayRecorder::ReplayRecorder(std::size_t width, std::size_t height, std::uint64_t seed,
+                                   std::size_t keyframeInterval)
+    : keyframeInterval(keyframeInterval), steps(0), status(Model::GameStatus::NORMAL) {
+        std::memset(&header, 0, sizeof(header));
+        header.magic = REPLAY_MAGIC;
+        header.version = REPLAY_VERSION;
+        header.width = static_cast<std::uint32_t>(width);
+        header.height = static_cast<std::uint32_t>(height);
+        header.seed = seed;
+        header.keyframeInterval = static_cast<std::uint32_t>(keyframeInterval);
+    }
+
+    void ReplayRecorder::recordDirection(Util::Direction direction) {
+        if (0 == steps % 4) {
+            directions.push_back(0);
+        }
+        directions.back() |= static_cast<std::uint8_t>((direction & 3) << (2 * (steps % 4)));
+        ++steps;
+    }
+
+    void ReplayRecorder::addKeyframe(const Util::Snapshot &snapshot) {
+        ReplayKeyframe keyframe;
+        keyframe.step = steps;
+        // offset inside the snapshots area for now, fixed up by write()
+        keyframe.offset = snapshots.size();
+        keyframe.size = snapshot.size();
+        keyframes.push_back(keyframe);
+        snapshots.insert(snapshots.end(), snapshot.begin(), snapshot.end());
+        snapshots.resize(align8(snapshots.size()), 0);
+    }
+
+    void ReplayRecorder::write(std::vector<std::uint8_t> &out) const {
+        ReplayHeader head = header;
+        head.steps = steps;
+        head.status = status;
+        head.keyframeCount = static_cast<std::uint32_t>(keyframes.size());
+        std::size_t directionsOffset = sizeof(ReplayHeader);
+        head.keyframesOffset = align8(directionsOffset + directions.size());
+        std::size_t snapshotsOffset = static_cast<std::size_t>(head.keyframesOffset)
+                                      + keyframes.size() * sizeof(ReplayKeyframe);
+
+        out.assign(snapshotsOffset + snapshots.size(), 0);
+        std::memcpy(out.data(), &head, sizeof(head));
+        if (!directions.empty()) {
+            std::memcpy(out.data() + directionsOffset, directions.data(), directions.size());
+        }
+        for (std::size_t i = 0; i < keyframes.size(); ++i) {
+            ReplayKeyframe keyframe = keyframes[i];
+            keyframe.offset += snapshotsOffset;
+            std::memcpy(out.data() + head.keyframesOffset + i * sizeof(ReplayKeyframe), &keyframe, sizeof(keyframe));
+        }
+        if (!snapshots.empty()) {
+            std::memcpy(out.data() + snapshotsOffset, snapshots.data(), snapshots.size());
+        }
+    }
+
+    void ReplayRecorder::save(const std::string &path) const {
+        std::vector<std::uint8_t> bytes;
+        write(bytes);
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            throw Util::Exception("Cannot write replay " + path);
+        }
+    }
+
+    /************************ ReplayView *********************/
+
+    ReplayView::ReplayView(const std::uint8_t *data, std::size_t size)
+    : data(data), size(size), directions(nullptr) {
+        if (nullptr == data || size < sizeof(ReplayHeader)) {
+            throw Util::Exception("Replay is truncated");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (REPLAY_MAGIC != header.magic || REPLAY_VERSION != header.version) {
+            throw Util::Exception("Not a replay");
+        }
+        std::uint64_t directionBytes = (header.steps + 3) / 4;
+        std::uint64_t keyframeBytes = static_cast<std::uint64_t>(header.keyframeCount) * sizeof(ReplayKeyframe);
+        if (directionBytes > size - sizeof(ReplayHeader)
+            || header.keyframesOffset < sizeof(ReplayHeader) + directionBytes
+            || header.keyframesOffset > size
+            || keyframeBytes > size - header.keyframesOffset
+            || 0 == header.keyframeCount) {
+            throw Util::Exception("Replay is corrupted");
+        }
+        directions = data + sizeof(ReplayHeader);
+        // findKeyframe() needs the initial state first and the steps sorted
+        for (std::size_t i = 0; i < header.keyframeCount; ++i) {
+            ReplayKeyframe keyframe = getKeyframe(i);
+            if (keyframe.offset > size || keyframe.size > size - keyframe.offset
+                || keyframe.step > header.steps
+                || (0 == i ? 0 != keyframe.step : keyframe.step <= getKeyframe(i - 1).step)) {
+                throw Util::Exception("Replay is corrupted");
+            }
+        }
+    }
+
+    ReplayKeyframe ReplayView::getKeyframe(std::size_t index) const {
+        ReplayKeyframe keyframe;
+        std::memcpy(&keyframe, data + header.keyframesOffset + index * sizeof(ReplayKeyframe), sizeof(keyframe));
+        return keyframe;
+    }
+
+    ReplayKeyframe ReplayView::findKeyframe(std::size_t step) const {
+        // keyframes are sorted by step, binary search the last one <= step
+        std::size_t low = 0;
+        std::size_t high = header.keyframeCount;
+        while (high - low > 1) {
+            std::size_t middle = (low + high) / 2;
+            if (getKeyframe(middle).step <= step) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return getKeyframe(low);
+    }
+
+    /************************ ReplayPlayer *********************/
+
+    ReplayPlayer::ReplayPlayer(const ReplayView &replay)
+    : replay(replay), model(replay.getWidth(), replay.getHeight(), replay.getSeed()), current(0) {}
+
+    Model::GameStatus ReplayPlayer::step() {
+        if (current >= replay.getSteps()) {
+            return Model::GameStatus::UNDEFINED;
+        }
+        return model.update(replay.getDirection(current++));
+    }
+
+    void ReplayPlayer::seek(std::size_t step) {
+        if (step > replay.getSteps()) {
+            step = replay.getSteps();
+        }
+        ReplayKeyframe keyframe = replay.findKeyframe(step);
+        // going on from the current step is cheaper if no keyframe is in between
+        if (step < current || keyframe.step > current) {
+            model.restore(replay.getData() + keyframe.offset, static_cast<std::size_t>(keyframe.size));
+            current = static_cast<std::size_t>(keyframe.step);
+        }
+        while (current < step) {
+            model.update(replay.getDirection(current++));
+        }
+    }
+
+    Model::GameStatus ReplayPlayer::playToEnd() {
+        Model::GameStatus status = Model::GameStatus::UNDEFINED;
+        while (current < replay.getSteps()) {
+            status = model.update(replay.getDirection(current++));
+        }
+        return status;
+    }
+
+} // end namespace Snake
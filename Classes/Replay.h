@@ -0,0 +1,156 @@
+#ifndef Replay_h
+#define Replay_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GridModel.h"
+#include "Snapshot.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /******************************************************************************
+     * Replay file, all values with the byte order of the host:                   *
+     *                                                                            *
+     *   Header       fixed 64 bytes, see ReplayHeader                            *
+     *   directions   2 bits per step, step i in bits 2*(i%4) of byte i/4         *
+     *   keyframes    keyframeCount entries of { u64 step, u64 offset, u64 size } *
+     *   snapshots    keyframe snapshots (see Snapshot.h), 8 byte aligned         *
+     *                                                                            *
+     * A game is replayed from a model built with the same board size and seed, *
+     * fed with the recorded directions. Keyframes are snapshots taken every     *
+     * keyframeInterval steps, so seeking only replays the steps after the       *
+     * nearest one. A snapshot holds the body as 2-bit moves plus the engine     *
+     * state, 41 bytes plus a quarter of a byte per node whatever the board      *
+     * size. The layout needs no parsing, a file can be memory mapped and read   *
+     * through a ReplayView in place.                                            *
+     ******************************************************************************/
+
+    struct ReplayHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint64_t seed;
+        std::uint64_t steps;
+        std::uint32_t keyframeInterval;
+        std::uint32_t keyframeCount;
+        std::uint64_t keyframesOffset;
+        // status of the game after the last step
+        std::uint32_t status;
+        std::uint32_t reserved[3];
+    };
+
+    struct ReplayKeyframe {
+        std::uint64_t step;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    /* Collects the directions of a game step by step and writes the file.
+     * keyframeInterval = 0 means no keyframes but the initial one */
+    class ReplayRecorder {
+    public:
+        ReplayRecorder(std::size_t width, std::size_t height, std::uint64_t seed,
+                       std::size_t keyframeInterval = 1024);
+
+        /* call once after the model is built and once after each update(),
+         * model is a Model or a GridModel built with the same size and seed */
+        template <typename M>
+        void record(const M &model, Model::GameStatus status = Model::GameStatus::NORMAL) {
+            if (keyframes.empty()) {
+                // initial state
+                addKeyframe(model);
+                return;
+            }
+            recordDirection(model.getDirection());
+            this->status = status;
+            if (0 != keyframeInterval && 0 == steps % keyframeInterval) {
+                addKeyframe(model);
+            }
+        }
+
+        inline std::size_t getSteps() const { return steps; }
+
+        // the whole file
+        void write(std::vector<std::uint8_t> &out) const;
+        // throws on I/O errors
+        void save(const std::string &path) const;
+
+    private:
+        ReplayHeader header;
+        std::size_t keyframeInterval;
+        std::size_t steps;
+        Model::GameStatus status;
+        std::vector<std::uint8_t> directions;
+        std::vector<ReplayKeyframe> keyframes;
+        std::vector<std::uint8_t> snapshots;
+        Util::Snapshot scratch;
+
+        void recordDirection(Util::Direction direction);
+        template <typename M>
+        void addKeyframe(const M &model) {
+            model.snapshot(scratch);
+            addKeyframe(scratch);
+        }
+        void addKeyframe(const Util::Snapshot &snapshot);
+    };
+
+    /* Read-only view over a replay in memory, e.g. a mapped file.
+     * The header and the keyframe table are checked on construction, the
+     * first keyframe at step 0 and the steps strictly increasing, throws if
+     * they are not valid.
+     * Nothing is copied, the memory must outlive the view */
+    class ReplayView {
+    public:
+        ReplayView(const std::uint8_t *data, std::size_t size);
+
+        inline std::size_t getWidth() const { return header.width; }
+        inline std::size_t getHeight() const { return header.height; }
+        inline std::uint64_t getSeed() const { return header.seed; }
+        inline std::size_t getSteps() const { return static_cast<std::size_t>(header.steps); }
+        inline Model::GameStatus getStatus() const { return static_cast<Model::GameStatus>(header.status); }
+        inline std::size_t getKeyframeCount() const { return header.keyframeCount; }
+
+        // direction taken at step #step, 0 <= step < getSteps()
+        inline Util::Direction getDirection(std::size_t step) const {
+            return static_cast<Util::Direction>((directions[step / 4] >> (2 * (step % 4))) & 3);
+        }
+        ReplayKeyframe getKeyframe(std::size_t index) const;
+        // the last keyframe at or before step
+        ReplayKeyframe findKeyframe(std::size_t step) const;
+        inline const std::uint8_t* getData() const { return data; }
+
+    private:
+        const std::uint8_t *data;
+        std::size_t size;
+        ReplayHeader header;
+        const std::uint8_t *directions;
+    };
+
+    /* Plays a replay on a GridModel at full speed.
+     * The model can be handed to a Model through snapshot / restore */
+    class ReplayPlayer {
+    public:
+        explicit ReplayPlayer(const ReplayView &replay);
+
+        // replay the next step, UNDEFINED status once the replay is over
+        Model::GameStatus step();
+        // restore the nearest keyframe, then replay up to step
+        void seek(std::size_t step);
+        // replay all the remaining steps, return the last status
+        Model::GameStatus playToEnd();
+
+        inline std::size_t getStep() const { return current; }
+        inline const GridModel& getModel() const { return model; }
+
+    private:
+        ReplayView replay;
+        GridModel model;
+        std::size_t current;
+    };
+
+} // end namespace Snake
+
+#endif /* Replay_h */
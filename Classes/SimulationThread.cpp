@@ -0,0 +1,117 @@
+#include "SimulationThread.h"
+
+namespace Snake {
+
+    namespace {
+        std::int64_t toPeriod(double stepsPerSecond) {
+            if (!(stepsPerSecond > 0)) {
+                throw Util::Exception("Steps per second should be positive");
+            }
+            return static_cast<std::int64_t>(1e9 / stepsPerSecond);
+        }
+    }
+
+    SimulationThread::SimulationThread(std::size_t width, std::size_t height, double stepsPerSecond, std::uint64_t seed)
+    : width(width), height(height), model(width, height, seed),
+      input(INPUT_QUEUE_CAPACITY), period(toPeriod(stepsPerSecond)), running(false) {
+        current.cells.assign(width * height, Util::NodeType::UNINIT);
+        current.time = Clock::now();
+        current.direction = model.getDirection();
+        applyDelta();
+        current.previousHead = current.head;
+        publish();
+    }
+
+    SimulationThread::~SimulationThread() {
+        stop();
+    }
+
+    void SimulationThread::start() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running || thread.joinable()) {
+            return;
+        }
+        running = true;
+        thread = std::thread(&SimulationThread::run, this);
+    }
+
+    void SimulationThread::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wakeUp.notify_all();
+        if (thread.joinable() && thread.get_id() != std::this_thread::get_id()) {
+            thread.join();
+        }
+    }
+
+    void SimulationThread::setStepsPerSecond(double stepsPerSecond) {
+        period.store(toPeriod(stepsPerSecond), std::memory_order_relaxed);
+    }
+
+    float SimulationThread::getProgress(Clock::time_point now) const {
+        std::int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - getFrame().time).count();
+        std::int64_t step = period.load(std::memory_order_relaxed);
+        if (elapsed <= 0) {
+            return 0;
+        }
+        return elapsed >= step ? 1 : static_cast<float>(elapsed) / step;
+    }
+
+    void SimulationThread::run() {
+        Clock::time_point next = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            next += std::chrono::nanoseconds(period.load(std::memory_order_relaxed));
+            // returns at once when late, so missed steps are caught up
+            if (wakeUp.wait_until(lock, next, [this] { return !running; })) {
+                break;
+            }
+            lock.unlock();
+            bool over = !step();
+            lock.lock();
+            if (over) {
+                running = false;
+            }
+        }
+    }
+
+    bool SimulationThread::step() {
+        Util::Direction next = Util::Direction::UNDEFINED;
+        InputCommand command;
+        if (policy) {
+            next = policy(current);
+        } else if (input.tryPop(command)) {
+            next = command.direction;
+            inputLatency.record(Clock::now() - command.time);
+        }
+        current.status = model.update(next);
+        current.time = Clock::now();
+        current.previousHead = current.head;
+        ++current.step;
+        applyDelta();
+        publish();
+        return Model::GameStatus::NORMAL == current.status;
+    }
+
+    void SimulationThread::applyDelta() {
+        for (const Util::CellChange &change : model.getDelta()) {
+            current.cells[change.cell] = change.to;
+            if (Util::NodeType::HEAD == change.to) {
+                current.head = change.cell;
+            } else if (Util::NodeType::FOOD == change.to) {
+                current.food = change.cell;
+            }
+        }
+        current.direction = model.getDirection();
+        current.foodEaten = model.getFoodEaten();
+    }
+
+    void SimulationThread::publish() {
+        // cells keep their size, no allocation once the three slots are filled
+        frames.back() = current;
+        frames.publish();
+    }
+
+} // end namespace Snake
@@ -0,0 +1,131 @@
+#ifndef SimulationThread_h
+#define SimulationThread_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "InputQueue.h"
+#include "LatencyHistogram.h"
+#include "Model.h"
+#include "TripleBuffer.h"
+#include "Util.h"
+
+namespace Snake {
+
+    // the board after one step, immutable once published
+    struct SimulationFrame {
+        using Clock = std::chrono::steady_clock;
+
+        // #steps done, 0 for the initial board
+        std::uint64_t step = 0;
+        // when the step was done
+        Clock::time_point time;
+        Model::GameStatus status = Model::GameStatus::NORMAL;
+        Util::Direction direction = Util::Direction::RIGHT;
+        std::size_t foodEaten = 0;
+        // cells of the head after and before the step, for interpolation
+        std::uint32_t head = 0;
+        std::uint32_t previousHead = 0;
+        std::uint32_t food = 0;
+        // NodeType of every cell, y * width + x
+        std::vector<Util::NodeType> cells;
+    };
+
+    /* Runs a Model on its own thread at a fixed rate.
+     * Steps are scheduled on an absolute clock, a late step is caught up
+     * right away, so the game speed does not depend on the render loop.
+     * Every step is published as a SimulationFrame through a triple
+     * buffer: the render thread takes the latest one without locking and
+     * interpolates between previousHead and head with getProgress() */
+    class SimulationThread {
+    public:
+        using Clock = SimulationFrame::Clock;
+        // decide the command of the next step from the current board,
+        // called on the simulation thread
+        using Policy = std::function<Util::Direction(const SimulationFrame &frame)>;
+
+        /**********************************************************************
+         * width, height, seed: see Model                                     *
+         * stepsPerSecond: rate of the game, > 0, throws otherwise            *
+         * The initial board is published at once, the thread does not run   *
+         * until start()                                                      *
+         **********************************************************************/
+        SimulationThread(std::size_t width, std::size_t height, double stepsPerSecond, std::uint64_t seed = 0);
+        // stops the thread
+        ~SimulationThread();
+
+        void start();
+        // wait for the thread to end, the last frame stays readable
+        void stop();
+
+        /************************ Any thread *********************/
+
+        /* queue a command, each step takes one, see InputQueue.h.
+         * One producer thread only, time is the time of the event.
+         * Return false if the queue is full, the command is dropped then */
+        inline bool pushCommand(Util::Direction direction, Clock::time_point time = Clock::now()) {
+            InputCommand command;
+            command.direction = direction;
+            command.time = time;
+            return input.tryPush(command);
+        }
+        // from the event of a command to the step taking it
+        inline const Util::LatencyHistogram& getInputLatency() const { return inputLatency; }
+        void setStepsPerSecond(double stepsPerSecond);
+        inline double getStepSeconds() const {
+            return std::chrono::duration<double>(std::chrono::nanoseconds(period.load(std::memory_order_relaxed))).count();
+        }
+
+        // before start() only, replaces the commands, e.g. to watch an AI play
+        inline void setPolicy(const Policy &policy) { this->policy = policy; }
+
+        /************************ Render thread *********************/
+
+        // take the latest frame if a newer one was published, return true then
+        inline bool poll() { return frames.update(); }
+        // frame taken by the last poll(), valid until the next poll()
+        inline const SimulationFrame& getFrame() const { return frames.front(); }
+        // fraction of a step elapsed since the frame, in [0, 1]
+        float getProgress(Clock::time_point now) const;
+
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+
+        // disable
+        SimulationThread(const SimulationThread&) = delete;
+        SimulationThread operator=(const SimulationThread&) = delete;
+    private:
+        std::size_t width;
+        std::size_t height;
+        // only touched by the simulation thread once started
+        Model model;
+        Policy policy;
+        SimulationFrame current;
+
+        InputQueue input;
+        Util::LatencyHistogram inputLatency;
+        // nanoseconds per step
+        std::atomic<std::int64_t> period;
+        Util::TripleBuffer<SimulationFrame> frames;
+
+        std::thread thread;
+        // guards running, wakes the thread up early on stop()
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        bool running;
+
+        void run();
+        // one step of the model, return false once the game is over
+        bool step();
+        void applyDelta();
+        void publish();
+    };
+
+} // end namespace Snake
+
+#endif /* SimulationThread_h */
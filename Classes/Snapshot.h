@@ -0,0 +1,139 @@
+#ifndef Snapshot_h
+#define Snapshot_h
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Bitmap.h"
+#include "Util.h"
+
+namespace Util {
+
+    /* Flat byte buffer holding the full state of a game.
+     * Values are stored with the byte order of the host, a snapshot
+     * is meant to be restored on the same kind of machine.
+     *
+     * Layout, shared by Model and GridModel:
+     *   u32 magic, u32 width, u32 height, u64 foodEaten, u8 direction,
+     *   u32 food cell, u64 engine state, u32 length,
+     *   u32 tail cell, then length - 1 moves from the tail to the head,
+     *   a 2-bit Direction each, move i in bits 2*(i%4) of byte i/4
+     * where a cell is the u32 index y * width + x.
+     *
+     * The free cells are not saved: every model samples the food from its
+     * occupancy bitmap (sampleClearBit), so the body and the engine state
+     * are enough to go on with the same game. A snapshot is 41 bytes plus
+     * a quarter of a byte per node, whatever the board size */
+    using Snapshot = std::vector<std::uint8_t>;
+
+    constexpr std::uint32_t SNAPSHOT_MAGIC = 0x324B4E53; // "SNK2" on little endian hosts
+
+    class SnapshotWriter {
+    public:
+        // clears the buffer, keeps its capacity
+        explicit SnapshotWriter(Snapshot &buffer) : buffer(buffer) { buffer.clear(); }
+
+        template <typename T>
+        inline void write(T value) {
+            const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+        template <typename T>
+        inline void write(const T *values, std::size_t count) {
+            const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t*>(values);
+            buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+        }
+
+    private:
+        Snapshot &buffer;
+    };
+
+    class SnapshotReader {
+    public:
+        SnapshotReader(const std::uint8_t *data, std::size_t size) : data(data), size(size), offset(0) {}
+
+        // throws if the buffer is too short
+        template <typename T>
+        inline T read() {
+            T value;
+            read(&value, 1);
+            return value;
+        }
+        template <typename T>
+        inline void read(T *values, std::size_t count) {
+            if (size - offset < count * sizeof(T)) {
+                throw Exception("Snapshot is truncated");
+            }
+            std::memcpy(values, data + offset, count * sizeof(T));
+            offset += count * sizeof(T);
+        }
+    private:
+        const std::uint8_t *data;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    /* Write the body of a snapshot, cellAt(i) is node #i from the tail,
+     * consecutive nodes are neighbours on the board */
+    template <typename CellAt>
+    void writeBody(SnapshotWriter &writer, std::size_t length, CellAt cellAt) {
+        std::uint32_t from = static_cast<std::uint32_t>(cellAt(0));
+        writer.write(from);
+        std::uint8_t moves = 0;
+        for (std::size_t i = 1; i < length; ++i) {
+            std::uint32_t to = static_cast<std::uint32_t>(cellAt(i));
+            Direction move = to == from + 1 ? RIGHT : to + 1 == from ? LEFT : to > from ? UP : DOWN;
+            moves |= static_cast<std::uint8_t>(move << (2 * ((i - 1) % 4)));
+            if (0 == i % 4 || length - 1 == i) {
+                writer.write(moves);
+                moves = 0;
+            }
+            from = to;
+        }
+    }
+
+    /* Read the body written by writeBody into cells[0, length), from the
+     * tail, and set them in occupied, which should be clear. Throws if a
+     * node leaves the board or lands on another one */
+    inline void readBody(SnapshotReader &reader, std::size_t width, std::size_t height, std::size_t length,
+                         std::uint32_t *cells, Bitmap &occupied) {
+        std::uint32_t cell = reader.read<std::uint32_t>();
+        if (cell >= width * height) {
+            throw Exception("Snapshot is corrupted");
+        }
+        cells[0] = cell;
+        occupied.set(cell);
+        std::uint8_t moves = 0;
+        for (std::size_t i = 1; i < length; ++i) {
+            if (1 == i % 4) {
+                moves = reader.read<std::uint8_t>();
+            }
+            std::size_t x = cell % width;
+            std::size_t y = cell / width;
+            // unsigned arithmetic, 0 - 1 wraps and fails the bound check
+            switch ((moves >> (2 * ((i - 1) % 4))) & 3) {
+                case LEFT:
+                    --x;
+                    break;
+                case UP:
+                    ++y;
+                    break;
+                case RIGHT:
+                    ++x;
+                    break;
+                default:
+                    --y;
+                    break;
+            }
+            cell = static_cast<std::uint32_t>(y * width + x);
+            if (x >= width || y >= height || occupied.test(cell)) {
+                throw Exception("Snapshot is corrupted");
+            }
+            cells[i] = cell;
+            occupied.set(cell);
+        }
+    }
+
+}
+
+#endif /* Snapshot_h */
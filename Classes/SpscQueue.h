@@ -0,0 +1,78 @@
+#ifndef SpscQueue_h
+#define SpscQueue_h
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Util {
+
+    /* Bounded FIFO between exactly one producer thread and one consumer
+     * thread, lock-free and wait-free: a push on a full queue and a pop on
+     * an empty one fail at once. The producer only writes tail, the consumer
+     * only writes head, each on its own cache line. */
+    template <typename T>
+    class SpscQueue {
+    public:
+        // capacity is rounded up to a power of 2
+        explicit SpscQueue(std::size_t capacity = 16) : head(0), tail(0) {
+            std::size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            slots.resize(size);
+            mask = size - 1;
+        }
+
+        // producer, false if the queue is full
+        bool tryPush(const T &value) noexcept {
+            std::size_t position = tail.load(std::memory_order_relaxed);
+            if (position - head.load(std::memory_order_acquire) > mask) {
+                return false;
+            }
+            slots[position & mask] = value;
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer, false if the queue is empty
+        bool tryPop(T &value) noexcept {
+            std::size_t position = head.load(std::memory_order_relaxed);
+            if (position == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = slots[position & mask];
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer, drop everything queued so far
+        void clear() noexcept {
+            head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        inline std::size_t capacity() const noexcept { return mask + 1; }
+        // exact from either side when the other one is idle, a hint otherwise
+        inline std::size_t size() const noexcept {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        // disable
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue operator=(const SpscQueue&) = delete;
+    private:
+        static constexpr std::size_t CACHE_LINE = 64;
+
+        std::vector<T> slots;
+        std::size_t mask;
+        // padded rather than aligned, new does not honour over-alignment in C++11
+        char headPadding[CACHE_LINE];
+        std::atomic<std::size_t> head;
+        char tailPadding[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> tail;
+        char endPadding[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+    };
+
+}
+
+#endif /* SpscQueue_h */
@@ -0,0 +1,219 @@
+#include "TickCodec.h"
+
+namespace Snake {
+
+    namespace {
+        void writeHeader(MessageWriter &writer, const FrameHeader &header) {
+            writer.writeByte(static_cast<std::uint8_t>(header.type));
+            writer.writeVarint(header.tick);
+            writer.writeByte(header.status);
+            writer.writeByte(static_cast<std::uint8_t>(header.direction));
+            writer.writeVarint(header.foodEaten);
+            writer.writeVarint(header.ack);
+        }
+
+        Util::Direction readDirection(MessageReader &reader) {
+            std::uint8_t direction = reader.readByte();
+            if (direction >= Util::Direction::UNDEFINED) {
+                throw Util::Exception("Message is corrupted");
+            }
+            return static_cast<Util::Direction>(direction);
+        }
+
+        // direction of the step from cell from to the next cell to
+        std::uint8_t stepBetween(std::uint32_t from, std::uint32_t to, std::uint32_t width) {
+            if (to == from + 1) return Util::Direction::RIGHT;
+            if (to + 1 == from) return Util::Direction::LEFT;
+            if (to == from + width) return Util::Direction::UP;
+            if (to + width == from) return Util::Direction::DOWN;
+            throw Util::Exception("Body is not connected");
+        }
+    }
+
+    std::uint8_t MessageReader::readByte() {
+        if (offset >= size) {
+            throw Util::Exception("Message is truncated");
+        }
+        return data[offset++];
+    }
+
+    std::uint64_t MessageReader::readVarint() {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            std::uint8_t byte = readByte();
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (0 == (byte & 0x80)) {
+                return value;
+            }
+        }
+        throw Util::Exception("Message is corrupted");
+    }
+
+    /************************ Encoding *********************/
+
+    void encodeKeyframe(const FrameHeader &header, const Keyframe &keyframe, Message &message) {
+        MessageWriter writer(message);
+        FrameHeader keyHeader = header;
+        keyHeader.type = MessageType::KEYFRAME;
+        writeHeader(writer, keyHeader);
+        writer.writeVarint(keyframe.width);
+        writer.writeVarint(keyframe.height);
+        // + 1 so that NO_FOOD is 0
+        writer.writeVarint(static_cast<std::uint32_t>(keyframe.food + 1));
+        writer.writeVarint(keyframe.body.size());
+        if (keyframe.body.empty()) {
+            return;
+        }
+        writer.writeVarint(keyframe.body[0]);
+        std::uint8_t packed = 0;
+        for (std::size_t i = 1; i < keyframe.body.size(); ++i) {
+            std::uint8_t step = stepBetween(keyframe.body[i - 1], keyframe.body[i], keyframe.width);
+            packed |= static_cast<std::uint8_t>(step << (2 * ((i - 1) % 4)));
+            if (0 == i % 4 || keyframe.body.size() - 1 == i) {
+                writer.writeByte(packed);
+                packed = 0;
+            }
+        }
+    }
+
+    void encodeDelta(const FrameHeader &header, Util::DeltaView delta, Message &message) {
+        MessageWriter writer(message);
+        FrameHeader deltaHeader = header;
+        deltaHeader.type = MessageType::DELTA;
+        writeHeader(writer, deltaHeader);
+        writer.writeVarint(delta.size());
+        std::int64_t previous = 0;
+        for (const Util::CellChange &change : delta) {
+            writer.writeSigned(static_cast<std::int64_t>(change.cell) - previous);
+            writer.writeByte(static_cast<std::uint8_t>(change.from << 4 | change.to));
+            previous = change.cell;
+        }
+    }
+
+    void encodeInput(std::uint32_t sequence, Util::Direction direction, Message &message) {
+        MessageWriter writer(message);
+        writer.writeByte(static_cast<std::uint8_t>(MessageType::INPUT));
+        writer.writeVarint(sequence);
+        writer.writeByte(static_cast<std::uint8_t>(direction));
+    }
+
+    void encodeResync(Message &message) {
+        MessageWriter writer(message);
+        writer.writeByte(static_cast<std::uint8_t>(MessageType::RESYNC));
+    }
+
+    /************************ Decoding *********************/
+
+    MessageType peekType(const std::uint8_t *data, std::size_t size) {
+        if (0 == size || 0 == data[0] || data[0] > static_cast<std::uint8_t>(MessageType::RESYNC)) {
+            throw Util::Exception("Unknown message");
+        }
+        return static_cast<MessageType>(data[0]);
+    }
+
+    FrameHeader decodeFrame(const std::uint8_t *data, std::size_t size,
+                            Keyframe &keyframe, Util::CellChangesVector &changes) {
+        MessageReader reader(data, size);
+        FrameHeader header;
+        header.type = peekType(data, size);
+        reader.readByte();
+        if (MessageType::KEYFRAME != header.type && MessageType::DELTA != header.type) {
+            throw Util::Exception("Not a frame");
+        }
+        header.tick = reader.readVarint();
+        header.status = reader.readByte();
+        header.direction = readDirection(reader);
+        header.foodEaten = reader.readVarint();
+        header.ack = static_cast<std::uint32_t>(reader.readVarint());
+
+        if (MessageType::KEYFRAME == header.type) {
+            std::uint64_t width = reader.readVarint();
+            std::uint64_t height = reader.readVarint();
+            std::uint64_t food = reader.readVarint();
+            std::uint64_t length = reader.readVarint();
+            std::uint64_t boardSize = width * height;
+            if (width < 2 || height < 2 || width > 0xFFFF || height > 0xFFFF
+                || food > boardSize || length > boardSize) {
+                throw Util::Exception("Message is corrupted");
+            }
+            keyframe.width = static_cast<std::uint32_t>(width);
+            keyframe.height = static_cast<std::uint32_t>(height);
+            keyframe.food = static_cast<std::uint32_t>(food) - 1;
+            keyframe.body.resize(static_cast<std::size_t>(length));
+            if (0 == length) {
+                return header;
+            }
+            std::uint64_t cell = reader.readVarint();
+            std::uint8_t packed = 0;
+            for (std::size_t i = 0; i < keyframe.body.size(); ++i) {
+                if (i > 0) {
+                    if (1 == i % 4) {
+                        packed = reader.readByte();
+                    }
+                    std::uint64_t x = cell % width;
+                    std::uint64_t y = cell / width;
+                    // move off the board is corrupted
+                    switch ((packed >> (2 * ((i - 1) % 4))) & 3) {
+                        case Util::Direction::LEFT:
+                            if (0 == x) throw Util::Exception("Message is corrupted");
+                            --cell;
+                            break;
+                        case Util::Direction::RIGHT:
+                            if (width - 1 == x) throw Util::Exception("Message is corrupted");
+                            ++cell;
+                            break;
+                        case Util::Direction::UP:
+                            if (height - 1 == y) throw Util::Exception("Message is corrupted");
+                            cell += width;
+                            break;
+                        default:
+                            if (0 == y) throw Util::Exception("Message is corrupted");
+                            cell -= width;
+                            break;
+                    }
+                }
+                if (cell >= boardSize) {
+                    throw Util::Exception("Message is corrupted");
+                }
+                keyframe.body[i] = static_cast<std::uint32_t>(cell);
+            }
+            return header;
+        }
+
+        std::uint64_t count = reader.readVarint();
+        // a change takes 2 bytes at least
+        if (count > size) {
+            throw Util::Exception("Message is corrupted");
+        }
+        changes.resize(static_cast<std::size_t>(count));
+        std::int64_t previous = 0;
+        for (Util::CellChange &change : changes) {
+            std::int64_t cell = previous + reader.readSigned();
+            std::uint8_t types = reader.readByte();
+            if (cell < 0 || cell > 0xFFFFFFFFLL || (types >> 4) > Util::NodeType::UNINIT
+                || (types & 0xF) > Util::NodeType::UNINIT) {
+                throw Util::Exception("Message is corrupted");
+            }
+            change.cell = static_cast<std::uint32_t>(cell);
+            change.from = static_cast<Util::NodeType>(types >> 4);
+            change.to = static_cast<Util::NodeType>(types & 0xF);
+            previous = cell;
+        }
+        return header;
+    }
+
+    void decodeInput(const std::uint8_t *data, std::size_t size, std::uint32_t &sequence, Util::Direction &direction) {
+        MessageReader reader(data, size);
+        if (MessageType::INPUT != peekType(data, size)) {
+            throw Util::Exception("Not an input");
+        }
+        reader.readByte();
+        sequence = static_cast<std::uint32_t>(reader.readVarint());
+        std::uint8_t value = reader.readByte();
+        if (value > Util::Direction::UNDEFINED) {
+            throw Util::Exception("Message is corrupted");
+        }
+        direction = static_cast<Util::Direction>(value);
+    }
+
+} // end namespace Snake
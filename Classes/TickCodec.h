@@ -0,0 +1,124 @@
+#ifndef TickCodec_h
+#define TickCodec_h
+
+#include <cstdint>
+#include <vector>
+#include "Delta.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /******************************************************************************
+     * Messages between GameServer and GameClient, one binary frame each.        *
+     * Integers are varints (7 bits per byte, low bits first), so the layout     *
+     * does not depend on the byte order of either side.                          *
+     *                                                                            *
+     *   server -> client                                                         *
+     *     header     u8 type, tick, u8 status, u8 direction, foodEaten, ack      *
+     *     KEYFRAME   width, height, food, length, tail cell,                     *
+     *                length - 1 moves from the tail to the head, 2 bits each     *
+     *                (a Direction), 4 per byte, low bits first                   *
+     *     DELTA      count, then count changes of the tick, in order:            *
+     *                zigzag(cell - previous cell), u8 from << 4 | to             *
+     *   client -> server                                                         *
+     *     INPUT      u8 type, sequence, u8 direction                             *
+     *     RESYNC     u8 type, asks for a keyframe                                *
+     *                                                                            *
+     * ack is the sequence of the last input the server applied, so the client   *
+     * knows which of its predicted inputs are confirmed. A delta changes the    *
+     * board of tick - 1 into the board of tick; the cells of a delta are next   *
+     * to each other most of the time, so a change takes 2 or 3 bytes.           *
+     ******************************************************************************/
+
+    using Message = std::vector<std::uint8_t>;
+    
+    // WebSocket subprotocol of the messages, see proj.headless/server.cpp
+    constexpr const char *MESSAGE_PROTOCOL = "snake-tick";
+
+    enum class MessageType : std::uint8_t { KEYFRAME = 1, DELTA = 2, INPUT = 3, RESYNC = 4 };
+
+    struct FrameHeader {
+        MessageType type = MessageType::DELTA;
+        std::uint64_t tick = 0;
+        // a Model::GameStatus
+        std::uint8_t status = 0;
+        Util::Direction direction = Util::Direction::RIGHT;
+        std::uint64_t foodEaten = 0;
+        std::uint32_t ack = 0;
+    };
+
+    // the full board, enough for a client to start from
+    struct Keyframe {
+        static constexpr std::uint32_t NO_FOOD = ~std::uint32_t(0);
+
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t food = NO_FOOD;
+        // cells from the tail to the head
+        std::vector<std::uint32_t> body;
+    };
+
+    class MessageWriter {
+    public:
+        // clears the message, keeps its capacity
+        explicit MessageWriter(Message &message) : message(message) { message.clear(); }
+
+        inline void writeByte(std::uint8_t value) { message.push_back(value); }
+        inline void writeVarint(std::uint64_t value) {
+            while (value >= 0x80) {
+                message.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            message.push_back(static_cast<std::uint8_t>(value));
+        }
+        // small negative values stay short: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+        inline void writeSigned(std::int64_t value) {
+            writeVarint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+        }
+
+    private:
+        Message &message;
+    };
+
+    class MessageReader {
+    public:
+        MessageReader(const std::uint8_t *data, std::size_t size) : data(data), size(size), offset(0) {}
+
+        // all throw if the message is too short
+        std::uint8_t readByte();
+        std::uint64_t readVarint();
+        inline std::int64_t readSigned() {
+            std::uint64_t value = readVarint();
+            return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+        }
+        inline bool atEnd() const { return offset == size; }
+
+    private:
+        const std::uint8_t *data;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    /************************ Encoding *********************/
+
+    void encodeKeyframe(const FrameHeader &header, const Keyframe &keyframe, Message &message);
+    void encodeDelta(const FrameHeader &header, Util::DeltaView delta, Message &message);
+    void encodeInput(std::uint32_t sequence, Util::Direction direction, Message &message);
+    void encodeResync(Message &message);
+
+    /************************ Decoding *********************/
+
+    // throw if the message is empty or of an unknown type
+    MessageType peekType(const std::uint8_t *data, std::size_t size);
+
+    /* the frame in data, keyframe is filled for a KEYFRAME, changes for a
+     * DELTA (both reused, no allocation once large enough).
+     * Throws if the message is malformed */
+    FrameHeader decodeFrame(const std::uint8_t *data, std::size_t size,
+                            Keyframe &keyframe, Util::CellChangesVector &changes);
+    // throws if the message is not a valid INPUT
+    void decodeInput(const std::uint8_t *data, std::size_t size, std::uint32_t &sequence, Util::Direction &direction);
+
+} // end namespace Snake
+
+#endif /* TickCodec_h */
@@ -0,0 +1,103 @@
+#include "Trace.h"
+#include <iostream>
+#include <mutex>
+
+namespace Util {
+
+    namespace {
+        std::mutex traceMutex;
+
+        const char* levelName(int level) {
+            switch (level) {
+                case SNAKE_TRACE_LEVEL_ERROR:
+                    return "[error] ";
+                case SNAKE_TRACE_LEVEL_INFO:
+                    return "[info] ";
+                default:
+                    return "[debug] ";
+            }
+        }
+
+        const char* kindName(std::uint32_t kind) {
+            switch (kind) {
+                case EventLog::MODEL_CREATED:
+                    return "model created";
+                case EventLog::FOOD_PUT:
+                    return "food put";
+                default:
+                    return "user";
+            }
+        }
+    }
+
+    void traceWrite(int level, const std::string &message) {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        // std::clog is buffered, no flush per line
+        std::clog << levelName(level) << message << '\n';
+    }
+
+    EventLog::EventLog(std::size_t capacity) : next(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        slots.reset(new Slot[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            slots[i].stamp.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    EventLog& EventLog::getInstance() {
+        static EventLog instance;
+        return instance;
+    }
+
+    void EventLog::record(Kind kind, std::uint32_t a, std::uint32_t b) noexcept {
+        std::uint64_t sequence = next.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots[sequence & mask];
+        slot.stamp.store(2 * sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.kind.store(kind, std::memory_order_relaxed);
+        slot.a.store(a, std::memory_order_relaxed);
+        slot.b.store(b, std::memory_order_relaxed);
+        slot.stamp.store(2 * sequence + 2, std::memory_order_release);
+    }
+
+    std::size_t EventLog::collect(Event *out, std::size_t size) const {
+        std::uint64_t end = next.load(std::memory_order_acquire);
+        std::uint64_t begin = end > capacity() ? end - capacity() : 0;
+        std::size_t count = 0;
+        for (std::uint64_t sequence = begin; sequence < end && count < size; ++sequence) {
+            const Slot &slot = slots[sequence & mask];
+            std::uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+            if (2 * sequence + 2 != stamp) {
+                // being written, or already overwritten
+                continue;
+            }
+            Event event;
+            event.sequence = sequence;
+            event.kind = slot.kind.load(std::memory_order_relaxed);
+            event.a = slot.a.load(std::memory_order_relaxed);
+            event.b = slot.b.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (stamp != slot.stamp.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            out[count++] = event;
+        }
+        return count;
+    }
+
+    void EventLog::dump(std::ostream &out) const {
+        std::unique_ptr<Event[]> events(new Event[capacity()]);
+        std::size_t count = collect(events.get(), capacity());
+        for (std::size_t i = 0; i < count; ++i) {
+            const Event &event = events[i];
+            out << "#" << event.sequence << " " << kindName(event.kind)
+                << " " << event.a << " " << event.b << '\n';
+        }
+        out.flush();
+    }
+
+}
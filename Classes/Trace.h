@@ -0,0 +1,130 @@
+#ifndef Trace_h
+#define Trace_h
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/******************************************************************************
+ * Tracing of the model, fixed at compile time                                *
+ *                                                                            *
+ * SNAKE_TRACE_LEVEL: 0 off, 1 error, 2 info, 3 debug                         *
+ * defaults to info if COCOS2D_DEBUG is on, off otherwise.                    *
+ * A trace above the level expands to nothing, its arguments are not even     *
+ * evaluated. Arguments are streamed, e.g.                                    *
+ *     SNAKE_TRACE_DEBUG("Put food at " << x << ", " << y);                   *
+ *                                                                            *
+ * SNAKE_EVENT_LOG: if defined to 1, SNAKE_EVENT(kind, a, b) records into the *
+ * lock-free Util::EventLog, which can be dumped on demand. Otherwise it      *
+ * expands to nothing.                                                        *
+ ******************************************************************************/
+
+#define SNAKE_TRACE_LEVEL_OFF   0
+#define SNAKE_TRACE_LEVEL_ERROR 1
+#define SNAKE_TRACE_LEVEL_INFO  2
+#define SNAKE_TRACE_LEVEL_DEBUG 3
+
+#ifndef SNAKE_TRACE_LEVEL
+#if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
+#define SNAKE_TRACE_LEVEL SNAKE_TRACE_LEVEL_INFO
+#else
+#define SNAKE_TRACE_LEVEL SNAKE_TRACE_LEVEL_OFF
+#endif
+#endif
+
+#ifndef SNAKE_EVENT_LOG
+#define SNAKE_EVENT_LOG 0
+#endif
+
+#define SNAKE_TRACE_WRITE(level, message) \
+    do { \
+        std::ostringstream snakeTraceStream; \
+        snakeTraceStream << message; \
+        Util::traceWrite(level, snakeTraceStream.str()); \
+    } while (0)
+
+#if SNAKE_TRACE_LEVEL >= SNAKE_TRACE_LEVEL_ERROR
+#define SNAKE_TRACE_ERROR(message) SNAKE_TRACE_WRITE(SNAKE_TRACE_LEVEL_ERROR, message)
+#else
+#define SNAKE_TRACE_ERROR(message) do {} while (0)
+#endif
+
+#if SNAKE_TRACE_LEVEL >= SNAKE_TRACE_LEVEL_INFO
+#define SNAKE_TRACE_INFO(message) SNAKE_TRACE_WRITE(SNAKE_TRACE_LEVEL_INFO, message)
+#else
+#define SNAKE_TRACE_INFO(message) do {} while (0)
+#endif
+
+#if SNAKE_TRACE_LEVEL >= SNAKE_TRACE_LEVEL_DEBUG
+#define SNAKE_TRACE_DEBUG(message) SNAKE_TRACE_WRITE(SNAKE_TRACE_LEVEL_DEBUG, message)
+#else
+#define SNAKE_TRACE_DEBUG(message) do {} while (0)
+#endif
+
+#if SNAKE_EVENT_LOG
+#define SNAKE_EVENT(kind, a, b) \
+    Util::EventLog::getInstance().record(Util::EventLog::kind, \
+        static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(b))
+#else
+#define SNAKE_EVENT(kind, a, b) do {} while (0)
+#endif
+
+namespace Util {
+
+    // write one line to std::clog, lines from different threads do not mix
+    void traceWrite(int level, const std::string &message);
+
+    /* Fixed size ring of small events, lock-free for writers.
+     * Any thread may record, the oldest events are overwritten.
+     * Each slot is guarded by a sequence number (seqlock), so dump()
+     * skips a slot being written instead of blocking the writer. */
+    class EventLog {
+    public:
+        enum Kind : std::uint32_t { MODEL_CREATED = 0, FOOD_PUT = 1, USER = 2 };
+
+        struct Event {
+            std::uint64_t sequence;
+            std::uint32_t kind;
+            std::uint32_t a;
+            std::uint32_t b;
+        };
+
+        // capacity is rounded up to a power of 2
+        explicit EventLog(std::size_t capacity = 4096);
+
+        static EventLog& getInstance();
+
+        void record(Kind kind, std::uint32_t a, std::uint32_t b) noexcept;
+        // copy of the events still in the ring, oldest first,
+        // returns the number of events written into out, at most size
+        std::size_t collect(Event *out, std::size_t size) const;
+        // write the events still in the ring, oldest first
+        void dump(std::ostream &out) const;
+
+        inline std::size_t capacity() const { return mask + 1; }
+        // number of events recorded so far, including overwritten ones
+        inline std::uint64_t recorded() const { return next.load(std::memory_order_relaxed); }
+
+        // disable
+        EventLog(const EventLog&) = delete;
+        EventLog operator=(const EventLog&) = delete;
+    private:
+        struct Slot {
+            // 2 * sequence + 1 while writing, 2 * sequence + 2 when done
+            std::atomic<std::uint64_t> stamp;
+            std::atomic<std::uint32_t> kind;
+            std::atomic<std::uint32_t> a;
+            std::atomic<std::uint32_t> b;
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        std::size_t mask;
+        std::atomic<std::uint64_t> next;
+    };
+
+}
+
+#endif /* Trace_h */
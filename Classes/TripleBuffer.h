@@ -0,0 +1,61 @@
+#ifndef TripleBuffer_h
+#define TripleBuffer_h
+
+#include <atomic>
+#include <cstdint>
+
+namespace Util {
+
+    /* Lock-free hand-over of the latest value from one writer thread to
+     * one reader thread. Three slots: the writer fills its back slot and
+     * swaps it with the middle one, the reader swaps its front slot with
+     * the middle one when a newer value is there. Neither side ever waits
+     * or sees a slot the other side is using, values the reader was too
+     * slow to see are simply skipped. */
+    template <typename T>
+    class TripleBuffer {
+    public:
+        explicit TripleBuffer(const T &initial = T())
+        : slots{ initial, initial, initial }, middle(1), backIndex(2), frontIndex(0) {}
+
+        /************************ Writer *********************/
+
+        // slot to fill, owned by the writer until publish()
+        inline T& back() noexcept { return slots[backIndex]; }
+        // make the back slot the latest value, the writer gets a stale slot back
+        inline void publish() noexcept {
+            backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        /************************ Reader *********************/
+
+        // take the latest value if there is a newer one, return true then
+        inline bool update() noexcept {
+            if (0 == (middle.load(std::memory_order_relaxed) & FRESH)) {
+                return false;
+            }
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+        // latest value taken by update(), owned by the reader until then
+        inline const T& front() const noexcept { return slots[frontIndex]; }
+
+        // disable
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer operator=(const TripleBuffer&) = delete;
+    private:
+        static constexpr std::uint8_t INDEX_MASK = 3;
+        // set in middle when the writer published since the last update()
+        static constexpr std::uint8_t FRESH = 4;
+
+        T slots[3];
+        std::atomic<std::uint8_t> middle;
+        // only touched by the writer
+        std::uint8_t backIndex;
+        // only touched by the reader
+        std::uint8_t frontIndex;
+    };
+
+}
+
+#endif /* TripleBuffer_h */
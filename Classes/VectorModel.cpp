@@ -0,0 +1,238 @@
+#include "VectorModel.h"
+#include <limits>
+#include "BitBoard.h"
+
+namespace Snake {
+
+    VectorModel::VectorModel(std::size_t games, std::size_t width, std::size_t height, std::uint64_t seed)
+    : games(games), width(width), height(height), boardSize(width * height),
+      wordsPerGame((width * height + 63) / 64), ringCapacity(1) {
+        // check the board size, should be greater than 2*2
+        if (height < 2 || width < 2) {
+            throw Util::Exception("Board is too small, 2*2 at least");
+        }
+        if (boardSize > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+            throw Util::Exception("Board is too large");
+        }
+        while (ringCapacity < boardSize) {
+            ringCapacity *= 2;
+        }
+        ringMask = static_cast<std::uint32_t>(ringCapacity - 1);
+
+        headX.resize(games);
+        headY.resize(games);
+        direction.resize(games);
+        status.resize(games);
+        length.resize(games);
+        tail.resize(games);
+        food.resize(games);
+        foodEaten.resize(games);
+        nextX.resize(games);
+        nextY.resize(games);
+        inBoard.resize(games);
+        ate.resize(games);
+        nextCell.resize(games);
+        bodies.resize(games * ringCapacity);
+        bitmaps.resize(games * wordsPerGame);
+        clearCounts.resize(games * (wordsPerGame + 1));
+        generators.reserve(games);
+        for (std::size_t i = 0; i < games; ++i) {
+            generators.emplace_back(seed + i);
+            reset(i);
+        }
+    }
+
+    void VectorModel::step(const Util::Direction *commands) {
+        updateDirections(commands);
+        generateSnakeHeads();
+        checkBounds();
+        compareFood();
+        moveTails();
+        checkCollisions();
+        moveHeads();
+        eatFood();
+    }
+
+    void VectorModel::reset(std::size_t index) {
+        std::uint64_t *words = bitmap(index);
+        for (std::size_t i = 0; i < wordsPerGame; ++i) {
+            words[i] = 0;
+        }
+        Util::buildClearCounts(counts(index), words, wordsPerGame, boardSize);
+        tail[index] = 0;
+        length[index] = 0;
+        foodEaten[index] = 0;
+        status[index] = GameStatus::NORMAL;
+        direction[index] = Util::Direction::RIGHT;
+
+        // put snake, same place as Model
+        headX[index] = static_cast<std::int32_t>(width / 2);
+        headY[index] = static_cast<std::int32_t>(height / 2);
+        pushHead(index, getHeadCell(index) - 1);
+        pushHead(index, getHeadCell(index));
+        updateFood(index);
+    }
+
+    /************************ Kernels *********************/
+    // games is copied into a local in each kernel: byte stores may alias
+    // the member, and the loop would not be vectorized
+
+    void VectorModel::updateDirections(const Util::Direction *commands) noexcept {
+        const std::size_t count = games;
+        std::uint8_t *dir = direction.data();
+        const std::uint8_t *stat = status.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            // UNDEFINED keeps going, UP <-> DOWN, LEFT <-> RIGHT are discarded
+            unsigned command = static_cast<unsigned>(commands[i]);
+            bool take = GameStatus::NORMAL == stat[i]
+                        && command < Util::Direction::UNDEFINED
+                        && 0 != ((command ^ dir[i]) & 1);
+            dir[i] = take ? static_cast<std::uint8_t>(command) : dir[i];
+        }
+    }
+
+    void VectorModel::generateSnakeHeads() noexcept {
+        const std::size_t count = games;
+        const std::uint8_t *dir = direction.data();
+        const std::int32_t *x = headX.data();
+        const std::int32_t *y = headY.data();
+        std::int32_t *newX = nextX.data();
+        std::int32_t *newY = nextY.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            std::int32_t d = dir[i];
+            newX[i] = x[i] + (Util::Direction::RIGHT == d) - (Util::Direction::LEFT == d);
+            newY[i] = y[i] + (Util::Direction::UP == d) - (Util::Direction::DOWN == d);
+        }
+    }
+
+    void VectorModel::checkBounds() noexcept {
+        const std::size_t count = games;
+        const std::int32_t *newX = nextX.data();
+        const std::int32_t *newY = nextY.data();
+        std::uint8_t *in = inBoard.data();
+        const std::uint32_t w = static_cast<std::uint32_t>(width);
+        const std::uint32_t h = static_cast<std::uint32_t>(height);
+        for (std::size_t i = 0; i < count; ++i) {
+            // -1 wraps to a large unsigned value
+            in[i] = (static_cast<std::uint32_t>(newX[i]) < w) & (static_cast<std::uint32_t>(newY[i]) < h);
+        }
+    }
+
+    void VectorModel::compareFood() noexcept {
+        const std::size_t count = games;
+        const std::int32_t *newX = nextX.data();
+        const std::int32_t *newY = nextY.data();
+        const std::uint8_t *in = inBoard.data();
+        const std::uint32_t *f = food.data();
+        std::uint8_t *eat = ate.data();
+        Cell *next = nextCell.data();
+        const std::uint32_t w = static_cast<std::uint32_t>(width);
+        for (std::size_t i = 0; i < count; ++i) {
+            // cell 0 out of the board, so that the later kernels can index with it
+            std::uint32_t cell = static_cast<std::uint32_t>(newY[i]) * w + static_cast<std::uint32_t>(newX[i]);
+            cell = in[i] ? cell : 0;
+            next[i] = cell;
+            eat[i] = in[i] & (cell == f[i]);
+        }
+    }
+
+    void VectorModel::moveTails() noexcept {
+        const std::size_t count = games;
+        const std::size_t capacity = ringCapacity;
+        const std::size_t words = wordsPerGame;
+        const std::uint32_t mask = ringMask;
+        const std::uint8_t *stat = status.data();
+        const std::uint8_t *in = inBoard.data();
+        const std::uint8_t *eat = ate.data();
+        const Cell *body = bodies.data();
+        std::uint32_t *first = tail.data();
+        std::uint32_t *size = length.data();
+        std::uint64_t *bits = bitmaps.data();
+        std::uint32_t *trees = clearCounts.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (GameStatus::NORMAL != stat[i] || !in[i] || eat[i]) {
+                continue;
+            }
+            Cell cell = body[i * capacity + first[i]];
+            first[i] = (first[i] + 1) & mask;
+            --size[i];
+            bits[i * words + cell / 64] &= ~(std::uint64_t(1) << (cell % 64));
+            Util::addClearCount(trees + i * (words + 1), words, cell / 64, 1);
+        }
+    }
+
+    void VectorModel::checkCollisions() noexcept {
+        const std::size_t count = games;
+        const std::size_t words = wordsPerGame;
+        const std::uint8_t *in = inBoard.data();
+        const Cell *next = nextCell.data();
+        const std::uint64_t *bits = bitmaps.data();
+        std::uint8_t *stat = status.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            // the food cell is free, a game that ate does not collide
+            Cell cell = next[i];
+            bool occupied = 0 != (bits[i * words + cell / 64] & (std::uint64_t(1) << (cell % 64)));
+            bool lose = !in[i] || occupied;
+            stat[i] = lose && GameStatus::NORMAL == stat[i] ? static_cast<std::uint8_t>(GameStatus::LOSE) : stat[i];
+        }
+    }
+
+    void VectorModel::moveHeads() noexcept {
+        const std::size_t count = games;
+        const std::size_t capacity = ringCapacity;
+        const std::size_t words = wordsPerGame;
+        const std::uint32_t mask = ringMask;
+        const std::uint8_t *stat = status.data();
+        const Cell *next = nextCell.data();
+        const std::int32_t *newX = nextX.data();
+        const std::int32_t *newY = nextY.data();
+        const std::uint32_t *first = tail.data();
+        std::uint32_t *size = length.data();
+        std::int32_t *x = headX.data();
+        std::int32_t *y = headY.data();
+        Cell *body = bodies.data();
+        std::uint64_t *bits = bitmaps.data();
+        std::uint32_t *trees = clearCounts.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (GameStatus::NORMAL != stat[i]) {
+                continue;
+            }
+            // the cell is free, or the game would have lost
+            Cell cell = next[i];
+            body[i * capacity + ((first[i] + size[i]) & mask)] = cell;
+            ++size[i];
+            bits[i * words + cell / 64] |= std::uint64_t(1) << (cell % 64);
+            Util::addClearCount(trees + i * (words + 1), words, cell / 64, -1);
+            x[i] = newX[i];
+            y[i] = newY[i];
+        }
+    }
+
+    void VectorModel::eatFood() noexcept {
+        const std::size_t count = games;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (GameStatus::NORMAL != status[i] || !ate[i]) {
+                continue;
+            }
+            if (boardSize == length[i]) {
+                status[i] = GameStatus::WIN;
+                continue;
+            }
+            ++foodEaten[i];
+            updateFood(i);
+        }
+    }
+
+    void VectorModel::pushHead(std::size_t index, Cell cell) noexcept {
+        bodies[index * ringCapacity + ((tail[index] + length[index]) & ringMask)] = cell;
+        ++length[index];
+        bitmap(index)[cell / 64] |= std::uint64_t(1) << (cell % 64);
+        Util::addClearCount(counts(index), wordsPerGame, cell / 64, -1);
+    }
+
+    void VectorModel::updateFood(std::size_t index) noexcept {
+        food[index] = static_cast<std::uint32_t>(Util::sampleClearBit(bitmap(index), counts(index), wordsPerGame,
+                                                                      boardSize - length[index], generators[index]));
+    }
+
+} // end namespace Snake
@@ -0,0 +1,124 @@
+#ifndef VectorModel_h
+#define VectorModel_h
+
+#include <cstdint>
+#include <vector>
+#include "Model.h"
+#include "Random.h"
+#include "Util.h"
+
+namespace Snake {
+
+    /* K games of the same board size stored as structure of arrays.
+     * step() advances all of them in one call: direction update, head
+     * generation, bound check and food comparison are plain loops over
+     * contiguous arrays that the compiler vectorizes. Tails, collisions and
+     * heads are then each one loop over all the games, whose bitmap and
+     * ring accesses are independent, so their cache misses overlap.
+     * A game is its occupancy bitmap and body ring only, the food is sampled
+     * from the bitmap and its clear counts (sampleClearBit) as the other
+     * models do, and a reset clears a few words. Game #k plays as a GridModel seeded with seed + k.
+     * Cell index = y * width + x */
+    class VectorModel {
+    public:
+
+        using GameStatus = Model::GameStatus;
+        using Cell = std::uint32_t;
+
+        /**********************************************************************
+         * games boards of width * height, every game gets its own engine     *
+         * seeded with seed + index                                           *
+         * Note: size should be greater than 2*2, otherwise throws exceptions *
+         **********************************************************************/
+        VectorModel(std::size_t games, std::size_t width, std::size_t height, std::uint64_t seed = 0);
+
+        /* commands[k] is the command of game #k, UNDEFINED to keep going
+         * games not in NORMAL status are left as they are */
+        void step(const Util::Direction *commands);
+        // restart game #index from the initial position
+        void reset(std::size_t index);
+
+        inline std::size_t size() const { return games; }
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+
+        inline GameStatus getStatus(std::size_t index) const { return static_cast<GameStatus>(status[index]); }
+        inline Util::Direction getDirection(std::size_t index) const { return static_cast<Util::Direction>(direction[index]); }
+        inline std::size_t getFoodEaten(std::size_t index) const { return foodEaten[index]; }
+        inline std::size_t getLength(std::size_t index) const { return length[index]; }
+        inline Cell getHeadCell(std::size_t index) const { return static_cast<Cell>(headY[index] * width + headX[index]); }
+        inline Cell getFoodCell(std::size_t index) const { return food[index]; }
+        inline bool isOccupied(std::size_t index, Cell cell) const {
+            return 0 != (bitmap(index)[cell / 64] & (std::uint64_t(1) << (cell % 64)));
+        }
+
+        // the whole arrays, one entry per game
+        inline const std::uint8_t* getStatuses() const { return status.data(); }
+        inline const std::uint32_t* getFoodEatens() const { return foodEaten.data(); }
+
+        // disable
+        VectorModel(const VectorModel&) = delete;
+        VectorModel operator=(const VectorModel&) = delete;
+    private:
+        // board size
+        std::size_t games;
+        std::size_t width;
+        std::size_t height;
+        std::size_t boardSize;
+        std::size_t wordsPerGame;
+        // body rings have a power of 2 capacity, slots wrap with ringMask
+        std::size_t ringCapacity;
+        std::uint32_t ringMask;
+
+        // one entry per game
+        std::vector<std::int32_t> headX;
+        std::vector<std::int32_t> headY;
+        std::vector<std::uint8_t> direction;
+        std::vector<std::uint8_t> status;
+        std::vector<std::uint32_t> length;
+        std::vector<std::uint32_t> tail;
+        std::vector<std::uint32_t> food;
+        std::vector<std::uint32_t> foodEaten;
+
+        // scratch of step(), one entry per game
+        std::vector<std::int32_t> nextX;
+        std::vector<std::int32_t> nextY;
+        std::vector<std::uint8_t> inBoard;
+        std::vector<std::uint8_t> ate;
+        std::vector<Cell> nextCell;
+
+        // ringCapacity cells per game, body ring of game #k
+        // starts at k * ringCapacity, body[tail] is the tail
+        std::vector<Cell> bodies;
+        // wordsPerGame words per game
+        std::vector<std::uint64_t> bitmaps;
+        // wordsPerGame + 1 per game, clear bits per word of the bitmap,
+        // see buildClearCounts
+        std::vector<std::uint32_t> clearCounts;
+        std::vector<Util::Random> generators;
+
+        /************************ Kernels *********************/
+
+        void updateDirections(const Util::Direction *commands) noexcept;
+        void generateSnakeHeads() noexcept;
+        void checkBounds() noexcept;
+        void compareFood() noexcept;
+        // games moving without eating free their tail, Move Tail First!!
+        void moveTails() noexcept;
+        // out of the board or bumping into itself
+        void checkCollisions() noexcept;
+        void moveHeads() noexcept;
+        // games that ate win or get a new food
+        void eatFood() noexcept;
+
+        void pushHead(std::size_t index, Cell cell) noexcept;
+        void updateFood(std::size_t index) noexcept;
+
+        inline std::uint64_t* bitmap(std::size_t index) { return bitmaps.data() + index * wordsPerGame; }
+        inline const std::uint64_t* bitmap(std::size_t index) const { return bitmaps.data() + index * wordsPerGame; }
+        inline std::uint32_t* counts(std::size_t index) { return clearCounts.data() + index * (wordsPerGame + 1); }
+    };
+
+} // end namespace Snake
+
+#endif /* VectorModel_h */
@@ -0,0 +1,136 @@
+#include "WorkerPool.h"
+
+namespace Util {
+
+    WorkerPool::WorkerPool(std::size_t threadCount)
+    : generation(0), stop(false), pending(0) {
+        if (0 == threadCount) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (0 == threadCount) {
+            threadCount = 1;
+        }
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            queues.emplace_back(new Queue());
+        }
+        // worker 0 is the thread calling parallelFor
+        for (std::size_t i = 1; i < threadCount; ++i) {
+            threads.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wakeUp.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::parallelFor(std::size_t count, std::size_t grain, const Task &task) {
+        if (0 == count) {
+            return;
+        }
+        if (0 == grain) {
+            grain = 1;
+        }
+        std::size_t chunks = (count + grain - 1) / grain;
+        if (1 == queues.size() || 1 == chunks) {
+            // nothing to share
+            task(0, count);
+            return;
+        }
+
+        pending.store(chunks);
+        for (std::size_t i = 0; i < chunks; ++i) {
+            std::size_t begin = i * grain;
+            std::size_t end = begin + grain < count ? begin + grain : count;
+            Queue &queue = *queues[i % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.push_back({ begin, end, &task });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++generation;
+        }
+        wakeUp.notify_all();
+
+        while (runOne(0)) {}
+
+        std::exception_ptr failure;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return 0 == pending.load(); });
+            failure = error;
+            error = nullptr;
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    void WorkerPool::workerLoop(std::size_t id) {
+        std::size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [this, seen] { return stop || generation != seen; });
+                if (stop) {
+                    return;
+                }
+                seen = generation;
+            }
+            while (runOne(id)) {}
+        }
+    }
+
+    bool WorkerPool::runOne(std::size_t id) {
+        Chunk chunk;
+        if (!popOwn(id, chunk) && !steal(id, chunk)) {
+            return false;
+        }
+        try {
+            (*chunk.task)(chunk.begin, chunk.end);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        if (1 == pending.fetch_sub(1)) {
+            // last chunk, wake up the caller
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+        return true;
+    }
+
+    bool WorkerPool::popOwn(std::size_t id, Chunk &chunk) {
+        Queue &queue = *queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty()) {
+            return false;
+        }
+        chunk = queue.chunks.back();
+        queue.chunks.pop_back();
+        return true;
+    }
+
+    bool WorkerPool::steal(std::size_t id, Chunk &chunk) {
+        for (std::size_t i = 1; i < queues.size(); ++i) {
+            Queue &queue = *queues[(id + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.chunks.empty()) {
+                chunk = queue.chunks.front();
+                queue.chunks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
@@ -0,0 +1,73 @@
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util {
+
+    /* Fixed set of worker threads with work stealing.
+     * parallelFor splits a range into chunks and deals them round-robin
+     * to one deque per worker (the calling thread is worker 0).
+     * A worker pops chunks from the back of its own deque and, once it
+     * is empty, steals from the front of the others. */
+    class WorkerPool {
+    public:
+        using Task = std::function<void(std::size_t begin, std::size_t end)>;
+
+        // threads = 0 means one worker per hardware thread
+        explicit WorkerPool(std::size_t threads = 0);
+        ~WorkerPool();
+
+        // number of workers, including the calling thread
+        inline std::size_t size() const { return queues.size(); }
+
+        /* call task(begin, end) over [0, count) in chunks of at most grain,
+         * blocks until every chunk is done.
+         * If a chunk throws, the first exception is rethrown here */
+        void parallelFor(std::size_t count, std::size_t grain, const Task &task);
+
+        // disable
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool operator=(const WorkerPool&) = delete;
+    private:
+        struct Chunk {
+            std::size_t begin;
+            std::size_t end;
+            const Task *task;
+        };
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Chunk> chunks;
+        };
+
+        std::vector<std::thread> threads;
+        std::vector<std::unique_ptr<Queue>> queues;
+        // guards generation, stop and error
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        std::condition_variable done;
+        std::size_t generation;
+        bool stop;
+        std::exception_ptr error;
+        // chunks not finished yet in the current parallelFor
+        std::atomic<std::size_t> pending;
+
+        void workerLoop(std::size_t id);
+        // run one chunk from own deque or a stolen one,
+        // return false if there is nothing left to do
+        bool runOne(std::size_t id);
+        bool popOwn(std::size_t id, Chunk &chunk);
+        bool steal(std::size_t id, Chunk &chunk);
+    };
+
+}
+
+#endif /* WorkerPool_h */
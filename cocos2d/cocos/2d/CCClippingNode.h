@@ -133,6 +133,7 @@ public:
      */
     virtual void onExit() override;
     virtual void visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags) override;
+    virtual bool isVisitedOnCocosThread() const override { return true; }
     
     virtual void setCameraMask(unsigned short mask, bool applyChildren = true) override;
     
@@ -0,0 +1,172 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCInstancedSpriteBatch.h"
+#include "base/CCDirector.h"
+#include "renderer/CCTexture2D.h"
+#include "renderer/CCTextureCache.h"
+#include "renderer/CCRenderer.h"
+#include "renderer/CCGLProgramState.h"
+
+NS_CC_BEGIN
+
+InstancedSpriteBatch* InstancedSpriteBatch::createWithTexture(Texture2D* texture)
+{
+    InstancedSpriteBatch *batch = new (std::nothrow) InstancedSpriteBatch();
+    if (batch && batch->initWithTexture(texture))
+    {
+        batch->autorelease();
+        return batch;
+    }
+    CC_SAFE_DELETE(batch);
+    return nullptr;
+}
+
+InstancedSpriteBatch* InstancedSpriteBatch::create(const std::string& filename)
+{
+    InstancedSpriteBatch *batch = new (std::nothrow) InstancedSpriteBatch();
+    if (batch && batch->initWithFile(filename))
+    {
+        batch->autorelease();
+        return batch;
+    }
+    CC_SAFE_DELETE(batch);
+    return nullptr;
+}
+
+InstancedSpriteBatch::InstancedSpriteBatch()
+: _texture(nullptr)
+, _blendFunc(BlendFunc::ALPHA_PREMULTIPLIED)
+{
+}
+
+InstancedSpriteBatch::~InstancedSpriteBatch()
+{
+    CC_SAFE_RELEASE(_texture);
+}
+
+bool InstancedSpriteBatch::initWithTexture(Texture2D* texture)
+{
+    if (!texture)
+    {
+        return false;
+    }
+
+    setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_INSTANCED));
+    setTexture(texture);
+    return true;
+}
+
+bool InstancedSpriteBatch::initWithFile(const std::string& filename)
+{
+    Texture2D *texture = Director::getInstance()->getTextureCache()->addImage(filename);
+    return initWithTexture(texture);
+}
+
+ssize_t InstancedSpriteBatch::addInstance(const Rect& rect, const Vec2& position, float rotation, float scale, const Color4B& color)
+{
+    Instance instance;
+    instance.position = position;
+    instance.size.set(rect.size.width * scale, rect.size.height * scale);
+    instance.rotation = rotation;
+    instance.color = color;
+    if (_texture->hasPremultipliedAlpha())
+    {
+        instance.color.r = color.r * color.a / 255;
+        instance.color.g = color.g * color.a / 255;
+        instance.color.b = color.b * color.a / 255;
+    }
+    instance.texRect = getTexRect(rect);
+
+    _instances.push_back(instance);
+    return _instances.size() - 1;
+}
+
+void InstancedSpriteBatch::removeAllInstances()
+{
+    _instances.clear();
+}
+
+Rect InstancedSpriteBatch::getTexRect(const Rect& rect) const
+{
+    Rect rectInPixels = CC_RECT_POINTS_TO_PIXELS(rect);
+    float width = (float)_texture->getPixelsWide();
+    float height = (float)_texture->getPixelsHigh();
+    return Rect(rectInPixels.origin.x / width, rectInPixels.origin.y / height,
+                rectInPixels.size.width / width, rectInPixels.size.height / height);
+}
+
+void InstancedSpriteBatch::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    if (_instances.empty())
+    {
+        return;
+    }
+
+    _instancedCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc,
+                           _instances.data(), _instances.size(), transform, flags);
+    renderer->addCommand(&_instancedCommand);
+}
+
+void InstancedSpriteBatch::updateBlendFunc()
+{
+    if (! _texture->hasPremultipliedAlpha())
+    {
+        _blendFunc = BlendFunc::ALPHA_NON_PREMULTIPLIED;
+    }
+    else
+    {
+        _blendFunc = BlendFunc::ALPHA_PREMULTIPLIED;
+    }
+}
+
+// TextureProtocol
+void InstancedSpriteBatch::setBlendFunc(const BlendFunc &blendFunc)
+{
+    _blendFunc = blendFunc;
+}
+
+const BlendFunc& InstancedSpriteBatch::getBlendFunc() const
+{
+    return _blendFunc;
+}
+
+Texture2D* InstancedSpriteBatch::getTexture() const
+{
+    return _texture;
+}
+
+void InstancedSpriteBatch::setTexture(Texture2D *texture)
+{
+    CCASSERT(texture, "InstancedSpriteBatch needs a texture");
+    if (_texture != texture)
+    {
+        CC_SAFE_RETAIN(texture);
+        CC_SAFE_RELEASE(_texture);
+        _texture = texture;
+        updateBlendFunc();
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,161 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_INSTANCED_SPRITE_BATCH_H__
+#define __CC_INSTANCED_SPRITE_BATCH_H__
+
+#include <vector>
+
+#include "2d/CCNode.h"
+#include "base/CCProtocols.h"
+#include "renderer/CCInstancedCommand.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+class Texture2D;
+
+/** InstancedSpriteBatch draws many copies of the rects of one texture in one draw call, as a
+ * SpriteBatchNode, but its copies are not Sprites: each one is an InstancedCommand::Instance,
+ * a position, size, rotation, color and texture rect in the space of the node.
+ *
+ * Where instancing is supported, the instances are uploaded as they are and the quads are
+ * made by the GPU, so tens of thousands of them, as the bullets of a shooter, cost little CPU.
+ * Elsewhere they are expanded to quads and batched as Sprites are.
+ *
+ * Limitations:
+ *  - The color and opacity of the node do not apply to the instances, set their color instead.
+ *  - Rotated sprite frames are not supported.
+ *  - The instances are not culled.
+ *
+ * @since v3.10
+ */
+class CC_DLL InstancedSpriteBatch : public Node, public TextureProtocol
+{
+public:
+    typedef InstancedCommand::Instance Instance;
+
+    /** Creates an InstancedSpriteBatch with a texture2d.
+     *
+     * @param texture A texture2d.
+     * @return Return an autorelease object.
+     */
+    static InstancedSpriteBatch* createWithTexture(Texture2D* texture);
+
+    /** Creates an InstancedSpriteBatch with a file image (.png, .jpeg, .pvr, etc).
+     * The file will be loaded using the TextureMgr.
+     *
+     * @param filename A file image (.png, .jpeg, .pvr, etc).
+     * @return Return an autorelease object.
+     */
+    static InstancedSpriteBatch* create(const std::string& filename);
+
+    /** Adds a copy of a rect of the texture.
+     *
+     * @param rect The rect of the texture, in points, as Sprite::create(filename, rect).
+     * @param position The center of the copy.
+     * @param rotation In degrees, clockwise.
+     * @param scale Of the rect.
+     * @param color Multiplies the texture, premultiplied here if the texture is.
+     * @return The index of the instance.
+     */
+    ssize_t addInstance(const Rect& rect, const Vec2& position, float rotation = 0.0f, float scale = 1.0f, const Color4B& color = Color4B::WHITE);
+
+    /** The instance at index, to move it. */
+    Instance& getInstance(ssize_t index) { return _instances[index]; }
+
+    /** All the instances, drawn in order, to update or add them in bulk. */
+    std::vector<Instance>& getInstances() { return _instances; }
+
+    /** The number of instances. */
+    ssize_t getInstanceCount() const { return _instances.size(); }
+
+    /** Removes all the instances. */
+    void removeAllInstances();
+
+    /** Texture coordinates of rect, in points of the texture, for Instance::texRect. */
+    Rect getTexRect(const Rect& rect) const;
+
+    // TextureProtocol
+    virtual Texture2D* getTexture() const override;
+    virtual void setTexture(Texture2D *texture) override;
+    /**
+    * @code
+    * When this function bound into js or lua,the parameter will be changed
+    * In js: var setBlendFunc(var src, var dst).
+    * @endcode
+    * @lua NA
+    */
+    virtual void setBlendFunc(const BlendFunc &blendFunc) override;
+    /**
+    * @js NA
+    * @lua NA
+    */
+    virtual const BlendFunc& getBlendFunc() const override;
+
+    // Overrides
+    virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+
+CC_CONSTRUCTOR_ACCESS:
+    /**
+     * @js ctor
+     */
+    InstancedSpriteBatch();
+    /**
+     * @js NA
+     * @lua NA
+     */
+    virtual ~InstancedSpriteBatch();
+
+    /** Initializes an InstancedSpriteBatch with a texture2d.
+     */
+    bool initWithTexture(Texture2D* texture);
+
+    /** Initializes an InstancedSpriteBatch with a file image (.png, .jpeg, .pvr, etc).
+     * The file will be loaded using the TextureMgr.
+     */
+    bool initWithFile(const std::string& filename);
+
+protected:
+    void updateBlendFunc();
+
+    Texture2D* _texture;
+    BlendFunc _blendFunc;
+    std::vector<Instance> _instances;
+    InstancedCommand _instancedCommand;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(InstancedSpriteBatch);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_INSTANCED_SPRITE_BATCH_H__
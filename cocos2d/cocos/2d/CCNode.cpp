@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "base/CCScheduler.h"
 #include "base/CCEventDispatcher.h"
+#include "base/CCParallelVisit.h"
 #include "2d/CCCamera.h"
 #include "2d/CCActionManager.h"
 #include "2d/CCScene.h"
@@ -1221,7 +1222,7 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
             auto node = _children.at(i);
 
             if (node && node->_localZOrder < 0)
-                node->visit(renderer, _modelViewTransform, flags);
+                ParallelVisit::visitChild(node, renderer, _modelViewTransform, flags);
             else
                 break;
         }
@@ -1230,7 +1231,7 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
             this->draw(renderer, _modelViewTransform, flags);
 
         for(auto it=_children.cbegin()+i; it != _children.cend(); ++it)
-            (*it)->visit(renderer, _modelViewTransform, flags);
+            ParallelVisit::visitChild(*it, renderer, _modelViewTransform, flags);
     }
     else if (visibleByCamera)
     {
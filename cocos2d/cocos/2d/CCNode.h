@@ -1153,6 +1153,15 @@ public:
     virtual void visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags);
     virtual void visit() final;
 
+    /**
+     * Whether visit() must run on the cocos thread, as it pushes a render group or a PROJECTION
+     * matrix. During a parallel visit, the threads leave such a node to the cocos thread, see ParallelVisit.
+     *
+     * @return False by default.
+     * @js NA
+     */
+    virtual bool isVisitedOnCocosThread() const { return false; }
+
 
     /** Returns the Scene that contains the Node.
      It returns `nullptr` if the node doesn't belong to any Scene.
@@ -270,6 +270,7 @@ public:
     
     // Overrides
     virtual void visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags) override;
+    virtual bool isVisitedOnCocosThread() const override { return true; }
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
 
     /** Flag: Use stack matrix computed from scene hierarchy or generate new modelView and projection matrix.
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "2d/CCCamera.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventListenerCustom.h"
+#include "base/CCParallelVisit.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCFrameBuffer.h"
 #include "deprecated/CCString.h"
@@ -198,8 +199,8 @@ void Scene::render(Renderer* renderer)
         camera->apply();
         //clear background with max depth
         camera->clearBackground();
-        //visit the scene
-        visit(renderer, transform, 0);
+        //visit the scene, on several threads if the parallel visit is on
+        director->getParallelVisit()->visit(this, renderer, transform, 0);
 #if CC_USE_NAVMESH
         if (_navMesh && _navMeshDebugCamera == camera)
         {
@@ -53,6 +53,7 @@ cocos2d.cpp \
 2d/CCGLBufferedNode.cpp \
 2d/CCGrabber.cpp \
 2d/CCGrid.cpp \
+2d/CCInstancedSpriteBatch.cpp \
 2d/CCLabel.cpp \
 2d/CCLabelAtlas.cpp \
 2d/CCLabelBMFont.cpp \
@@ -134,8 +135,10 @@ base/CCEventListenerMouse.cpp \
 base/CCEventListenerTouch.cpp \
 base/CCEventMouse.cpp \
 base/CCEventTouch.cpp \
+base/CCFrameRecorder.cpp \
 base/CCIMEDispatcher.cpp \
 base/CCNS.cpp \
+base/CCParallelVisit.cpp \
 base/CCProfiling.cpp \
 base/CCProperties.cpp \
 base/CCRef.cpp \
@@ -169,6 +172,7 @@ renderer/CCGLProgramCache.cpp \
 renderer/CCGLProgramState.cpp \
 renderer/CCGLProgramStateCache.cpp \
 renderer/CCGroupCommand.cpp \
+renderer/CCInstancedCommand.cpp \
 renderer/CCMaterial.cpp \
 renderer/CCMeshCommand.cpp \
 renderer/CCPass.cpp \
@@ -178,6 +182,7 @@ renderer/CCQuadCommand.cpp \
 renderer/CCRenderCommand.cpp \
 renderer/CCRenderState.cpp \
 renderer/CCRenderer.cpp \
+renderer/CCStreamingBuffer.cpp \
 renderer/CCTechnique.cpp \
 renderer/CCTexture2D.cpp \
 renderer/CCTextureAtlas.cpp \
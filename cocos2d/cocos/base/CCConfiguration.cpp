@@ -49,6 +49,7 @@ Configuration::Configuration()
 , _supportsBGRA8888(false)
 , _supportsDiscardFramebuffer(false)
 , _supportsShareableVAO(false)
+, _supportsInstancing(false)
 , _maxSamplesAllowed(0)
 , _maxTextureUnits(0)
 , _glExtensions(nullptr)
@@ -150,6 +151,25 @@ void Configuration::gatherGPUInfo()
     _supportsShareableVAO = checkForGLExtension("vertex_array_object");
 	_valueDict["gl.supports_vertex_array_object"] = Value(_supportsShareableVAO);
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+    // the ARB entry points, core since OpenGL 3.3, are loaded by GLEW or OpenGL.framework
+    int major = 0, minor = 0;
+    sscanf((const char*)glGetString(GL_VERSION), "%d.%d", &major, &minor);
+    _supportsInstancing = (major > 3 || (major == 3 && minor >= 3))
+        || (checkForGLExtension("GL_ARB_draw_instanced") && checkForGLExtension("GL_ARB_instanced_arrays"));
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_MAC)
+    // GLEW only loads the ARB names when the extensions are listed
+    _supportsInstancing = _supportsInstancing && glDrawElementsInstancedCC != nullptr && glVertexAttribDivisorCC != nullptr;
+#endif
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+    // the EAGL context is OpenGL ES 2.0, instancing comes with the extension (A7 and later)
+    _supportsInstancing = checkForGLExtension("GL_EXT_instanced_arrays");
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    // OpenGL ES 3.0 or GL_EXT_instanced_arrays, the entry points are loaded by GLViewImpl
+    _supportsInstancing = glDrawElementsInstancedCC != nullptr && glVertexAttribDivisorCC != nullptr;
+#endif
+    _valueDict["gl.supports_instancing"] = Value(_supportsInstancing);
+
     CHECK_GL_ERROR_DEBUG();
 }
 
@@ -259,6 +279,11 @@ bool Configuration::supportsShareableVAO() const
 #endif
 }
 
+bool Configuration::supportsInstancing() const
+{
+    return _supportsInstancing;
+}
+
 int Configuration::getMaxSupportDirLightInShader() const
 {
     return _maxDirLightInShader;
@@ -145,6 +145,14 @@ public:
      * @since v2.0.0
      */
 	bool supportsShareableVAO() const;
+
+    /** Whether or not glDrawElementsInstanced() and glVertexAttribDivisor() are supported,
+     * for InstancedCommand. With OpenGL 3.3 or the ARB extensions on desktop, OpenGL ES 3.0
+     * or GL_EXT_instanced_arrays on Android, GL_EXT_instanced_arrays on iOS.
+     *
+     * @return Is true if supports instanced arrays.
+     */
+    bool supportsInstancing() const;
     
     /** Max support directional light in shader, for Sprite3D.
      *
@@ -232,6 +240,7 @@ protected:
     bool            _supportsBGRA8888;
     bool            _supportsDiscardFramebuffer;
     bool            _supportsShareableVAO;
+    bool            _supportsInstancing;
     GLint           _maxSamplesAllowed;
     GLint           _maxTextureUnits;
     char *          _glExtensions;
@@ -60,6 +60,8 @@ THE SOFTWARE.
 #include "base/CCAutoreleasePool.h"
 #include "base/CCConfiguration.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCFrameRecorder.h"
+#include "base/CCParallelVisit.h"
 #include "platform/CCApplication.h"
 
 #if CC_ENABLE_SCRIPT_BINDING
@@ -169,6 +171,7 @@ bool Director::init(void)
     initMatrixStack();
 
     _renderer = new (std::nothrow) Renderer;
+    _parallelVisit = new (std::nothrow) ParallelVisit();
     RenderState::initialize();
 
     return true;
@@ -194,6 +197,7 @@ Director::~Director(void)
     delete _eventAfterVisit;
     delete _eventProjectionChanged;
 
+    delete _parallelVisit;
     delete _renderer;
 
     delete _console;
@@ -472,11 +476,24 @@ void Director::resetMatrixStack()
     initMatrixStack();
 }
 
+// the MODELVIEW stack of the threads of ParallelVisit, see setModelViewMatrixStackOfThread()
+static thread_local std::stack<Mat4>* s_modelViewMatrixStackOfThread = nullptr;
+
+static inline std::stack<Mat4>& modelViewMatrixStack(std::stack<Mat4>& directorStack)
+{
+    return s_modelViewMatrixStackOfThread ? *s_modelViewMatrixStackOfThread : directorStack;
+}
+
+void Director::setModelViewMatrixStackOfThread(std::stack<Mat4>* stack)
+{
+    s_modelViewMatrixStackOfThread = stack;
+}
+
 void Director::popMatrix(MATRIX_STACK_TYPE type)
 {
     if(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW == type)
     {
-        _modelViewMatrixStack.pop();
+        modelViewMatrixStack(_modelViewMatrixStack).pop();
     }
     else if(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION == type)
     {
@@ -496,7 +513,7 @@ void Director::loadIdentityMatrix(MATRIX_STACK_TYPE type)
 {
     if(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW == type)
     {
-        _modelViewMatrixStack.top() = Mat4::IDENTITY;
+        modelViewMatrixStack(_modelViewMatrixStack).top() = Mat4::IDENTITY;
     }
     else if(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION == type)
     {
@@ -516,7 +533,7 @@ void Director::loadMatrix(MATRIX_STACK_TYPE type, const Mat4& mat)
 {
     if(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW == type)
     {
-        _modelViewMatrixStack.top() = mat;
+        modelViewMatrixStack(_modelViewMatrixStack).top() = mat;
     }
     else if(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION == type)
     {
@@ -536,7 +553,7 @@ void Director::multiplyMatrix(MATRIX_STACK_TYPE type, const Mat4& mat)
 {
     if(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW == type)
     {
-        _modelViewMatrixStack.top() *= mat;
+        modelViewMatrixStack(_modelViewMatrixStack).top() *= mat;
     }
     else if(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION == type)
     {
@@ -556,7 +573,8 @@ void Director::pushMatrix(MATRIX_STACK_TYPE type)
 {
     if(type == MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW)
     {
-        _modelViewMatrixStack.push(_modelViewMatrixStack.top());
+        auto& modelView = modelViewMatrixStack(_modelViewMatrixStack);
+        modelView.push(modelView.top());
     }
     else if(type == MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION)
     {
@@ -576,7 +594,7 @@ const Mat4& Director::getMatrix(MATRIX_STACK_TYPE type)
 {
     if(type == MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW)
     {
-        return _modelViewMatrixStack.top();
+        return modelViewMatrixStack(_modelViewMatrixStack).top();
     }
     else if(type == MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION)
     {
@@ -588,7 +606,7 @@ const Mat4& Director::getMatrix(MATRIX_STACK_TYPE type)
     }
 
     CCASSERT(false, "unknow matrix stack type, will return modelview matrix instead");
-    return  _modelViewMatrixStack.top();
+    return  modelViewMatrixStack(_modelViewMatrixStack).top();
 }
 
 void Director::setProjection(Projection projection)
@@ -930,6 +948,9 @@ void Director::reset()
     _runningScene = nullptr;
     _nextScene = nullptr;
 
+    // finish a recording while its listener, the scheduler and the GL context are still there
+    FrameRecorder::destroyInstance();
+
     // cleanup scheduler
     getScheduler()->unscheduleAll();
     
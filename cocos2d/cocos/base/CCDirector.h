@@ -58,6 +58,7 @@ class EventCustom;
 class EventListenerCustom;
 class TextureCache;
 class Renderer;
+class ParallelVisit;
 class Camera;
 
 class Console;
@@ -436,6 +437,11 @@ public:
      */
     Renderer* getRenderer() const { return _renderer; }
 
+    /** Returns the ParallelVisit the scene is visited with, off until ParallelVisit::setDepth().
+     * @js NA
+     */
+    ParallelVisit* getParallelVisit() const { return _parallelVisit; }
+
     /** Returns the Console associated with this director.
      * @since v3.0
      * @js NA
@@ -490,6 +496,12 @@ public:
      * @js NA
      */
     void resetMatrixStack();
+    /**
+     * Until it is called again with nullptr, the MODELVIEW matrix stack of the calling thread is stack
+     * rather than the director's, for the threads of ParallelVisit.
+     * @js NA
+     */
+    void setModelViewMatrixStackOfThread(std::stack<Mat4>* stack);
 
     /**
      * returns the cocos2d thread id.
@@ -606,6 +618,9 @@ protected:
 
     /* Renderer for the Director */
     Renderer *_renderer;
+
+    /* visits the scene on several threads, when enabled */
+    ParallelVisit *_parallelVisit;
     
     /* Default FrameBufferObject*/
     experimental::FrameBuffer* _defaultFBO;
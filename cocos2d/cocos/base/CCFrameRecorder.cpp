@@ -0,0 +1,519 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCFrameRecorder.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "base/CCDirector.h"
+#include "base/CCScheduler.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+#include "platform/CCGLView.h"
+#include "platform/CCFileUtils.h"
+
+// pixel buffer objects and glMapBuffer() are desktop OpenGL, fences come with GLEW
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define CC_FRAME_RECORDER_PIXEL_BUFFERS 1
+#endif
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define CC_FRAME_RECORDER_FENCES 1
+#endif
+
+NS_CC_BEGIN
+
+static FrameRecorder* s_sharedFrameRecorder = nullptr;
+
+FrameRecorder* FrameRecorder::getInstance()
+{
+    if (s_sharedFrameRecorder == nullptr)
+    {
+        s_sharedFrameRecorder = new (std::nothrow) FrameRecorder;
+    }
+    return s_sharedFrameRecorder;
+}
+
+void FrameRecorder::destroyInstance()
+{
+    // first, for the encoders of a recording being stopped, see encoderLoop()
+    auto recorder = s_sharedFrameRecorder;
+    s_sharedFrameRecorder = nullptr;
+    delete recorder;
+}
+
+FrameRecorder::FrameRecorder()
+: _file(nullptr)
+, _recording(false)
+, _usePixelBuffers(false)
+, _width(0)
+, _height(0)
+, _afterDrawListener(nullptr)
+, _readbacksIssued(0)
+, _readbacksCollected(0)
+, _stopping(false)
+, _nextIndex(0)
+, _nextWrite(0)
+, _writeFailed(false)
+, _encodersRunning(0)
+, _framesCaptured(0)
+, _framesWritten(0)
+, _framesDropped(0)
+, _readbackStalls(0)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    if (_recording)
+    {
+        stop();
+    }
+    // the callback of stop() will not run, the scheduler may be gone already
+    for (auto& encoder : _encoders)
+    {
+        if (encoder.joinable())
+        {
+            encoder.join();
+        }
+    }
+    if (_file)
+    {
+        fclose(_file);
+    }
+}
+
+bool FrameRecorder::start(const std::string& filename, const Options& options)
+{
+    if (_recording || !_encoders.empty())
+    {
+        CCLOG("FrameRecorder: recording already, or still writing the last recording");
+        return false;
+    }
+
+    auto glView = Director::getInstance()->getOpenGLView();
+    if (!glView)
+    {
+        return false;
+    }
+    auto frameSize = glView->getFrameSize();
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    frameSize = frameSize * glView->getFrameZoomFactor() * glView->getRetinaFactor();
+#endif
+    // the size is the one of the first frame, the file cannot change it
+    _width = static_cast<int>(frameSize.width);
+    _height = static_cast<int>(frameSize.height);
+    if (_width <= 0 || _height <= 0)
+    {
+        return false;
+    }
+
+    if (FileUtils::getInstance()->isAbsolutePath(filename))
+    {
+        _filename = filename;
+    }
+    else
+    {
+        CCASSERT(filename.find("/") == std::string::npos, "The existence of a relative path is not guaranteed!");
+        _filename = FileUtils::getInstance()->getWritablePath() + filename;
+    }
+    _file = fopen(_filename.c_str(), "wb");
+    if (!_file)
+    {
+        CCLOG("FrameRecorder: cannot open %s", _filename.c_str());
+        return false;
+    }
+
+    _options = options;
+    _options.framesPerSecond = std::max(1, _options.framesPerSecond);
+    _options.pixelBuffers = std::max(1, _options.pixelBuffers);
+    _options.encoderThreads = std::max(1, _options.encoderThreads);
+    _options.maxPendingFrames = std::max(1, _options.maxPendingFrames);
+
+    _writeFailed = false;
+    if (_options.format == Format::Y4M)
+    {
+        // C420jpeg: full range BT.601, chroma sited as JPEG
+        _writeFailed = fprintf(_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                               _width & ~1, _height & ~1, _options.framesPerSecond) < 0;
+    }
+
+    _usePixelBuffers = false;
+#if CC_FRAME_RECORDER_PIXEL_BUFFERS
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+    // OpenGL 2.1 at least on every Mac
+    _usePixelBuffers = true;
+#else
+    _usePixelBuffers = GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+#endif
+    if (_usePixelBuffers)
+    {
+        _pixelBuffers.resize(_options.pixelBuffers, 0);
+        _fences.assign(_options.pixelBuffers, nullptr);
+        glGenBuffers(_options.pixelBuffers, _pixelBuffers.data());
+        for (auto buffer : _pixelBuffers)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, _width * _height * 4, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        CHECK_GL_ERROR_DEBUG();
+    }
+#endif
+    _readbacksIssued = 0;
+    _readbacksCollected = 0;
+
+    _frames.clear();
+    _freeFrames.clear();
+    for (int i = 0; i < _options.maxPendingFrames; ++i)
+    {
+        std::unique_ptr<Frame> frame(new Frame);
+        frame->pixels.resize(_width * _height * 4);
+        frame->index = 0;
+        _freeFrames.push_back(frame.get());
+        _frames.push_back(std::move(frame));
+    }
+    _stopping = false;
+    _nextIndex = 0;
+    _nextWrite = 0;
+    _ready.clear();
+
+    _framesCaptured = 0;
+    _framesWritten = 0;
+    _framesDropped = 0;
+    _readbackStalls = 0;
+
+    _encodersRunning = _options.encoderThreads;
+    for (int i = 0; i < _options.encoderThreads; ++i)
+    {
+        _encoders.emplace_back(&FrameRecorder::encoderLoop, this);
+    }
+
+    _afterDrawListener = Director::getInstance()->getEventDispatcher()->addCustomEventListener(Director::EVENT_AFTER_DRAW, [this](EventCustom* /*event*/) {
+        onAfterDraw();
+    });
+    _recording = true;
+    return true;
+}
+
+void FrameRecorder::stop(const StopCallback& afterStopped)
+{
+    if (!_recording)
+    {
+        if (afterStopped)
+        {
+            afterStopped(false, _filename);
+        }
+        return;
+    }
+    _recording = false;
+    _afterStopped = afterStopped;
+
+    Director::getInstance()->getEventDispatcher()->removeEventListener(_afterDrawListener);
+    _afterDrawListener = nullptr;
+
+    // the frames in flight are in the video too, waiting for the encoders if need be
+    while (_readbacksCollected != _readbacksIssued)
+    {
+        collect(_readbacksCollected % _options.pixelBuffers, true);
+    }
+    releaseGL();
+
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    _stopping = true;
+    _framePending.notify_all();
+}
+
+void FrameRecorder::onAfterDraw()
+{
+    ++_framesCaptured;
+
+#if CC_FRAME_RECORDER_PIXEL_BUFFERS
+    if (_usePixelBuffers)
+    {
+        int slot = _readbacksIssued % _options.pixelBuffers;
+        if (_readbacksIssued - _readbacksCollected == static_cast<unsigned int>(_options.pixelBuffers))
+        {
+            // the oldest readback, pixelBuffers frames ago
+            collect(slot, false);
+        }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[slot]);
+        // returns at once, the copy goes on with the next frame
+        glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#if CC_FRAME_RECORDER_FENCES
+        if (GLEW_ARB_sync)
+        {
+            _fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+#endif
+        ++_readbacksIssued;
+        CHECK_GL_ERROR_DEBUG();
+        return;
+    }
+#endif
+
+    // no pixel buffers: the readback blocks, the encoding does not
+    Frame* frame = acquireFrame(false);
+    if (!frame)
+    {
+        ++_framesDropped;
+        return;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, frame->pixels.data());
+    submit(frame);
+}
+
+void FrameRecorder::collect(int slot, bool wait)
+{
+#if CC_FRAME_RECORDER_PIXEL_BUFFERS
+    ++_readbacksCollected;
+
+#if CC_FRAME_RECORDER_FENCES
+    GLsync fence = static_cast<GLsync>(_fences[slot]);
+    if (fence)
+    {
+        if (!wait && glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            // glMapBuffer() below blocks until the copy is done
+            ++_readbackStalls;
+        }
+        glDeleteSync(fence);
+        _fences[slot] = nullptr;
+    }
+#endif
+
+    Frame* frame = acquireFrame(wait);
+    if (!frame)
+    {
+        ++_framesDropped;
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[slot]);
+    auto pixels = static_cast<const GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if (pixels)
+    {
+        memcpy(frame->pixels.data(), pixels, frame->pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (pixels)
+    {
+        submit(frame);
+    }
+    else
+    {
+        ++_framesDropped;
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _freeFrames.push_back(frame);
+    }
+#else
+    CC_UNUSED_PARAM(slot);
+    CC_UNUSED_PARAM(wait);
+#endif
+}
+
+void FrameRecorder::releaseGL()
+{
+#if CC_FRAME_RECORDER_PIXEL_BUFFERS
+#if CC_FRAME_RECORDER_FENCES
+    for (auto fence : _fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+#endif
+    if (!_pixelBuffers.empty())
+    {
+        glDeleteBuffers(static_cast<GLsizei>(_pixelBuffers.size()), _pixelBuffers.data());
+    }
+#endif
+    _pixelBuffers.clear();
+    _fences.clear();
+}
+
+FrameRecorder::Frame* FrameRecorder::acquireFrame(bool wait)
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    if (wait)
+    {
+        _frameFree.wait(lock, [this]() { return !_freeFrames.empty(); });
+    }
+    else if (_freeFrames.empty())
+    {
+        return nullptr;
+    }
+    Frame* frame = _freeFrames.back();
+    _freeFrames.pop_back();
+    return frame;
+}
+
+void FrameRecorder::submit(Frame* frame)
+{
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    frame->index = _nextIndex++;
+    _pending.push(frame);
+    _framePending.notify_one();
+}
+
+void FrameRecorder::encoderLoop()
+{
+    for (;;)
+    {
+        Frame* frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _framePending.wait(lock, [this]() { return _stopping || !_pending.empty(); });
+            if (_pending.empty())
+            {
+                break;
+            }
+            frame = _pending.front();
+            _pending.pop();
+        }
+
+        encode(frame);
+
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        _ready[frame->index] = frame;
+        writeReady();
+    }
+
+    if (--_encodersRunning > 0)
+    {
+        return;
+    }
+
+    // the last encoder out closes the file, the cocos thread joins the encoders
+    bool succeed = !_writeFailed && fclose(_file) == 0;
+    _file = nullptr;
+    Director::getInstance()->getScheduler()->performFunctionInCocosThread([this, succeed]() {
+        if (s_sharedFrameRecorder != this)
+        {
+            // destroyed meanwhile, the destructor joined the encoders
+            return;
+        }
+        for (auto& encoder : _encoders)
+        {
+            encoder.join();
+        }
+        _encoders.clear();
+        if (_afterStopped)
+        {
+            auto afterStopped = _afterStopped;
+            _afterStopped = nullptr;
+            afterStopped(succeed, _filename);
+        }
+    });
+}
+
+void FrameRecorder::writeReady()
+{
+    for (auto it = _ready.find(_nextWrite); it != _ready.end(); it = _ready.find(_nextWrite))
+    {
+        Frame* frame = it->second;
+        _ready.erase(it);
+        ++_nextWrite;
+
+        if (!_writeFailed)
+        {
+            _writeFailed = fwrite(frame->encoded.data(), 1, frame->encoded.size(), _file) != frame->encoded.size();
+            if (!_writeFailed)
+            {
+                ++_framesWritten;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _freeFrames.push_back(frame);
+        _frameFree.notify_one();
+    }
+}
+
+void FrameRecorder::encode(Frame* frame)
+{
+    // glReadPixels() rows go bottom up
+    const GLubyte* pixels = frame->pixels.data();
+    const int stride = _width * 4;
+
+    if (_options.format == Format::RAW)
+    {
+        frame->encoded.resize(frame->pixels.size());
+        for (int row = 0; row < _height; ++row)
+        {
+            memcpy(frame->encoded.data() + row * stride, pixels + (_height - row - 1) * stride, stride);
+        }
+        return;
+    }
+
+    // Y4M, 4:2:0: a luma plane then chroma planes of half size, on even sizes
+    static const char header[] = "FRAME\n";
+    const int headerSize = sizeof(header) - 1;
+    const int width = _width & ~1;
+    const int height = _height & ~1;
+    const int lumaSize = width * height;
+    const int chromaSize = lumaSize / 4;
+    frame->encoded.resize(headerSize + lumaSize + 2 * chromaSize);
+    memcpy(frame->encoded.data(), header, headerSize);
+    unsigned char* y = frame->encoded.data() + headerSize;
+    unsigned char* u = y + lumaSize;
+    unsigned char* v = u + chromaSize;
+
+    // full range BT.601, 16 bit fixed point
+    for (int row = 0; row < height; row += 2)
+    {
+        const GLubyte* top = pixels + (_height - row - 1) * stride;
+        const GLubyte* bottom = top - stride;
+        unsigned char* yTop = y + row * width;
+        unsigned char* yBottom = yTop + width;
+        for (int col = 0; col < width; col += 2)
+        {
+            int r = 0, g = 0, b = 0;
+            const GLubyte* quad[4] = { top + col * 4, top + col * 4 + 4, bottom + col * 4, bottom + col * 4 + 4 };
+            unsigned char* luma[4] = { yTop + col, yTop + col + 1, yBottom + col, yBottom + col + 1 };
+            for (int i = 0; i < 4; ++i)
+            {
+                const GLubyte* p = quad[i];
+                *luma[i] = static_cast<unsigned char>((19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16);
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            // the average of the quad, kept times 4 in r, g, b
+            int cb = (-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18;
+            int cr = (32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18;
+            u[(row / 2) * (width / 2) + col / 2] = static_cast<unsigned char>(std::min(255, std::max(0, cb)));
+            v[(row / 2) * (width / 2) + col / 2] = static_cast<unsigned char>(std::min(255, std::max(0, cr)));
+        }
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,201 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FRAME_RECORDER_H__
+#define __CC_FRAME_RECORDER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+#include "platform/CCGL.h"
+
+/**
+ * @addtogroup base
+ * @{
+ */
+NS_CC_BEGIN
+
+class EventListenerCustom;
+
+/**
+ * @class FrameRecorder
+ * @brief Records every frame drawn, without stalling the frame.
+ *
+ * Unlike utils::captureScreen(), which reads the frame back with a blocking
+ * glReadPixels() and encodes it on the calling thread, the recorder reads
+ * each frame into a ring of pixel buffer objects at Director::EVENT_AFTER_DRAW
+ * and maps it back only a few frames later, when the copy is done. The pixels
+ * are then converted and written by worker threads, in order, into one file.
+ *
+ * Pixel buffer objects need desktop OpenGL 2.1 (Linux, Mac and Windows,
+ * windowed or offscreen, e.g. under Xvfb). Elsewhere, or without the
+ * extension, frames are read with glReadPixels(), still encoded off the
+ * main thread.
+ *
+ * If the encoders fall behind by more than Options::maxPendingFrames, frames
+ * are dropped rather than stalling the game, see getFramesDropped().
+ * @js NA
+ */
+class CC_DLL FrameRecorder
+{
+public:
+    enum class Format
+    {
+        /** RGBA frames back to back, top row first, no header:
+         * ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -i file */
+        RAW,
+        /** YUV4MPEG2, 4:2:0, played by most players and read by ffmpeg.
+         * Odd sizes lose their last row / column */
+        Y4M,
+    };
+
+    struct Options
+    {
+        Format format;
+        /** frame rate written in the Y4M header */
+        int framesPerSecond;
+        /** length of the ring of pixel buffers, frames between a readback and its use */
+        int pixelBuffers;
+        /** threads converting and writing frames */
+        int encoderThreads;
+        /** frames read back and waiting for the encoders, past it frames are dropped */
+        int maxPendingFrames;
+
+        Options()
+        : format(Format::Y4M), framesPerSecond(60), pixelBuffers(3), encoderThreads(2), maxPendingFrames(8)
+        {}
+    };
+
+    /** Callback of stop(), on the cocos thread once the file is closed. */
+    typedef std::function<void(bool succeed, const std::string& filename)> StopCallback;
+
+    static FrameRecorder* getInstance();
+    static void destroyInstance();
+
+    /**
+     * Starts recording every frame from the next one into filename: an absolute
+     * path or a base filename in the writable path, as utils::captureScreen().
+     * @return false if it records already or the file cannot be opened.
+     */
+    bool start(const std::string& filename, const Options& options = Options());
+
+    /**
+     * Stops recording: the frames in flight are read back, the encoders finish
+     * the frames queued, then afterStopped is called on the cocos thread.
+     */
+    void stop(const StopCallback& afterStopped = nullptr);
+
+    bool isRecording() const { return _recording; }
+
+    /** frames read back since start() */
+    unsigned int getFramesCaptured() const { return _framesCaptured; }
+    /** frames in the file */
+    unsigned int getFramesWritten() const { return _framesWritten; }
+    /** frames lost because the encoders were behind */
+    unsigned int getFramesDropped() const { return _framesDropped; }
+    /** readbacks not done yet when their pixel buffer was mapped */
+    unsigned int getReadbackStalls() const { return _readbackStalls; }
+
+CC_CONSTRUCTOR_ACCESS:
+    FrameRecorder();
+    ~FrameRecorder();
+
+protected:
+    struct Frame
+    {
+        std::vector<GLubyte> pixels;
+        std::vector<unsigned char> encoded;
+        unsigned int index;
+    };
+
+    // Director::EVENT_AFTER_DRAW, the frame is complete in the back buffer
+    void onAfterDraw();
+    // maps the pixel buffer of slot and hands its frame to the encoders
+    void collect(int slot, bool wait);
+    // a frame of the pool, or nullptr if none is free and !wait
+    Frame* acquireFrame(bool wait);
+    void submit(Frame* frame);
+    void encoderLoop();
+    void encode(Frame* frame);
+    // writes the frames encoded, in order, the caller holds _writeMutex
+    void writeReady();
+    void releaseGL();
+
+    Options _options;
+    std::string _filename;
+    FILE* _file;
+    bool _recording;
+    bool _usePixelBuffers;
+    int _width;
+    int _height;
+    EventListenerCustom* _afterDrawListener;
+    StopCallback _afterStopped;
+
+    // ring of pixel buffers, readback of frame n goes to slot n % pixelBuffers
+    std::vector<GLuint> _pixelBuffers;
+    std::vector<void*> _fences;
+    unsigned int _readbacksIssued;
+    unsigned int _readbacksCollected;
+
+    // frames of the pool, the free ones and the ones for the encoders
+    std::vector<std::unique_ptr<Frame>> _frames;
+    std::vector<Frame*> _freeFrames;
+    std::queue<Frame*> _pending;
+    std::mutex _queueMutex;
+    std::condition_variable _frameFree;
+    std::condition_variable _framePending;
+    bool _stopping;
+    unsigned int _nextIndex;
+
+    // frames encoded, written by index
+    std::map<unsigned int, Frame*> _ready;
+    std::mutex _writeMutex;
+    unsigned int _nextWrite;
+    bool _writeFailed;
+
+    std::vector<std::thread> _encoders;
+    std::atomic<int> _encodersRunning;
+
+    std::atomic<unsigned int> _framesCaptured;
+    std::atomic<unsigned int> _framesWritten;
+    std::atomic<unsigned int> _framesDropped;
+    std::atomic<unsigned int> _readbackStalls;
+};
+
+NS_CC_END
+/**
+ * end of base group
+ * @}
+ */
+#endif // __CC_FRAME_RECORDER_H__
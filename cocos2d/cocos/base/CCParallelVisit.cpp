@@ -0,0 +1,293 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCParallelVisit.h"
+
+#include <algorithm>
+
+#include "2d/CCNode.h"
+#include "base/CCDirector.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+// the parallel visit the cocos thread is queueing the subtrees of, if any
+static thread_local ParallelVisit* s_queueing = nullptr;
+// the parallel visit the calling thread is visiting a subtree of, and the recording of the subtree
+static thread_local ParallelVisit* s_visiting = nullptr;
+static thread_local Renderer::Recording* s_subtreeRecording = nullptr;
+
+ParallelVisit::ParallelVisit()
+: _depth(0)
+, _threads(std::max((int)std::thread::hardware_concurrency() - 1, 1))
+, _visitDepth(0)
+, _subtreeCount(0)
+, _nextSubtree(0)
+, _deferredCount(0)
+, _renderer(nullptr)
+, _generation(0)
+, _busyWorkers(0)
+, _quit(false)
+{
+}
+
+ParallelVisit::~ParallelVisit()
+{
+    stopThreads();
+}
+
+void ParallelVisit::setThreads(int threads)
+{
+    threads = std::max(threads, 0);
+    if (threads != _threads)
+    {
+        stopThreads();
+        _threads = threads;
+    }
+}
+
+void ParallelVisit::visit(Node* root, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags)
+{
+    if (_depth <= 0 || s_queueing)
+    {
+        root->visit(renderer, parentTransform, parentFlags);
+        return;
+    }
+
+    if (_workers.size() != (size_t)_threads)
+    {
+        startThreads();
+    }
+
+    // the top of the tree, the subtrees are queued in the recording
+    _subtreeCount = 0;
+    _deferredCount = 0;
+    _recording.commands.clear();
+    _recording.groupStack.assign(1, renderer->getCurrentRenderQueue());
+    _visitDepth = 0;
+    s_queueing = this;
+    renderer->beginRecording(&_recording);
+    root->visit(renderer, parentTransform, parentFlags);
+    renderer->endRecording();
+    s_queueing = nullptr;
+
+    if (_subtreeCount > 0)
+    {
+        _renderer = renderer;
+        _nextSubtree = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_generation;
+            _busyWorkers = (int)_workers.size();
+        }
+        _wake.notify_all();
+
+        visitSubtrees(renderer, _modelViewStack);
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]{ return _busyWorkers == 0; });
+        }
+
+        visitDeferred(renderer);
+    }
+
+    // in the order of a visit on one thread
+    addRecording(renderer, _recording, _subtrees);
+}
+
+void ParallelVisit::visitChild(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags)
+{
+    ParallelVisit* parallelVisit = s_queueing;
+    if (!parallelVisit)
+    {
+        if (s_visiting && child->isVisitedOnCocosThread())
+        {
+            s_visiting->deferSubtree(child, renderer, parentTransform, parentFlags, s_subtreeRecording);
+        }
+        else
+        {
+            child->visit(renderer, parentTransform, parentFlags);
+        }
+    }
+    else if (parallelVisit->_visitDepth + 1 >= parallelVisit->_depth && !child->isVisitedOnCocosThread())
+    {
+        parallelVisit->queueSubtree(child, renderer, parentTransform, parentFlags);
+    }
+    else
+    {
+        ++parallelVisit->_visitDepth;
+        child->visit(renderer, parentTransform, parentFlags);
+        --parallelVisit->_visitDepth;
+    }
+}
+
+void ParallelVisit::initSubtree(Subtree& subtree, Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags)
+{
+    subtree.node = child;
+    subtree.parentTransform = parentTransform;
+    subtree.parentFlags = parentFlags;
+    subtree.modelView = Director::getInstance()->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+    subtree.recording.commands.clear();
+    subtree.recording.groupStack.assign(1, renderer->getCurrentRenderQueue());
+}
+
+void ParallelVisit::queueSubtree(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags)
+{
+    if (!child->isVisible())
+    {
+        return;
+    }
+
+    if (_subtreeCount == _subtrees.size())
+    {
+        _subtrees.push_back(Subtree());
+    }
+    initSubtree(_subtrees[_subtreeCount], child, renderer, parentTransform, parentFlags);
+
+    _recording.commands.push_back(std::make_pair(nullptr, (int)_subtreeCount));
+    ++_subtreeCount;
+}
+
+void ParallelVisit::deferSubtree(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags, Renderer::Recording* recording)
+{
+    if (!child->isVisible())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_deferredCount == _deferred.size())
+    {
+        _deferred.push_back(Subtree());
+    }
+    initSubtree(_deferred[_deferredCount], child, renderer, parentTransform, parentFlags);
+
+    recording->commands.push_back(std::make_pair(nullptr, (int)_deferredCount));
+    ++_deferredCount;
+}
+
+void ParallelVisit::visitSubtrees(Renderer* renderer, std::stack<Mat4>& modelViewStack)
+{
+    auto director = Director::getInstance();
+    director->setModelViewMatrixStackOfThread(&modelViewStack);
+    s_visiting = this;
+    for (size_t i = _nextSubtree++; i < _subtreeCount; i = _nextSubtree++)
+    {
+        Subtree& subtree = _subtrees[i];
+        modelViewStack.push(subtree.modelView);
+        s_subtreeRecording = &subtree.recording;
+        renderer->beginRecording(&subtree.recording);
+        subtree.node->visit(renderer, subtree.parentTransform, subtree.parentFlags);
+        renderer->endRecording();
+        modelViewStack.pop();
+        CCASSERT(subtree.recording.groupStack.size() == 1, "pushGroup() and popGroup() do not match in the subtree");
+    }
+    s_visiting = nullptr;
+    s_subtreeRecording = nullptr;
+    director->setModelViewMatrixStackOfThread(nullptr);
+}
+
+void ParallelVisit::visitDeferred(Renderer* renderer)
+{
+    // the threads are done, these may push render groups and PROJECTION matrices
+    auto director = Director::getInstance();
+    director->setModelViewMatrixStackOfThread(&_modelViewStack);
+    for (size_t i = 0; i < _deferredCount; ++i)
+    {
+        Subtree& subtree = _deferred[i];
+        _modelViewStack.push(subtree.modelView);
+        renderer->beginRecording(&subtree.recording);
+        subtree.node->visit(renderer, subtree.parentTransform, subtree.parentFlags);
+        renderer->endRecording();
+        _modelViewStack.pop();
+        CCASSERT(subtree.recording.groupStack.size() == 1, "pushGroup() and popGroup() do not match in the subtree");
+    }
+    director->setModelViewMatrixStackOfThread(nullptr);
+}
+
+void ParallelVisit::addRecording(Renderer* renderer, const Renderer::Recording& recording, const std::vector<Subtree>& placeholders)
+{
+    for (const auto& entry : recording.commands)
+    {
+        if (entry.first)
+        {
+            renderer->addCommand(entry.first, entry.second);
+            continue;
+        }
+        // the deferred subtrees, visited on the cocos thread, have no placeholders of their own
+        addRecording(renderer, placeholders[entry.second].recording, _deferred);
+    }
+}
+
+void ParallelVisit::startThreads()
+{
+    stopThreads();
+    for (int i = 0; i < _threads; ++i)
+    {
+        // from the current visit on, the thread may not run before the next one starts
+        _workers.push_back(std::thread(&ParallelVisit::workerLoop, this, _generation));
+    }
+}
+
+void ParallelVisit::stopThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+    _quit = false;
+}
+
+void ParallelVisit::workerLoop(unsigned int generation)
+{
+    std::stack<Mat4> modelViewStack;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _wake.wait(lock, [&]{ return _quit || _generation != generation; });
+        if (_quit)
+        {
+            break;
+        }
+        generation = _generation;
+        lock.unlock();
+
+        visitSubtrees(_renderer, modelViewStack);
+
+        lock.lock();
+        if (--_busyWorkers == 0)
+        {
+            _done.notify_one();
+        }
+    }
+}
+
+NS_CC_END
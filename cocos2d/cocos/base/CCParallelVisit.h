@@ -0,0 +1,160 @@
+/****************************************************************************
+Copyright (c) 2016 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARALLEL_VISIT_H__
+#define __CC_PARALLEL_VISIT_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stack>
+#include <thread>
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+#include "math/CCMath.h"
+#include "renderer/CCRenderer.h"
+
+/**
+ * @addtogroup base
+ * @{
+ */
+NS_CC_BEGIN
+
+class Node;
+
+/**
+ * @class ParallelVisit
+ * @brief Visits the scene graph on several threads, see Director::getParallelVisit().
+ *
+ * The nodes above getDepth() are visited by the cocos thread, as usual, but the
+ * subtrees from getDepth() on are queued instead, and visited once the top of the
+ * tree is, by worker threads and the cocos thread. Each thread records the commands
+ * it adds into a Renderer::Recording. The recordings are then added to the render
+ * queues in the order of a visit on one thread, so the frame is the same.
+ *
+ * The subtrees are visited at the same time, their nodes must not change shared
+ * state in visit() and draw(): no GL calls, no Ref created, autoreleased or released,
+ * no cache filled, no render group pushed (GroupCommand ids are shared), no PROJECTION
+ * matrix pushed or loaded (the stack is the director's). Sprites, SpriteBatchNodes,
+ * InstancedSpriteBatches and DrawNodes qualify; a Label whose text changed lays it out
+ * in visit() and does not.
+ *
+ * A node whose Node::isVisitedOnCocosThread() is true, as ClippingNode, NodeGrid,
+ * RenderTexture, a clipping ui::Layout and cocostudio::BatchNode, is left by the threads to the cocos thread, which visits it and its
+ * subtree once the other subtrees are visited. A node calling RenderTexture::begin()
+ * in its visit() should do the same.
+ * @js NA
+ */
+class CC_DLL ParallelVisit
+{
+public:
+    ParallelVisit();
+    ~ParallelVisit();
+
+    /**
+     * Depth of the subtrees visited by the threads, the children of the scene are at
+     * depth 1. 0, the default, visits the whole tree on the cocos thread.
+     */
+    void setDepth(int depth) { _depth = depth; }
+    int getDepth() const { return _depth; }
+
+    /** Worker threads, besides the cocos thread. By default, one less than the cores. */
+    void setThreads(int threads);
+    int getThreads() const { return _threads; }
+
+    /** Subtrees visited by the threads during the last visit. */
+    size_t getSubtreeCount() const { return _subtreeCount; }
+
+    /** Subtrees left to the cocos thread during the last visit, see Node::isVisitedOnCocosThread(). */
+    size_t getDeferredCount() const { return _deferredCount; }
+
+    /** Visits root as root->visit(renderer, parentTransform, parentFlags) would, on the cocos thread. */
+    void visit(Node* root, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags);
+
+    /** Visits child, called by Node::visit() for each child. During a parallel visit, a child at
+     * getDepth() is queued to be visited by the threads, and a child visited on the cocos thread
+     * only is left to it. */
+    static void visitChild(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags);
+
+protected:
+    struct Subtree
+    {
+        Node* node;
+        Mat4 parentTransform;
+        uint32_t parentFlags;
+        // top of the MODELVIEW stack when the subtree was reached
+        Mat4 modelView;
+        Renderer::Recording recording;
+    };
+
+    // the subtree of child, as reached now on the calling thread
+    void initSubtree(Subtree& subtree, Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags);
+    // queues the subtree of child, in place of its commands among the ones of the cocos thread
+    void queueSubtree(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags);
+    // leaves the subtree of child to the cocos thread, in place of its commands among the ones of recording
+    void deferSubtree(Node* child, Renderer* renderer, const Mat4& parentTransform, uint32_t parentFlags, Renderer::Recording* recording);
+    void startThreads();
+    void stopThreads();
+    void workerLoop(unsigned int generation);
+    // visits the subtrees left, on the calling thread
+    void visitSubtrees(Renderer* renderer, std::stack<Mat4>& modelViewStack);
+    // visits the deferred subtrees, on the cocos thread once the threads are done
+    void visitDeferred(Renderer* renderer);
+    // adds the commands of recording to the render queues, the ones of placeholders[i] in place of (nullptr, i)
+    void addRecording(Renderer* renderer, const Renderer::Recording& recording, const std::vector<Subtree>& placeholders);
+
+    int _depth;
+    int _threads;
+
+    // the visit of the cocos thread, up to the subtrees: depth of the node visited and its commands
+    int _visitDepth;
+    Renderer::Recording _recording;
+
+    // subtrees of the visit, kept from frame to frame with their recordings
+    std::vector<Subtree> _subtrees;
+    size_t _subtreeCount;
+    std::atomic<size_t> _nextSubtree;
+    // subtrees the threads left to the cocos thread, filled under _mutex
+    std::vector<Subtree> _deferred;
+    size_t _deferredCount;
+    Renderer* _renderer;
+    std::stack<Mat4> _modelViewStack;
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    // incremented by each visit, the workers visit the subtrees once per visit
+    unsigned int _generation;
+    int _busyWorkers;
+    bool _quit;
+};
+
+NS_CC_END
+/**
+ * end of base group
+ * @}
+ */
+#endif // __CC_PARALLEL_VISIT_H__
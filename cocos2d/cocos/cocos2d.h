@@ -44,10 +44,12 @@ THE SOFTWARE.
 #include "base/CCConsole.h"
 #include "base/CCData.h"
 #include "base/CCDirector.h"
+#include "base/CCFrameRecorder.h"
 #include "base/CCIMEDelegate.h"
 #include "base/CCIMEDispatcher.h"
 #include "base/CCMap.h"
 #include "base/CCNS.h"
+#include "base/CCParallelVisit.h"
 #include "base/CCProfiling.h"
 #include "base/CCProperties.h"
 #include "base/CCRef.h"
@@ -152,6 +154,7 @@ THE SOFTWARE.
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramState.h"
 #include "renderer/CCGroupCommand.h"
+#include "renderer/CCInstancedCommand.h"
 #include "renderer/CCMaterial.h"
 #include "renderer/CCPass.h"
 #include "renderer/CCPrimitive.h"
@@ -161,6 +164,7 @@ THE SOFTWARE.
 #include "renderer/CCRenderCommandPool.h"
 #include "renderer/CCRenderState.h"
 #include "renderer/CCRenderer.h"
+#include "renderer/CCStreamingBuffer.h"
 #include "renderer/CCTechnique.h"
 #include "renderer/CCTexture2D.h"
 #include "renderer/CCTextureCube.h"
@@ -257,6 +261,7 @@ THE SOFTWARE.
 #include "2d/CCAnimationCache.h"
 #include "2d/CCSprite.h"
 #include "2d/CCAutoPolygon.h"
+#include "2d/CCInstancedSpriteBatch.h"
 #include "2d/CCSpriteBatchNode.h"
 #include "2d/CCSpriteFrame.h"
 #include "2d/CCSpriteFrameCache.h"
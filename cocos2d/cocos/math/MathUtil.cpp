@@ -31,6 +31,8 @@ This file was modified to fit the cocos2d-x project
 //#define INCLUDE_NEON64    : neon 64 code included
 //#define USE_SSE           : SSE code used
 //#define INCLUDE_SSE       : SSE code included
+//#define INCLUDE_SSE2      : SSE2 code of the vertex and index batches included
+//#define INCLUDE_AVX2      : AVX2 code of the batches included, used if the cpu has it
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     #if defined (__arm64__)
@@ -58,6 +60,22 @@ This file was modified to fit the cocos2d-x project
 #define INCLUDE_SSE
 #endif
 
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INCLUDE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined (INCLUDE_SSE2) && defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define INCLUDE_AVX2
+#define CC_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined (INCLUDE_SSE2) && defined (_MSC_VER) && _MSC_VER >= 1800
+#define INCLUDE_AVX2
+#define CC_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
 #ifdef INCLUDE_NEON32
 #include "MathUtilNeon.inl"
 #endif
@@ -66,12 +84,12 @@ This file was modified to fit the cocos2d-x project
 #include "MathUtilNeon64.inl"
 #endif
 
-#ifdef INCLUDE_SSE
+#include "MathUtil.inl"
+
+#if defined (INCLUDE_SSE) || defined (INCLUDE_SSE2)
 #include "MathUtilSSE.inl"
 #endif
 
-#include "MathUtil.inl"
-
 NS_CC_MATH_BEGIN
 
 void MathUtil::smooth(float* x, float target, float elapsedTime, float responseTime)
@@ -135,6 +153,35 @@ bool MathUtil::isNeon64Enabled()
 #endif
 }
 
+bool MathUtil::isAVX2Enabled()
+{
+#if defined (INCLUDE_AVX2) && defined (__GNUC__)
+    static bool avx2 = __builtin_cpu_supports("avx2") != 0;
+    return avx2;
+#elif defined (INCLUDE_AVX2)
+    class AVX2Checker
+    {
+    public:
+        AVX2Checker()
+        {
+            int info[4];
+            __cpuid(info, 1);
+            // the os saves the ymm registers
+            bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            __cpuidex(info, 7, 0);
+            _isAVX2Enabled = osxsave && (info[1] & (1 << 5)) != 0;
+        }
+        bool isAVX2Enabled() const { return _isAVX2Enabled; }
+    private:
+        bool _isAVX2Enabled;
+    };
+    static AVX2Checker checker;
+    return checker.isAVX2Enabled();
+#else
+    return false;
+#endif
+}
+
 void MathUtil::addMatrix(const float* m, float scalar, float* dst)
 {
 #ifdef USE_NEON32
@@ -275,4 +322,28 @@ void MathUtil::crossVec3(const float* v1, const float* v2, float* dst)
 #endif
 }
 
+void MathUtil::transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride)
+{
+#if defined (INCLUDE_AVX2)
+    if(isAVX2Enabled()) MathUtilAVX2::transformVertices(m, src, dst, count, stride);
+    else MathUtilSSE2::transformVertices(m, src, dst, count, stride);
+#elif defined (INCLUDE_SSE2)
+    MathUtilSSE2::transformVertices(m, src, dst, count, stride);
+#else
+    MathUtilC::transformVertices(m, src, dst, count, stride);
+#endif
+}
+
+void MathUtil::offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count)
+{
+#if defined (INCLUDE_AVX2)
+    if(isAVX2Enabled()) MathUtilAVX2::offsetIndices(src, offset, dst, count);
+    else MathUtilSSE2::offsetIndices(src, offset, dst, count);
+#elif defined (INCLUDE_SSE2)
+    MathUtilSSE2::offsetIndices(src, offset, dst, count);
+#else
+    MathUtilC::offsetIndices(src, offset, dst, count);
+#endif
+}
+
 NS_CC_MATH_END
@@ -87,10 +87,37 @@ public:
      * @return interpolated float value
      */
     static float lerp(float from, float to, float alpha);
+
+    /**
+     * Transforms the positions of count interleaved vertices by the matrix m, as
+     * Mat4::transformPoint() does, and copies the rest of each vertex along. A position
+     * is the first three floats of its vertex, as in V3F_C4B_T2F.
+     *
+     * Uses SSE2 on x86, and AVX2 when the cpu has it; results are the same on every path.
+     *
+     * @param m the matrix, Mat4::m.
+     * @param src the first vertex.
+     * @param dst where the first vertex goes, src itself or not overlapping src.
+     * @param count number of vertices.
+     * @param stride size of a vertex in bytes, sizeof(V3F_C4B_T2F) for instance.
+     */
+    static void transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride);
+
+    /**
+     * Adds offset to count indices, as when the vertices they refer to are appended to a batch.
+     *
+     * @param src the indices.
+     * @param offset the value added to each index.
+     * @param dst where the indices go, src itself or not overlapping src.
+     * @param count number of indices.
+     */
+    static void offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count);
 private:
     //Indicates that if neon is enabled
     static bool isNeon32Enabled();
     static bool isNeon64Enabled();
+    //Indicates that if the cpu has AVX2, checked once
+    static bool isAVX2Enabled();
 private:
 #ifdef __SSE__
     static void addMatrix(const __m128 m[4], float scalar, __m128 dst[4]);
@@ -42,6 +42,10 @@ public:
     inline static void transformVec4(const float* m, const float* v, float* dst);
     
     inline static void crossVec3(const float* v1, const float* v2, float* dst);
+
+    inline static void transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride);
+
+    inline static void offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count);
 };
 
 inline void MathUtilC::addMatrix(const float* m, float scalar, float* dst)
@@ -215,4 +219,29 @@ inline void MathUtilC::crossVec3(const float* v1, const float* v2, float* dst)
     dst[2] = z;
 }
 
+inline void MathUtilC::transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride)
+{
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    for (size_t i = 0; i < count; ++i, s += stride, d += stride)
+    {
+        float v[3];
+        memcpy(v, s, sizeof(v));
+        if (s != d)
+        {
+            memcpy(d + sizeof(v), s + sizeof(v), stride - sizeof(v));
+        }
+        transformVec4(m, v[0], v[1], v[2], 1.0f, v);
+        memcpy(d, v, sizeof(v));
+    }
+}
+
+inline void MathUtilC::offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        dst[i] = static_cast<unsigned short>(src[i] + offset);
+    }
+}
+
 NS_CC_MATH_END
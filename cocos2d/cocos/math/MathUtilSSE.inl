@@ -153,5 +153,140 @@ void MathUtil::transformVec4(const __m128 m[4], const __m128& v, __m128& dst)
 
 #endif
 
+#ifdef INCLUDE_SSE2
+
+// Batches of vertices and indices. Each position is transformed with the
+// products and sums in the order of MathUtilC::transformVec4(), without fused
+// multiply-add, so the results are the same bits as the scalar path.
+class MathUtilSSE2
+{
+public:
+    inline static void transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride);
+
+    inline static void offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count);
+
+private:
+    inline static __m128 transformPosition(const __m128 c[4], __m128 keep, __m128 v);
+};
+
+// x, y, z of the first 4 floats of a vertex transformed by c, the 4th kept
+inline __m128 MathUtilSSE2::transformPosition(const __m128 c[4], __m128 keep, __m128 v)
+{
+    __m128 r = _mm_mul_ps(c[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(c[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm_add_ps(r, c[3]);
+    return _mm_or_ps(_mm_and_ps(keep, r), _mm_andnot_ps(keep, v));
+}
+
+inline void MathUtilSSE2::transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride)
+{
+    if (stride < 16 || stride % 4 != 0)
+    {
+        MathUtilC::transformVertices(m, src, dst, count, stride);
+        return;
+    }
+
+    const __m128 c[4] = { _mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12) };
+    const __m128 keep = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    if (stride == 24 && s != d)
+    {
+        // V3F_C4B_T2F: position and color, then the texture coordinates
+        for (size_t i = 0; i < count; ++i, s += 24, d += 24)
+        {
+            __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(s));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 16), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 16)));
+            _mm_storeu_ps(reinterpret_cast<float*>(d), transformPosition(c, keep, v));
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i, s += stride, d += stride)
+    {
+        __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(s));
+        if (s != d)
+        {
+            memcpy(d + 16, s + 16, stride - 16);
+        }
+        _mm_storeu_ps(reinterpret_cast<float*>(d), transformPosition(c, keep, v));
+    }
+}
+
+inline void MathUtilSSE2::offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count)
+{
+    const __m128i o = _mm_set1_epi16(static_cast<short>(offset));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi16(v, o));
+    }
+    MathUtilC::offsetIndices(src + i, offset, dst + i, count - i);
+}
+
+#endif
+
+#ifdef INCLUDE_AVX2
+
+// Two vertices per 256 bits, compiled for AVX2 whatever the flags of the
+// build, called only once MathUtil::isAVX2Enabled() said so.
+class MathUtilAVX2
+{
+public:
+    CC_TARGET_AVX2 static void transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride);
+
+    CC_TARGET_AVX2 static void offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count);
+};
+
+CC_TARGET_AVX2 void MathUtilAVX2::transformVertices(const float* m, const void* src, void* dst, size_t count, size_t stride)
+{
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    if (stride != 24 || s == d)
+    {
+        MathUtilSSE2::transformVertices(m, src, dst, count, stride);
+        return;
+    }
+
+    const __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m));
+    const __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 4));
+    const __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 8));
+    const __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 12));
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, s += 48, d += 48)
+    {
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(reinterpret_cast<const float*>(s))),
+                                        _mm_loadu_ps(reinterpret_cast<const float*>(s + 24)), 1);
+        __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                       _mm256_mul_ps(c0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0))),
+                       _mm256_mul_ps(c1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)))),
+                       _mm256_mul_ps(c2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)))), c3);
+        // x, y, z of both vertices from r, the colors from v
+        r = _mm256_blend_ps(v, r, 0x77);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 16), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 16)));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 40), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + 40)));
+        _mm_storeu_ps(reinterpret_cast<float*>(d), _mm256_castps256_ps128(r));
+        _mm_storeu_ps(reinterpret_cast<float*>(d + 24), _mm256_extractf128_ps(r, 1));
+    }
+    MathUtilSSE2::transformVertices(m, s, d, count - i, stride);
+}
+
+CC_TARGET_AVX2 void MathUtilAVX2::offsetIndices(const unsigned short* src, unsigned short offset, unsigned short* dst, size_t count)
+{
+    const __m256i o = _mm256_set1_epi16(static_cast<short>(offset));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi16(v, o));
+    }
+    MathUtilSSE2::offsetIndices(src + i, offset, dst + i, count - i);
+}
+
+#endif
+
 
 NS_CC_MATH_END
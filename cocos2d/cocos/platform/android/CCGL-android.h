@@ -65,6 +65,13 @@ extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT;
 #define glBindVertexArrayOES glBindVertexArrayOESEXT
 #define glDeleteVertexArraysOES glDeleteVertexArraysOESEXT
 
+// instanced arrays of OpenGL ES 3.0, or of GL_EXT_instanced_arrays,
+// null without either, see Configuration::supportsInstancing()
+typedef void (GL_APIENTRYP CC_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei instanceCount);
+typedef void (GL_APIENTRYP CC_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+extern CC_PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstancedCC;
+extern CC_PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisorCC;
+
 
 #endif // CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 
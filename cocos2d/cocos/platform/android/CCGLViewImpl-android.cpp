@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "CCGL.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <android/log.h>
 
 // <EGL/egl.h> exists since android 2.3
@@ -42,11 +43,26 @@ THE SOFTWARE.
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
+CC_PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstancedCC = 0;
+CC_PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisorCC = 0;
 
 void initExtensions() {
      glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
      glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYOESPROC)eglGetProcAddress("glBindVertexArrayOES");
      glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC)eglGetProcAddress("glDeleteVertexArraysOES");
+
+     // the context is current, an OpenGL ES 3.0 one has the entry points in core
+     const char* version = (const char*)glGetString(GL_VERSION);
+     if (version && strncmp(version, "OpenGL ES 3", 11) == 0)
+     {
+         glDrawElementsInstancedCC = (CC_PFNGLDRAWELEMENTSINSTANCEDPROC)eglGetProcAddress("glDrawElementsInstanced");
+         glVertexAttribDivisorCC = (CC_PFNGLVERTEXATTRIBDIVISORPROC)eglGetProcAddress("glVertexAttribDivisor");
+     }
+     else
+     {
+         glDrawElementsInstancedCC = (CC_PFNGLDRAWELEMENTSINSTANCEDPROC)eglGetProcAddress("glDrawElementsInstancedEXT");
+         glVertexAttribDivisorCC = (CC_PFNGLVERTEXATTRIBDIVISORPROC)eglGetProcAddress("glVertexAttribDivisorEXT");
+     }
 }
 
 NS_CC_BEGIN
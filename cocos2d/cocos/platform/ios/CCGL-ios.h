@@ -35,6 +35,9 @@ THE SOFTWARE.
 #define glBindVertexArray           glBindVertexArrayOES
 #define glMapBuffer                 glMapBufferOES
 #define glUnmapBuffer               glUnmapBufferOES
+// instanced arrays, see Configuration::supportsInstancing()
+#define glDrawElementsInstancedCC   glDrawElementsInstancedEXT
+#define glVertexAttribDivisorCC     glVertexAttribDivisorEXT
 
 #define GL_DEPTH24_STENCIL8         GL_DEPTH24_STENCIL8_OES
 #define GL_WRITE_ONLY               GL_WRITE_ONLY_OES
@@ -32,6 +32,10 @@ THE SOFTWARE.
 
 #define CC_GL_DEPTH24_STENCIL8      GL_DEPTH24_STENCIL8
 
+// instanced arrays, see Configuration::supportsInstancing()
+#define glDrawElementsInstancedCC   glDrawElementsInstancedARB
+#define glVertexAttribDivisorCC     glVertexAttribDivisorARB
+
 #endif // CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
 
 #endif // __CCGL_H__
@@ -42,6 +42,9 @@ THE SOFTWARE.
 #define glClearDepthf                   glClearDepth
 #define glDepthRangef                   glDepthRange
 #define glReleaseShaderCompiler(xxx)
+// instanced arrays, see Configuration::supportsInstancing()
+#define glDrawElementsInstancedCC       glDrawElementsInstancedARB
+#define glVertexAttribDivisorCC         glVertexAttribDivisorARB
 
 
 #endif // __PLATFORM_MAC_CCGL_H__
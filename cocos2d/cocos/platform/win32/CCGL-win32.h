@@ -33,6 +33,10 @@ THE SOFTWARE.
 
 #define CC_GL_DEPTH24_STENCIL8      GL_DEPTH24_STENCIL8
 
+// instanced arrays, see Configuration::supportsInstancing()
+#define glDrawElementsInstancedCC   glDrawElementsInstancedARB
+#define glVertexAttribDivisorCC     glVertexAttribDivisorARB
+
 #endif // CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
 
 #endif // __CCGL_H__
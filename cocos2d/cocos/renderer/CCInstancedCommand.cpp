@@ -0,0 +1,117 @@
+/****************************************************************************
+ Copyright (c) 2016 cocos2d-x.org
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "renderer/CCInstancedCommand.h"
+
+#include <math.h>
+
+#include "renderer/CCGLProgramState.h"
+#include "base/CCConfiguration.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+InstancedCommand::InstancedCommand()
+: _textureID(0)
+, _glProgramState(nullptr)
+, _blendType(BlendFunc::DISABLE)
+, _instances(nullptr)
+, _instanceCount(0)
+{
+    _type = RenderCommand::Type::INSTANCED_COMMAND;
+}
+
+InstancedCommand::~InstancedCommand()
+{
+}
+
+void InstancedCommand::init(float globalOrder, GLuint textureID, GLProgramState* glProgramState, const BlendFunc& blendType, const Instance* instances, ssize_t instanceCount,
+                            const Mat4& mv, uint32_t flags)
+{
+    CCASSERT(glProgramState, "Invalid GLProgramState");
+    CCASSERT(instanceCount >= 0, "Invalid instance count");
+
+    RenderCommand::init(globalOrder, mv, flags);
+
+    _textureID = textureID;
+    _glProgramState = glProgramState;
+    _blendType = blendType;
+    _instances = instances;
+    _instanceCount = instanceCount;
+    _mv = mv;
+
+    if (!Configuration::getInstance()->supportsInstancing())
+    {
+        // the sprites' shader, so that the quads batch with the sprites of the texture
+        expandToQuads();
+        auto quadShader = GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP);
+        _quadCommand.init(globalOrder, textureID, quadShader, blendType, _quads.data(), instanceCount, mv, flags);
+    }
+}
+
+void InstancedCommand::expandToQuads()
+{
+    _quads.resize(_instanceCount);
+    for (ssize_t i = 0; i < _instanceCount; ++i)
+    {
+        const Instance& instance = _instances[i];
+        V3F_C4B_T2F_Quad& quad = _quads[i];
+
+        // as the instanced shader does
+        float angle = -CC_DEGREES_TO_RADIANS(instance.rotation);
+        float c = cosf(angle);
+        float s = sinf(angle);
+        float halfWidth = instance.size.x * 0.5f;
+        float halfHeight = instance.size.y * 0.5f;
+        float cx = c * halfWidth, sx = s * halfWidth;
+        float cy = c * halfHeight, sy = s * halfHeight;
+        float x = instance.position.x, y = instance.position.y;
+
+        quad.bl.vertices.set(x - cx + sy, y - sx - cy, 0.0f);
+        quad.tl.vertices.set(x - cx - sy, y - sx + cy, 0.0f);
+        quad.br.vertices.set(x + cx + sy, y + sx - cy, 0.0f);
+        quad.tr.vertices.set(x + cx - sy, y + sx + cy, 0.0f);
+
+        quad.bl.colors = quad.tl.colors = quad.br.colors = quad.tr.colors = instance.color;
+
+        float left = instance.texRect.origin.x;
+        float right = left + instance.texRect.size.width;
+        float top = instance.texRect.origin.y;
+        float bottom = top + instance.texRect.size.height;
+        quad.bl.texCoords = Tex2F(left, bottom);
+        quad.tl.texCoords = Tex2F(left, top);
+        quad.br.texCoords = Tex2F(right, bottom);
+        quad.tr.texCoords = Tex2F(right, top);
+    }
+}
+
+void InstancedCommand::bindAttribLocations(GLProgram* glProgram)
+{
+    glProgram->bindAttribLocation("a_instanceColor", ATTRIB_INSTANCE_COLOR);
+    glProgram->bindAttribLocation("a_instanceTexRect", ATTRIB_INSTANCE_TEX_RECT);
+    glProgram->bindAttribLocation("a_instanceRect", ATTRIB_INSTANCE_RECT);
+    glProgram->bindAttribLocation("a_instanceRotation", ATTRIB_INSTANCE_ROTATION);
+}
+
+NS_CC_END
@@ -0,0 +1,141 @@
+/****************************************************************************
+ Copyright (c) 2016 cocos2d-x.org
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _CC_INSTANCED_COMMAND_H_
+#define _CC_INSTANCED_COMMAND_H_
+
+#include <vector>
+
+#include "renderer/CCRenderCommand.h"
+#include "renderer/CCGLProgram.h"
+#include "renderer/CCQuadCommand.h"
+
+/**
+ * @addtogroup renderer
+ * @{
+ */
+
+NS_CC_BEGIN
+
+/**
+ Command used to render many copies of one textured quad, as the sprites of a bullet hell.
+ Each instance only has its position, size, rotation, color and texture rect. With
+ Configuration::supportsInstancing(), the renderer uploads them as they are and draws them
+ all with glDrawElementsInstanced(), the quads being made by the shader.
+ Otherwise the command expands the instances to quads when initialized, and they are batched
+ as a QuadCommand, with the neighbouring commands of the same material.
+ */
+class CC_DLL InstancedCommand : public RenderCommand
+{
+public:
+    /** One copy of the quad, as the instanced shader reads it. */
+    struct Instance
+    {
+        /** Center of the quad, in the space of the model view. */
+        Vec2 position;
+        /** Size of the quad, it follows position in the instance buffer. */
+        Vec2 size;
+        /** Rotation around the center in degrees, clockwise as Node::setRotation(). */
+        float rotation;
+        /** Multiplies the texture, premultiplied by the alpha for a premultiplied texture. */
+        Color4B color;
+        /** Texture coordinates of the top left corner of the quad, then the width and height. */
+        Rect texRect;
+    };
+
+    /** Vertex attribute slots of the instanced shader, see bindAttribLocations(). */
+    enum
+    {
+        /** corner of the quad, per vertex */
+        ATTRIB_CORNER = GLProgram::VERTEX_ATTRIB_POSITION,
+        ATTRIB_INSTANCE_COLOR = GLProgram::VERTEX_ATTRIB_COLOR,
+        ATTRIB_INSTANCE_TEX_RECT = GLProgram::VERTEX_ATTRIB_TEX_COORD,
+        ATTRIB_INSTANCE_RECT = GLProgram::VERTEX_ATTRIB_TEX_COORD1,
+        ATTRIB_INSTANCE_ROTATION = GLProgram::VERTEX_ATTRIB_TEX_COORD2,
+    };
+
+    /**Constructor.*/
+    InstancedCommand();
+    /**Destructor.*/
+    ~InstancedCommand();
+
+    /** Initializes the command.
+     @param globalOrder GlobalZOrder of the command.
+     @param textureID The openGL handle of the used texture.
+     @param glProgramState The instanced shader and its uniforms, as GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_INSTANCED.
+     @param blendType Blend function for the command.
+     @param instances Rendered instances for the command, read when the command is rendered.
+     @param instanceCount The number of instances.
+     @param mv ModelView matrix for the command.
+     @param flags to indicate that the command is using 3D rendering or not.
+     */
+    void init(float globalOrder, GLuint textureID, GLProgramState* glProgramState, const BlendFunc& blendType, const Instance* instances, ssize_t instanceCount,
+              const Mat4& mv, uint32_t flags);
+
+    /**Get the openGL texture handle.*/
+    inline GLuint getTextureID() const { return _textureID; }
+    /**Get the glprogramstate.*/
+    inline GLProgramState* getGLProgramState() const { return _glProgramState; }
+    /**Get the blend function.*/
+    inline BlendFunc getBlendType() const { return _blendType; }
+    /**Get the pointer of the rendered instances.*/
+    inline const Instance* getInstances() const { return _instances; }
+    /**Get the number of instances.*/
+    inline ssize_t getInstanceCount() const { return _instanceCount; }
+    /**Get the model view matrix.*/
+    inline const Mat4& getModelView() const { return _mv; }
+
+    /** Without instancing, the instances expanded to quads, with the shader of the sprites. */
+    inline QuadCommand* getQuadCommand() { return &_quadCommand; }
+
+    /**
+     Binds the per instance attributes of the instanced shader to their slots, a_instanceRect,
+     a_instanceRotation, a_instanceColor and a_instanceTexRect. To be called for a custom instanced
+     shader as well, before it is linked.
+     */
+    static void bindAttribLocations(GLProgram* glProgram);
+
+protected:
+    // writes the 4 vertices of each instance in _quads
+    void expandToQuads();
+
+    GLuint _textureID;
+    GLProgramState* _glProgramState;
+    BlendFunc _blendType;
+    const Instance* _instances;
+    ssize_t _instanceCount;
+    Mat4 _mv;
+
+    // the fallback, kept from frame to frame
+    std::vector<V3F_C4B_T2F_Quad> _quads;
+    QuadCommand _quadCommand;
+};
+
+NS_CC_END
+
+/**
+ end of support group
+ @}
+ */
+#endif //_CC_INSTANCED_COMMAND_H_
@@ -33,6 +33,7 @@
 #include "renderer/CCGroupCommand.h"
 #include "renderer/CCPrimitiveCommand.h"
 #include "renderer/CCMeshCommand.h"
+#include "renderer/CCInstancedCommand.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCMaterial.h"
 #include "renderer/CCTechnique.h"
@@ -45,6 +46,7 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventType.h"
+#include "math/MathUtil.h"
 #include "2d/CCCamera.h"
 #include "2d/CCScene.h"
 
@@ -61,6 +63,49 @@ static bool compare3DCommand(RenderCommand* a, RenderCommand* b)
     return  a->getDepth() > b->getDepth();
 }
 
+// batches looked back by a command in search of its material, see Renderer::reorderByMaterial()
+static const int REORDER_MAX_LOOKBACK = 32;
+
+// the bounds of count vertices once transformed by mv, false unless they lie on one plane z of the world
+static bool computeWorldBounds(const V3F_C4B_T2F* verts, ssize_t count, const Mat4& mv, float* z, float* minX, float* minY, float* maxX, float* maxY)
+{
+    if (count <= 0)
+    {
+        return false;
+    }
+
+    Vec3 lo = verts[0].vertices;
+    Vec3 hi = lo;
+    for (ssize_t i = 1; i < count; ++i)
+    {
+        const Vec3& v = verts[i].vertices;
+        lo.x = std::min(lo.x, v.x); hi.x = std::max(hi.x, v.x);
+        lo.y = std::min(lo.y, v.y); hi.y = std::max(hi.y, v.y);
+        lo.z = std::min(lo.z, v.z); hi.z = std::max(hi.z, v.z);
+    }
+
+    // the corners of the box, transformed
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        Vec3 p((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+        mv.transformPoint(&p);
+        if (corner == 0)
+        {
+            *z = p.z;
+            *minX = *maxX = p.x;
+            *minY = *maxY = p.y;
+            continue;
+        }
+        if (p.z != *z)
+        {
+            return false;
+        }
+        *minX = std::min(*minX, p.x); *maxX = std::max(*maxX, p.x);
+        *minY = std::min(*minY, p.y); *maxY = std::max(*maxY, p.y);
+    }
+    return true;
+}
+
 // queue
 RenderQueue::RenderQueue()
 {
@@ -206,9 +251,15 @@ Renderer::Renderer()
 ,_filledVertex(0)
 ,_filledIndex(0)
 ,_numberQuads(0)
+,_vertexStream(GL_ARRAY_BUFFER)
+,_indexStream(GL_ELEMENT_ARRAY_BUFFER)
+,_instanceCornersVBO(0)
+,_instanceStream(GL_ARRAY_BUFFER)
 ,_glViewAssigned(false)
 ,_isRendering(false)
 ,_isDepthTestFor2D(false)
+,_reorderByMaterial(false)
+,_drawCallsSavedByReordering(0)
 #if CC_ENABLE_CACHE_TEXTURE_DATA
 ,_cacheTextureListener(nullptr)
 #endif
@@ -221,6 +272,10 @@ Renderer::Renderer()
     _renderGroups.push_back(defaultRenderQueue);
     _batchedCommands.reserve(BATCH_QUADCOMMAND_RESEVER_SIZE);
 
+    _verts.resize(VBO_SIZE);
+    _indices.resize(INDEX_VBO_SIZE);
+    _quadVerts.resize(VBO_SIZE);
+
     // default clear color
     _clearColor = Color4F::BLACK;
 }
@@ -230,8 +285,8 @@ Renderer::~Renderer()
     _renderGroups.clear();
     _groupCommandManager->release();
     
-    glDeleteBuffers(2, _buffersVBO);
-    glDeleteBuffers(2, _quadbuffersVBO);
+    glDeleteBuffers(1, &_quadIndicesVBO);
+    glDeleteBuffers(1, &_instanceCornersVBO);
     
     if (Configuration::getInstance()->supportsShareableVAO())
     {
@@ -249,6 +304,9 @@ void Renderer::initGLView()
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     _cacheTextureListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom* event){
         /** listen the event that renderer was recreated on Android/WP8 */
+        _vertexStream.invalidate();
+        _indexStream.invalidate();
+        _instanceStream.invalidate();
         this->setupBuffer();
     });
     
@@ -274,6 +332,22 @@ void Renderer::initGLView()
 
 void Renderer::setupBuffer()
 {
+    //the batches of both commands are streamed, whatever their size
+    _vertexStream.init(sizeof(_verts[0]) * VBO_SIZE);
+    _indexStream.init(sizeof(_indices[0]) * INDEX_VBO_SIZE);
+
+    if (Configuration::getInstance()->supportsInstancing())
+    {
+        //the corners of the quad of every instance, in the order of V3F_C4B_T2F_Quad
+        static const GLfloat corners[] = { -0.5f, -0.5f,  -0.5f, 0.5f,  0.5f, -0.5f,  0.5f, 0.5f };
+        glGenBuffers(1, &_instanceCornersVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, _instanceCornersVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        _instanceStream.init(sizeof(InstancedCommand::Instance) * VBO_SIZE / 4);
+    }
+
     if(Configuration::getInstance()->supportsShareableVAO())
     {
         setupVBOAndVAO();
@@ -286,57 +360,26 @@ void Renderer::setupBuffer()
 
 void Renderer::setupVBOAndVAO()
 {
-    //generate vbo and vao for trianglesCommand
+    //generate vao for trianglesCommand, the buffers are bound for each batch
     glGenVertexArrays(1, &_buffersVAO);
     GL::bindVAO(_buffersVAO);
 
-    glGenBuffers(2, &_buffersVBO[0]);
-
-    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_verts[0]) * VBO_SIZE, _verts, GL_DYNAMIC_DRAW);
-
-    // vertices
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_POSITION);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, vertices));
-
-    // colors
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_COLOR);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, colors));
-
-    // tex coords
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, texCoords));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * INDEX_VBO_SIZE, _indices, GL_STATIC_DRAW);
-
-    // Must unbind the VAO before changing the element buffer.
     GL::bindVAO(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    //generate vbo and vao for quadCommand
+    //generate vao for quadCommand, with the indices of every quad
     glGenVertexArrays(1, &_quadVAO);
     GL::bindVAO(_quadVAO);
     
-    glGenBuffers(2, &_quadbuffersVBO[0]);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, _quadbuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_quadVerts[0]) * VBO_SIZE, _quadVerts, GL_DYNAMIC_DRAW);
-    
-    // vertices
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_POSITION);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, vertices));
-    
-    // colors
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_COLOR);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, colors));
-    
-    // tex coords
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, texCoords));
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
+    glGenBuffers(1, &_quadIndicesVBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIndicesVBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_quadIndices[0]) * INDEX_VBO_SIZE, _quadIndices, GL_STATIC_DRAW);
     
     // Must unbind the VAO before changing the element buffer.
@@ -349,8 +392,7 @@ void Renderer::setupVBOAndVAO()
 
 void Renderer::setupVBO()
 {
-    glGenBuffers(2, &_buffersVBO[0]);
-    glGenBuffers(2, &_quadbuffersVBO[0]);
+    glGenBuffers(1, &_quadIndicesVBO);
     mapBuffers();
 }
 
@@ -359,18 +401,7 @@ void Renderer::mapBuffers()
     // Avoid changing the element buffer for whatever VAO might be bound.
     GL::bindVAO(0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_verts[0]) * VBO_SIZE, _verts, GL_DYNAMIC_DRAW);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, _quadbuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_quadVerts[0]) * VBO_SIZE, _quadVerts, GL_DYNAMIC_DRAW);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * INDEX_VBO_SIZE, _indices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIndicesVBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_quadIndices[0]) * INDEX_VBO_SIZE, _quadIndices, GL_STATIC_DRAW);
     
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -378,9 +409,26 @@ void Renderer::mapBuffers()
     CHECK_GL_ERROR_DEBUG();
 }
 
+void Renderer::setVertexAttribPointers(GLintptr offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexStream.getBuffer());
+
+    // vertices
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) (offset + offsetof(V3F_C4B_T2F, vertices)));
+
+    // colors
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(V3F_C4B_T2F), (GLvoid*) (offset + offsetof(V3F_C4B_T2F, colors)));
+
+    // tex coords
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) (offset + offsetof(V3F_C4B_T2F, texCoords)));
+}
+
+// the recording of the calling thread, see beginRecording()
+static thread_local Renderer::Recording* s_recording = nullptr;
+
 void Renderer::addCommand(RenderCommand* command)
 {
-    int renderQueue =_commandGroupStack.top();
+    int renderQueue = s_recording ? s_recording->groupStack.back() : _commandGroupStack.top();
     addCommand(command, renderQueue);
 }
 
@@ -390,21 +438,53 @@ void Renderer::addCommand(RenderCommand* command, int renderQueue)
     CCASSERT(renderQueue >=0, "Invalid render queue");
     CCASSERT(command->getType() != RenderCommand::Type::UNKNOWN_COMMAND, "Invalid Command Type");
 
+    if (s_recording)
+    {
+        s_recording->commands.push_back(std::make_pair(command, renderQueue));
+        return;
+    }
     _renderGroups[renderQueue].push_back(command);
 }
 
 void Renderer::pushGroup(int renderQueueID)
 {
     CCASSERT(!_isRendering, "Cannot change render queue while rendering");
+    if (s_recording)
+    {
+        s_recording->groupStack.push_back(renderQueueID);
+        return;
+    }
     _commandGroupStack.push(renderQueueID);
 }
 
 void Renderer::popGroup()
 {
     CCASSERT(!_isRendering, "Cannot change render queue while rendering");
+    if (s_recording)
+    {
+        CCASSERT(s_recording->groupStack.size() > 1, "Cannot pop the render queue the recording started in");
+        s_recording->groupStack.pop_back();
+        return;
+    }
     _commandGroupStack.pop();
 }
 
+void Renderer::beginRecording(Recording* recording)
+{
+    CCASSERT(recording && !recording->groupStack.empty(), "Invalid recording");
+    s_recording = recording;
+}
+
+void Renderer::endRecording()
+{
+    s_recording = nullptr;
+}
+
+int Renderer::getCurrentRenderQueue() const
+{
+    return s_recording ? s_recording->groupStack.back() : _commandGroupStack.top();
+}
+
 int Renderer::createRenderQueue()
 {
     RenderQueue newRenderQueue;
@@ -424,25 +504,30 @@ void Renderer::processRenderCommand(RenderCommand* command)
         //Process triangle command
         auto cmd = static_cast<TrianglesCommand*>(command);
         
-        //Draw batched Triangles if necessary
-        if(cmd->isSkipBatching() || _filledVertex + cmd->getVertexCount() > VBO_SIZE || _filledIndex + cmd->getIndexCount() > INDEX_VBO_SIZE)
+        //Draw batched Triangles if necessary, the indices grow as needed
+        if(cmd->isSkipBatching() || _filledVertex + cmd->getVertexCount() > VBO_SIZE)
         {
-            CCASSERT(cmd->getVertexCount()>= 0 && cmd->getVertexCount() < VBO_SIZE, "VBO for vertex is not big enough, please break the data down or use customized render command");
-            CCASSERT(cmd->getIndexCount()>= 0 && cmd->getIndexCount() < INDEX_VBO_SIZE, "VBO for index is not big enough, please break the data down or use customized render command");
             //Draw batched Triangles if VBO is full
             drawBatchedTriangles();
         }
         
-        //Batch Triangles
-        _batchedCommands.push_back(cmd);
-        
-        fillVerticesAndIndices(cmd);
-        
-        if(cmd->isSkipBatching())
+        if(cmd->getVertexCount() > VBO_SIZE)
         {
-            drawBatchedTriangles();
+            //Too large for any batch, drawn on its own
+            drawOversizedTriangles(cmd);
+        }
+        else
+        {
+            //Batch Triangles
+            _batchedCommands.push_back(cmd);
+            
+            fillVerticesAndIndices(cmd);
+            
+            if(cmd->isSkipBatching())
+            {
+                drawBatchedTriangles();
+            }
         }
-        
     }
     else if ( RenderCommand::Type::QUAD_COMMAND == commandType )
     {
@@ -453,10 +538,9 @@ void Renderer::processRenderCommand(RenderCommand* command)
         //Process quad command
         auto cmd = static_cast<QuadCommand*>(command);
         
-        //Draw batched quads if necessary
+        //Draw batched quads if necessary, a larger command has a batch of its own
         if(cmd->isSkipBatching()|| (_numberQuads + cmd->getQuadCount()) * 4 > VBO_SIZE )
         {
-            CCASSERT(cmd->getQuadCount()>= 0 && cmd->getQuadCount() * 4 < VBO_SIZE, "VBO for vertex is not big enough, please break the data down or use customized render command");
             //Draw batched quads if VBO is full
             drawBatchedQuads();
         }
@@ -523,6 +607,20 @@ void Renderer::processRenderCommand(RenderCommand* command)
         auto cmd = static_cast<PrimitiveCommand*>(command);
         cmd->execute();
     }
+    else if(RenderCommand::Type::INSTANCED_COMMAND == commandType)
+    {
+        auto cmd = static_cast<InstancedCommand*>(command);
+        if (Configuration::getInstance()->supportsInstancing())
+        {
+            flush();
+            drawInstances(cmd);
+        }
+        else
+        {
+            //the instances were expanded to quads, batched as any others
+            processRenderCommand(cmd->getQuadCommand());
+        }
+    }
     else
     {
         CCLOGERROR("Unknown commands in renderQueue");
@@ -709,6 +807,10 @@ void Renderer::render()
         for (auto &renderqueue : _renderGroups)
         {
             renderqueue.sort();
+            if (_reorderByMaterial)
+            {
+                reorderByMaterial(renderqueue);
+            }
         }
         visitRenderQueue(_renderGroups[0]);
     }
@@ -776,22 +878,12 @@ void Renderer::setDepthTest(bool enable)
 
 void Renderer::fillVerticesAndIndices(const TrianglesCommand* cmd)
 {
-    memcpy(_verts + _filledVertex, cmd->getVertices(), sizeof(V3F_C4B_T2F) * cmd->getVertexCount());
-    const Mat4& modelView = cmd->getModelView();
-    
-    for(ssize_t i=0; i< cmd->getVertexCount(); ++i)
+    if (_filledIndex + cmd->getIndexCount() > static_cast<ssize_t>(_indices.size()))
     {
-        V3F_C4B_T2F *q = &_verts[i + _filledVertex];
-        Vec3 *vec1 = (Vec3*)&q->vertices;
-        modelView.transformPoint(vec1);
-    }
-    
-    const unsigned short* indices = cmd->getIndices();
-    //fill index
-    for(ssize_t i=0; i< cmd->getIndexCount(); ++i)
-    {
-        _indices[_filledIndex + i] = _filledVertex + indices[i];
+        _indices.resize(std::max(_indices.size() * 2, static_cast<size_t>(_filledIndex + cmd->getIndexCount())));
     }
+    MathUtil::transformVertices(cmd->getModelView().m, cmd->getVertices(), _verts.data() + _filledVertex, cmd->getVertexCount(), sizeof(V3F_C4B_T2F));
+    MathUtil::offsetIndices(cmd->getIndices(), static_cast<GLushort>(_filledVertex), _indices.data() + _filledIndex, cmd->getIndexCount());
     
     _filledVertex += cmd->getVertexCount();
     _filledIndex += cmd->getIndexCount();
@@ -799,17 +891,127 @@ void Renderer::fillVerticesAndIndices(const TrianglesCommand* cmd)
 
 void Renderer::fillQuads(const QuadCommand *cmd)
 {
-    const Mat4& modelView = cmd->getModelView();
-    const V3F_C4B_T2F* quads =  (V3F_C4B_T2F*)cmd->getQuads();
-    for(ssize_t i=0; i< cmd->getQuadCount() * 4; ++i)
+    if ((_numberQuads + cmd->getQuadCount()) * 4 > static_cast<ssize_t>(_quadVerts.size()))
     {
-        _quadVerts[i + _numberQuads * 4] = quads[i];
-        modelView.transformPoint(quads[i].vertices,&(_quadVerts[i + _numberQuads * 4].vertices));
+        _quadVerts.resize((_numberQuads + cmd->getQuadCount()) * 4);
     }
+    MathUtil::transformVertices(cmd->getModelView().m, cmd->getQuads(), _quadVerts.data() + _numberQuads * 4, cmd->getQuadCount() * 4, sizeof(V3F_C4B_T2F));
     
     _numberQuads += cmd->getQuadCount();
 }
 
+void Renderer::reorderByMaterial(RenderQueue& queue)
+{
+    // 2D commands all lie on planes of the world: two commands on one plane, disjoint there,
+    // are disjoint on screen whatever the camera, so their order does not matter
+    auto& commands = queue.getSubQueue(RenderQueue::QUEUE_GROUP::GLOBALZ_ZERO);
+    const ssize_t count = commands.size();
+    if (count < 3)
+    {
+        return;
+    }
+
+    _reorderBatches.clear();
+    _reorderBatchOfCommand.resize(count);
+    ssize_t drawCallsBefore = 0;
+
+    for (ssize_t i = 0; i < count; ++i)
+    {
+        auto command = commands[i];
+        MaterialBatch batch;
+        batch.type = command->getType();
+        batch.materialID = MATERIAL_ID_DO_NOT_BATCH;
+        batch.batchable = false;
+        batch.bounded = false;
+        batch.z = batch.minX = batch.minY = batch.maxX = batch.maxY = 0;
+        batch.commands = 1;
+        if (batch.type == RenderCommand::Type::QUAD_COMMAND)
+        {
+            auto cmd = static_cast<QuadCommand*>(command);
+            batch.materialID = cmd->getMaterialID();
+            batch.bounded = computeWorldBounds((const V3F_C4B_T2F*)cmd->getQuads(), cmd->getQuadCount() * 4, cmd->getModelView(),
+                                               &batch.z, &batch.minX, &batch.minY, &batch.maxX, &batch.maxY);
+        }
+        else if (batch.type == RenderCommand::Type::TRIANGLES_COMMAND)
+        {
+            auto cmd = static_cast<TrianglesCommand*>(command);
+            batch.materialID = cmd->getMaterialID();
+            batch.bounded = computeWorldBounds(cmd->getVertices(), cmd->getVertexCount(), cmd->getModelView(),
+                                               &batch.z, &batch.minX, &batch.minY, &batch.maxX, &batch.maxY);
+        }
+        batch.batchable = batch.materialID != MATERIAL_ID_DO_NOT_BATCH && !command->isSkipBatching();
+
+        if (i == 0 || !batch.batchable || !_reorderBatches[_reorderBatchOfCommand[i - 1]].batchable ||
+            _reorderBatches[_reorderBatchOfCommand[i - 1]].type != batch.type ||
+            _reorderBatches[_reorderBatchOfCommand[i - 1]].materialID != batch.materialID)
+        {
+            ++drawCallsBefore;
+        }
+
+        // the last batch of the material, if the command can be moved there
+        int target = -1;
+        if (batch.batchable)
+        {
+            int lookback = 0;
+            for (int k = static_cast<int>(_reorderBatches.size()) - 1; k >= 0 && lookback < REORDER_MAX_LOOKBACK; --k, ++lookback)
+            {
+                const auto& other = _reorderBatches[k];
+                if (other.batchable && other.type == batch.type && other.materialID == batch.materialID)
+                {
+                    target = k;
+                    break;
+                }
+                bool disjoint = batch.bounded && other.bounded && batch.z == other.z &&
+                    (batch.maxX <= other.minX || other.maxX <= batch.minX || batch.maxY <= other.minY || other.maxY <= batch.minY);
+                if (!disjoint)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (target >= 0)
+        {
+            auto& joined = _reorderBatches[target];
+            ++joined.commands;
+            if (!batch.bounded || !joined.bounded || batch.z != joined.z)
+            {
+                joined.bounded = false;
+            }
+            else
+            {
+                joined.minX = std::min(joined.minX, batch.minX); joined.maxX = std::max(joined.maxX, batch.maxX);
+                joined.minY = std::min(joined.minY, batch.minY); joined.maxY = std::max(joined.maxY, batch.maxY);
+            }
+            _reorderBatchOfCommand[i] = target;
+        }
+        else
+        {
+            _reorderBatches.push_back(batch);
+            _reorderBatchOfCommand[i] = static_cast<int>(_reorderBatches.size()) - 1;
+        }
+    }
+
+    // commands by batch, in their order within a batch: commands becomes the index of the next one
+    ssize_t drawCallsAfter = 0;
+    int first = 0;
+    for (auto& batch : _reorderBatches)
+    {
+        drawCallsAfter += batch.batchable ? 1 : batch.commands;
+        int next = first + batch.commands;
+        batch.commands = first;
+        first = next;
+    }
+    _reorderedCommands.resize(count);
+    for (ssize_t i = 0; i < count; ++i)
+    {
+        _reorderedCommands[_reorderBatches[_reorderBatchOfCommand[i]].commands++] = commands[i];
+    }
+    commands.swap(_reorderedCommands);
+
+    _drawCallsSavedByReordering += drawCallsBefore - drawCallsAfter;
+}
+
 void Renderer::drawBatchedTriangles()
 {
     //TODO: we can improve the draw performance by insert material switching command before hand.
@@ -825,50 +1027,19 @@ void Renderer::drawBatchedTriangles()
 
     if (Configuration::getInstance()->supportsShareableVAO())
     {
-        //Bind VAO
+        //Bind VAO, the element buffer below goes with it
         GL::bindVAO(_buffersVAO);
-        //Set VBO data
-        glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-
-        // option 1: subdata
-//        glBufferSubData(GL_ARRAY_BUFFER, sizeof(_quads[0])*start, sizeof(_quads[0]) * n , &_quads[start] );
-
-        // option 2: data
-//        glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
-
-        // option 3: orphaning + glMapBuffer
-        glBufferData(GL_ARRAY_BUFFER, sizeof(_verts[0]) * _filledVertex, nullptr, GL_DYNAMIC_DRAW);
-        void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        memcpy(buf, _verts, sizeof(_verts[0])* _filledVertex);
-        glUnmapBuffer(GL_ARRAY_BUFFER);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * _filledIndex, _indices, GL_STATIC_DRAW);
     }
     else
     {
-#define kQuadSize sizeof(_verts[0])
-        glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-
-        glBufferData(GL_ARRAY_BUFFER, sizeof(_verts[0]) * _filledVertex , _verts, GL_DYNAMIC_DRAW);
-
         GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
-
-        // vertices
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, vertices));
-
-        // colors
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, colors));
-
-        // tex coords
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, texCoords));
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * _filledIndex, _indices, GL_STATIC_DRAW);
     }
 
+    //Stream the batch, next to the previous ones
+    GLintptr vertexOffset = _vertexStream.upload(_verts.data(), sizeof(_verts[0]) * _filledVertex);
+    GLintptr indexOffset = _indexStream.upload(_indices.data(), sizeof(_indices[0]) * _filledIndex);
+    setVertexAttribPointers(vertexOffset);
+
     //Start drawing vertices in batch
     for(const auto& cmd : _batchedCommands)
     {
@@ -878,7 +1049,7 @@ void Renderer::drawBatchedTriangles()
             //Draw quads
             if(indexToDraw > 0)
             {
-                glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (startIndex*sizeof(_indices[0])) );
+                glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (indexOffset + startIndex*sizeof(_indices[0])) );
                 _drawnBatches++;
                 _drawnVertices += indexToDraw;
 
@@ -897,7 +1068,7 @@ void Renderer::drawBatchedTriangles()
     //Draw any remaining triangles
     if(indexToDraw > 0)
     {
-        glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (startIndex*sizeof(_indices[0])) );
+        glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (indexOffset + startIndex*sizeof(_indices[0])) );
         _drawnBatches++;
         _drawnVertices += indexToDraw;
     }
@@ -918,12 +1089,57 @@ void Renderer::drawBatchedTriangles()
     _filledIndex = 0;
 }
 
+void Renderer::drawOversizedTriangles(const TrianglesCommand* cmd)
+{
+    //The indices are 16 bits and relative to the command, they never reach past its first VBO_SIZE vertices
+    const ssize_t vertexCount = VBO_SIZE;
+    if (cmd->getIndexCount() <= 0)
+    {
+        return;
+    }
+
+    if (Configuration::getInstance()->supportsShareableVAO())
+    {
+        //Bind VAO, the element buffer below goes with it
+        GL::bindVAO(_buffersVAO);
+    }
+    else
+    {
+        GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+    }
+
+    //Stream the command as it is, its indices need no offset
+    MathUtil::transformVertices(cmd->getModelView().m, cmd->getVertices(), _verts.data(), vertexCount, sizeof(V3F_C4B_T2F));
+    GLintptr vertexOffset = _vertexStream.upload(_verts.data(), sizeof(_verts[0]) * vertexCount);
+    GLintptr indexOffset = _indexStream.upload(cmd->getIndices(), sizeof(_indices[0]) * cmd->getIndexCount());
+    setVertexAttribPointers(vertexOffset);
+
+    cmd->useMaterial();
+    _lastMaterialID = cmd->getMaterialID();
+
+    glDrawElements(GL_TRIANGLES, (GLsizei) cmd->getIndexCount(), GL_UNSIGNED_SHORT, (GLvoid*) indexOffset);
+    _drawnBatches++;
+    _drawnVertices += cmd->getIndexCount();
+
+    if (Configuration::getInstance()->supportsShareableVAO())
+    {
+        //Unbind VAO
+        GL::bindVAO(0);
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
 void Renderer::drawBatchedQuads()
 {
     //TODO: we can improve the draw performance by insert material switching command before hand.
     
-    ssize_t indexToDraw = 0;
-    int startIndex = 0;
+    ssize_t quadsToDraw = 0;
+    ssize_t startQuad = 0;
+    ssize_t baseQuad = 0;
     
     //Upload buffer to VBO
     if(_numberQuads <= 0 || _batchQuadCommands.empty())
@@ -935,66 +1151,29 @@ void Renderer::drawBatchedQuads()
     {
         //Bind VAO
         GL::bindVAO(_quadVAO);
-        //Set VBO data
-        glBindBuffer(GL_ARRAY_BUFFER, _quadbuffersVBO[0]);
-        
-        // option 1: subdata
-        //  glBufferSubData(GL_ARRAY_BUFFER, sizeof(_quads[0])*start, sizeof(_quads[0]) * n , &_quads[start] );
-        
-        // option 2: data
-        //  glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
-        
-        // option 3: orphaning + glMapBuffer
-        glBufferData(GL_ARRAY_BUFFER, sizeof(_quadVerts[0]) * _numberQuads * 4, nullptr, GL_DYNAMIC_DRAW);
-        void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        memcpy(buf, _quadVerts, sizeof(_quadVerts[0])* _numberQuads * 4);
-        glUnmapBuffer(GL_ARRAY_BUFFER);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
     }
     else
     {
-#define kQuadSize sizeof(_verts[0])
-        glBindBuffer(GL_ARRAY_BUFFER, _quadbuffersVBO[0]);
-        
-        glBufferData(GL_ARRAY_BUFFER, sizeof(_quadVerts[0]) * _numberQuads * 4 , _quadVerts, GL_DYNAMIC_DRAW);
-        
         GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
-        
-        // vertices
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, vertices));
-        
-        // colors
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, colors));
-        
-        // tex coords
-        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, texCoords));
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIndicesVBO);
     }
 
-
-    // FIXME: The logic of this code is confusing, and error prone
-    // Needs refactoring
+    //Stream the batch, next to the previous ones
+    GLintptr vertexOffset = _vertexStream.upload(_quadVerts.data(), sizeof(_quadVerts[0]) * _numberQuads * 4);
+    setVertexAttribPointers(vertexOffset);
 
     //Start drawing vertices in batch
     for(const auto& cmd : _batchQuadCommands)
     {
-        bool commandQueued = true;
         auto newMaterialID = cmd->getMaterialID();
         if(_lastMaterialID != newMaterialID || newMaterialID == MATERIAL_ID_DO_NOT_BATCH)
         {
             // flush buffer
-            if(indexToDraw > 0)
+            if(quadsToDraw > 0)
             {
-                glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (startIndex*sizeof(_indices[0])) );
-                _drawnBatches++;
-                _drawnVertices += indexToDraw;
-                
-                startIndex += indexToDraw;
-                indexToDraw = 0;
+                drawQuads(vertexOffset, baseQuad, startQuad, quadsToDraw);
+                startQuad += quadsToDraw;
+                quadsToDraw = 0;
             }
             
             //Use new material
@@ -1003,18 +1182,13 @@ void Renderer::drawBatchedQuads()
             cmd->useMaterial();
         }
 
-        if (commandQueued)
-        {
-            indexToDraw += cmd->getQuadCount() * 6;
-        }
+        quadsToDraw += cmd->getQuadCount();
     }
     
     //Draw any remaining quad
-    if(indexToDraw > 0)
+    if(quadsToDraw > 0)
     {
-        glDrawElements(GL_TRIANGLES, (GLsizei) indexToDraw, GL_UNSIGNED_SHORT, (GLvoid*) (startIndex*sizeof(_indices[0])) );
-        _drawnBatches++;
-        _drawnVertices += indexToDraw;
+        drawQuads(vertexOffset, baseQuad, startQuad, quadsToDraw);
     }
     
     if (Configuration::getInstance()->supportsShareableVAO())
@@ -1032,6 +1206,88 @@ void Renderer::drawBatchedQuads()
     _numberQuads = 0;
 }
 
+void Renderer::drawQuads(GLintptr vertexOffset, ssize_t& baseQuad, ssize_t firstQuad, ssize_t quadCount)
+{
+    //The quad indices reach VBO_SIZE vertices from the base of the attributes, past it the base moves on
+    const ssize_t maxQuads = VBO_SIZE / 4;
+    while (quadCount > 0)
+    {
+        if (firstQuad + std::min(quadCount, maxQuads) > baseQuad + maxQuads)
+        {
+            baseQuad = firstQuad;
+            setVertexAttribPointers(vertexOffset + baseQuad * 4 * sizeof(V3F_C4B_T2F));
+        }
+        ssize_t quads = std::min(quadCount, baseQuad + maxQuads - firstQuad);
+        glDrawElements(GL_TRIANGLES, (GLsizei) (quads * 6), GL_UNSIGNED_SHORT, (GLvoid*) ((firstQuad - baseQuad) * 6 * sizeof(_quadIndices[0])) );
+        _drawnBatches++;
+        _drawnVertices += quads * 6;
+
+        firstQuad += quads;
+        quadCount -= quads;
+    }
+}
+
+void Renderer::drawInstances(const InstancedCommand* cmd)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    const ssize_t count = cmd->getInstanceCount();
+    if (count == 0)
+    {
+        return;
+    }
+
+    GL::bindTexture2D(cmd->getTextureID());
+    GL::blendFunc(cmd->getBlendType().src, cmd->getBlendType().dst);
+    cmd->getGLProgramState()->apply(cmd->getModelView());
+
+    const GLuint instanceAttribs[] = {
+        InstancedCommand::ATTRIB_INSTANCE_COLOR,
+        InstancedCommand::ATTRIB_INSTANCE_TEX_RECT,
+        InstancedCommand::ATTRIB_INSTANCE_RECT,
+        InstancedCommand::ATTRIB_INSTANCE_ROTATION,
+    };
+    uint32_t flags = 1 << InstancedCommand::ATTRIB_CORNER;
+    for (auto attrib : instanceAttribs)
+    {
+        flags |= 1 << attrib;
+    }
+    GL::enableVertexAttribs(flags);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceCornersVBO);
+    glVertexAttribPointer(InstancedCommand::ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*) 0);
+
+    typedef InstancedCommand::Instance Instance;
+    GLintptr offset = _instanceStream.upload(cmd->getInstances(), sizeof(Instance) * count);
+    glVertexAttribPointer(InstancedCommand::ATTRIB_INSTANCE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), (GLvoid*) (offset + offsetof(Instance, color)));
+    glVertexAttribPointer(InstancedCommand::ATTRIB_INSTANCE_TEX_RECT, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*) (offset + offsetof(Instance, texRect)));
+    // position then size
+    glVertexAttribPointer(InstancedCommand::ATTRIB_INSTANCE_RECT, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*) (offset + offsetof(Instance, position)));
+    glVertexAttribPointer(InstancedCommand::ATTRIB_INSTANCE_ROTATION, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*) (offset + offsetof(Instance, rotation)));
+    for (auto attrib : instanceAttribs)
+    {
+        glVertexAttribDivisorCC(attrib, 1);
+    }
+
+    //the 6 indices of the first quad
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIndicesVBO);
+    glDrawElementsInstancedCC(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (GLvoid*) 0, (GLsizei) count);
+    _drawnBatches++;
+    _drawnVertices += count * 6;
+
+    //the other commands read these attributes per vertex
+    for (auto attrib : instanceAttribs)
+    {
+        glVertexAttribDivisorCC(attrib, 0);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+#else
+    CC_UNUSED_PARAM(cmd);
+#endif
+}
+
 void Renderer::flush()
 {
     flush2D();
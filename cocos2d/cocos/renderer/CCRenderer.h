@@ -32,6 +32,7 @@
 #include "platform/CCPlatformMacros.h"
 #include "renderer/CCRenderCommand.h"
 #include "renderer/CCGLProgram.h"
+#include "renderer/CCStreamingBuffer.h"
 #include "platform/CCGL.h"
 
 /**
@@ -45,6 +46,7 @@ class EventListenerCustom;
 class QuadCommand;
 class TrianglesCommand;
 class MeshCommand;
+class InstancedCommand;
 
 /** Class that knows how to sort `RenderCommand` objects.
  Since the commands that have `z == 0` are "pushed back" in
@@ -124,9 +126,9 @@ Whenever possible prefer to use `QuadCommand` objects since the renderer will au
 class CC_DLL Renderer
 {
 public:
-    /**The max number of vertices in a vertex buffer object.*/
+    /**The max number of vertices in a batch, indices are 16 bits. Longer runs of quads take several draws, a larger TrianglesCommand is drawn by itself.*/
     static const int VBO_SIZE = 65536;
-    /**The max number of indices in a index buffer.*/
+    /**The initial number of indices in a batch, it grows with the commands.*/
     static const int INDEX_VBO_SIZE = VBO_SIZE * 6 / 4;
     /**The rendercommands which can be batched will be saved into a list, this is the reversed size of this list.*/
     static const int BATCH_QUADCOMMAND_RESEVER_SIZE = 64;
@@ -155,6 +157,25 @@ public:
     /** Creates a render queue and returns its Id */
     int createRenderQueue();
 
+    /** The commands a thread of a ParallelVisit added, in order, to be added to the queues by the cocos thread. */
+    struct Recording
+    {
+        /** Each command with its render queue; a ParallelVisit marks its subtrees with nullptr commands. */
+        std::vector<std::pair<RenderCommand*, int>> commands;
+        /** pushGroup() and popGroup() of the thread, the bottom is the render queue the recording starts in. */
+        std::vector<int> groupStack;
+    };
+
+    /**
+     * Until endRecording(), the commands the calling thread adds, and the groups it pushes, go to
+     * recording rather than to the render queues. The group stack of recording must not be empty.
+     */
+    void beginRecording(Recording* recording);
+    /** Ends the recording of the calling thread. */
+    void endRecording();
+    /** The render queue the calling thread adds commands to, see pushGroup(). */
+    int getCurrentRenderQueue() const;
+
     /** Renders into the GLView all the queued `RenderCommand` objects */
     void render();
 
@@ -175,7 +196,19 @@ public:
     /* RenderCommands (except) QuadCommand should update this value */
     void addDrawnVertices(ssize_t number) { _drawnVertices += number; };
     /* clear draw stats */
-    void clearDrawStats() { _drawnBatches = _drawnVertices = 0; }
+    void clearDrawStats() { _drawnBatches = _drawnVertices = _drawCallsSavedByReordering = 0; }
+
+    /**
+     * Enable/Disable grouping the 2D commands of global Z 0 by material before rendering,
+     * so that commands of one material interleaved with others are drawn in one batch.
+     * A command is only moved past commands it does not overlap, so the frame looks the same.
+     * Disabled by default.
+     */
+    void setReorderByMaterial(bool enable) { _reorderByMaterial = enable; }
+    /** Whether the 2D commands of global Z 0 are grouped by material. */
+    bool isReorderByMaterial() const { return _reorderByMaterial; }
+    /* returns the number of draw calls saved by grouping by material in the last frame */
+    ssize_t getDrawCallsSavedByReordering() const { return _drawCallsSavedByReordering; }
 
     /**
      * Enable/Disable depth test
@@ -197,8 +230,16 @@ protected:
     void setupVBOAndVAO();
     void setupVBO();
     void mapBuffers();
+    // points the attributes to the vertices at offset in _vertexStream
+    void setVertexAttribPointers(GLintptr offset);
     void drawBatchedTriangles();
+    // draws a TrianglesCommand of more than VBO_SIZE vertices by itself, after the batch
+    void drawOversizedTriangles(const TrianglesCommand* cmd);
     void drawBatchedQuads();
+    // draws quadCount quads from firstQuad on, the attributes pointing at baseQuad (updated)
+    void drawQuads(GLintptr vertexOffset, ssize_t& baseQuad, ssize_t firstQuad, ssize_t quadCount);
+    // draws all the instances of cmd at once, with instancing
+    void drawInstances(const InstancedCommand* cmd);
 
     //Draw the previews queued quads and flush previous context
     void flush();
@@ -216,6 +257,24 @@ protected:
     void fillVerticesAndIndices(const TrianglesCommand* cmd);
     void fillQuads(const QuadCommand* cmd);
 
+    // commands of one material, in the order they will be drawn, see reorderByMaterial()
+    struct MaterialBatch
+    {
+        RenderCommand::Type type;
+        uint32_t materialID;
+        // later commands of the material may join the batch
+        bool batchable;
+        // the commands lie on the plane z of the world, within minX..maxY
+        bool bounded;
+        float z;
+        float minX, minY, maxX, maxY;
+        // number of commands, then where the next one goes once reordered
+        int commands;
+    };
+
+    // groups the GLOBALZ_ZERO commands of queue by material, without moving a command past one it overlaps
+    void reorderByMaterial(RenderQueue& queue);
+
     /* clear color set outside be used in setGLDefaultValues() */
     Color4F _clearColor;
 
@@ -230,20 +289,27 @@ protected:
     std::vector<QuadCommand*> _batchQuadCommands;
 
     //for TrianglesCommand
-    V3F_C4B_T2F _verts[VBO_SIZE];
-    GLushort _indices[INDEX_VBO_SIZE];
+    std::vector<V3F_C4B_T2F> _verts;
+    std::vector<GLushort> _indices;
     GLuint _buffersVAO;
-    GLuint _buffersVBO[2]; //0: vertex  1: indices
 
     int _filledVertex;
     int _filledIndex;
     
     //for QuadCommand
-    V3F_C4B_T2F _quadVerts[VBO_SIZE];
+    std::vector<V3F_C4B_T2F> _quadVerts;
     GLushort _quadIndices[INDEX_VBO_SIZE];
     GLuint _quadVAO;
-    GLuint _quadbuffersVBO[2]; //0: vertex  1: indices
+    GLuint _quadIndicesVBO;
     int _numberQuads;
+
+    //the batches once filled, vertices of both commands and indices of TrianglesCommand
+    StreamingBuffer _vertexStream;
+    StreamingBuffer _indexStream;
+
+    //for InstancedCommand, with instancing: the corners of the quad and the instances
+    GLuint _instanceCornersVBO;
+    StreamingBuffer _instanceStream;
     
     bool _glViewAssigned;
 
@@ -254,6 +320,13 @@ protected:
     bool _isRendering;
     
     bool _isDepthTestFor2D;
+
+    bool _reorderByMaterial;
+    ssize_t _drawCallsSavedByReordering;
+    // scratch of reorderByMaterial(), kept from frame to frame
+    std::vector<MaterialBatch> _reorderBatches;
+    std::vector<int> _reorderBatchOfCommand;
+    std::vector<RenderCommand*> _reorderedCommands;
     
     GroupCommandManager* _groupCommandManager;
     
@@ -0,0 +1,226 @@
+/****************************************************************************
+ Copyright (c) 2016 cocos2d-x.org
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "renderer/CCStreamingBuffer.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "base/ccMacros.h"
+
+// glMapBufferRange() and fences come with GLEW, OpenGL ES 2.0 has neither
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define CC_STREAMING_BUFFER_SYNC 1
+#endif
+
+NS_CC_BEGIN
+
+// uploads start on multiples of it, enough for any vertex attribute or index
+static const GLsizeiptr UPLOAD_ALIGNMENT = 16;
+
+StreamingBuffer::StreamingBuffer(GLenum target)
+: _target(target)
+, _mode(Mode::ORPHAN)
+, _buffer(0)
+, _sectionSize(0)
+, _sections(0)
+, _head(0)
+, _section(0)
+, _mapped(nullptr)
+, _stalls(0)
+{
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    destroy();
+}
+
+void StreamingBuffer::init(GLsizeiptr sectionSize, int sections)
+{
+    destroy();
+    _sectionSize = std::max(sectionSize, UPLOAD_ALIGNMENT);
+    _sections = std::max(sections, 1);
+    create();
+}
+
+void StreamingBuffer::invalidate()
+{
+    _fences.clear();
+    _mapped = nullptr;
+    _buffer = 0;
+}
+
+void StreamingBuffer::create()
+{
+    _mode = Mode::ORPHAN;
+#if CC_STREAMING_BUFFER_SYNC
+#ifdef GL_ARB_buffer_storage
+    if (GLEW_ARB_buffer_storage && GLEW_ARB_sync)
+    {
+        _mode = Mode::BUFFER_STORAGE;
+    }
+    else
+#endif
+    if ((GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range) && GLEW_ARB_sync)
+    {
+        _mode = Mode::MAP_RANGE;
+    }
+#endif
+
+    _head = 0;
+    _section = 0;
+    _fences.assign(_sections, nullptr);
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(_target, _buffer);
+    switch (_mode)
+    {
+#if CC_STREAMING_BUFFER_SYNC && defined(GL_ARB_buffer_storage)
+        case Mode::BUFFER_STORAGE:
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(_target, getCapacity(), nullptr, flags);
+            _mapped = static_cast<unsigned char*>(glMapBufferRange(_target, 0, getCapacity(), flags));
+            if (!_mapped)
+            {
+                // keeps the storage, written range by range
+                _mode = Mode::MAP_RANGE;
+            }
+            break;
+        }
+#endif
+        case Mode::MAP_RANGE:
+            glBufferData(_target, getCapacity(), nullptr, GL_DYNAMIC_DRAW);
+            break;
+        default:
+            // each upload makes its own store
+            break;
+    }
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void StreamingBuffer::destroy()
+{
+#if CC_STREAMING_BUFFER_SYNC
+    for (auto fence : _fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+#endif
+    _fences.clear();
+
+    if (_buffer)
+    {
+        if (_mapped)
+        {
+            glBindBuffer(_target, _buffer);
+            glUnmapBuffer(_target);
+            _mapped = nullptr;
+        }
+        // the GL keeps the store until the draws in flight are done with it
+        glDeleteBuffers(1, &_buffer);
+        _buffer = 0;
+    }
+}
+
+void StreamingBuffer::waitForSection(int section)
+{
+#if CC_STREAMING_BUFFER_SYNC
+    GLsync fence = static_cast<GLsync>(_fences[section]);
+    if (!fence)
+    {
+        return;
+    }
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        ++_stalls;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    _fences[section] = nullptr;
+#else
+    CC_UNUSED_PARAM(section);
+#endif
+}
+
+GLintptr StreamingBuffer::upload(const void* data, GLsizeiptr size)
+{
+    if (_mode == Mode::ORPHAN)
+    {
+        glBindBuffer(_target, _buffer);
+        glBufferData(_target, size, data, GL_DYNAMIC_DRAW);
+        return 0;
+    }
+
+    if (size > _sectionSize)
+    {
+        // a new, larger ring, the old one lives on while the GPU reads it
+        init(std::max(size, _sectionSize * 2), _sections);
+    }
+
+    if (_head + size > (_section + 1) * _sectionSize)
+    {
+        // the GPU is done with the section once the draws issued so far are
+#if CC_STREAMING_BUFFER_SYNC
+        _fences[_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+        _section = (_section + 1) % _sections;
+        _head = _section * _sectionSize;
+        waitForSection(_section);
+    }
+
+    GLintptr offset = _head;
+    _head += (size + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+
+    glBindBuffer(_target, _buffer);
+    if (_mapped)
+    {
+        // coherent, visible to the next draws
+        memcpy(_mapped + offset, data, size);
+        return offset;
+    }
+
+#if CC_STREAMING_BUFFER_SYNC
+    // the fences tell that nothing reads the range, the driver must not wait
+    void* range = glMapBufferRange(_target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (range)
+    {
+        memcpy(range, data, size);
+        glUnmapBuffer(_target);
+        return offset;
+    }
+#endif
+    glBufferSubData(_target, offset, size, data);
+    return offset;
+}
+
+NS_CC_END
@@ -0,0 +1,121 @@
+/****************************************************************************
+ Copyright (c) 2016 cocos2d-x.org
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_STREAMING_BUFFER_H__
+#define __CC_STREAMING_BUFFER_H__
+
+#include <vector>
+#include "platform/CCPlatformMacros.h"
+#include "platform/CCGL.h"
+
+/**
+ * @addtogroup renderer
+ * @{
+ */
+
+NS_CC_BEGIN
+
+/**
+ * @class StreamingBuffer
+ * @brief A GL buffer written once per draw, as the batches of the Renderer.
+ *
+ * The buffer is a ring of sections. Each upload goes after the previous one, and
+ * a section is only written again once the GPU is done with it, which a fence set
+ * when the ring left the section tells. So no upload waits for the draws of the
+ * last frames, as orphaning with glBufferData() may on some drivers.
+ *
+ * Depending on the GL of the platform, the data is written:
+ * - BUFFER_STORAGE: into the buffer mapped once for good (GL 4.4 / ARB_buffer_storage).
+ * - MAP_RANGE: into the range mapped unsynchronized (GL 3.0 / ARB_map_buffer_range and ARB_sync).
+ * - ORPHAN: with glBufferData() into a new store each time, as on OpenGL ES 2.0.
+ *
+ * An upload larger than a section grows the ring.
+ * @js NA
+ */
+class CC_DLL StreamingBuffer
+{
+public:
+    enum class Mode
+    {
+        BUFFER_STORAGE,
+        MAP_RANGE,
+        ORPHAN,
+    };
+
+    /** @param target GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. */
+    explicit StreamingBuffer(GLenum target);
+    ~StreamingBuffer();
+
+    /**
+     * Creates the GL buffer, a ring of sections of sectionSize bytes. Call it again
+     * once the GL context is recreated.
+     */
+    void init(GLsizeiptr sectionSize, int sections = 3);
+
+    /** Forgets the GL objects, lost with the GL context, before init() again. */
+    void invalidate();
+
+    /**
+     * Copies size bytes to the ring and leaves the buffer bound to its target.
+     * An element buffer is bound to the current VAO, if any.
+     * @return the offset of the data in the buffer, for glVertexAttribPointer() or glDrawElements().
+     */
+    GLintptr upload(const void* data, GLsizeiptr size);
+
+    /** The GL name of the buffer, it changes when the ring grows. */
+    GLuint getBuffer() const { return _buffer; }
+    Mode getMode() const { return _mode; }
+    /** The size of the ring in bytes. */
+    GLsizeiptr getCapacity() const { return _sectionSize * _sections; }
+    /** The number of times a section was still in use by the GPU when the ring came back to it. */
+    unsigned int getStalls() const { return _stalls; }
+
+private:
+    void create();
+    void destroy();
+    // waits until the GPU is done with section
+    void waitForSection(int section);
+
+    GLenum _target;
+    Mode _mode;
+    GLuint _buffer;
+    GLsizeiptr _sectionSize;
+    int _sections;
+    // the ring is written from _head on, in _section
+    GLsizeiptr _head;
+    int _section;
+    // BUFFER_STORAGE: the buffer, mapped for good
+    unsigned char* _mapped;
+    // fence of each section, set when the ring left it
+    std::vector<void*> _fences;
+    unsigned int _stalls;
+};
+
+NS_CC_END
+
+/**
+ end of support group
+ @}
+ */
+#endif //__CC_STREAMING_BUFFER_H__
@@ -0,0 +1,54 @@
+/****************************************************************************
+ Copyright (c) 2016 cocos2d-x.org
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+const char* ccPositionTextureColor_instanced_vert = STRINGIFY(
+// corner of the quad, from (-0.5, -0.5) to (0.5, 0.5)
+attribute vec4 a_position;
+// per instance: center and size, rotation in degrees clockwise, color, texture rect
+attribute vec4 a_instanceRect;
+attribute float a_instanceRotation;
+attribute vec4 a_instanceColor;
+attribute vec4 a_instanceTexRect;
+
+\n#ifdef GL_ES\n
+varying lowp vec4 v_fragmentColor;
+varying mediump vec2 v_texCoord;
+\n#else\n
+varying vec4 v_fragmentColor;
+varying vec2 v_texCoord;
+\n#endif\n
+
+void main()
+{
+    float angle = -radians(a_instanceRotation);
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = a_position.xy * a_instanceRect.zw;
+    vec2 position = a_instanceRect.xy + vec2(c * corner.x - s * corner.y, s * corner.x + c * corner.y);
+    gl_Position = CC_MVPMatrix * vec4(position, 0.0, 1.0);
+    v_fragmentColor = a_instanceColor;
+    // the texture rect starts at its top left corner
+    v_texCoord = a_instanceTexRect.xy + vec2(a_position.x + 0.5, 0.5 - a_position.y) * a_instanceTexRect.zw;
+}
+);
@@ -57,6 +57,7 @@ NS_CC_BEGIN
 //
 #include "ccShader_PositionTextureColor_noMVP.frag"
 #include "ccShader_PositionTextureColor_noMVP.vert"
+#include "ccShader_PositionTextureColor_instanced.vert"
 
 //
 #include "ccShader_PositionTextureColorAlphaTest.frag"
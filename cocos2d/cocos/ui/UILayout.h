@@ -376,6 +376,8 @@ public:
     virtual void addChild(Node* child, int localZOrder, const std::string &name) override;
     
     virtual void visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags) override;
+    /** A clipping layout pushes a render group in visit(), see ParallelVisit. */
+    virtual bool isVisitedOnCocosThread() const override { return _clippingEnabled; }
 
     virtual void removeChild(Node* child, bool cleanup = true) override;
     
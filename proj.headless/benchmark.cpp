@@ -0,0 +1,931 @@
+/******************************************************************************
+ * Benchmarks of the headless snake model                                     *
+ *                                                                            *
+ *   latency     one update() at several snake lengths and board sizes        *
+ *   food        cost of putting a food as the board fills up                 *
+ *   throughput  whole games under a random and a greedy policy               *
+ *   scaling     independent games spread over 1..N threads                   *
+ *   autopilot   Autopilot::decide() while it plays, mean and worst step,     *
+ *               CyclePilot games played to the win                           *
+ *   arena       ArenaModel ticks of 10k snakes on 1..N threads               *
+ *   server      GameServer ticks of many rooms, bytes sent, client desyncs   *
+ *   observation ObservationEncoder per step, against a redraw of the board  *
+ *   replay      games recorded, written, then seeked and played back, the   *
+ *               states checked against the live model                       *
+ *                                                                            *
+ * Usage: snake_benchmark [--format json|csv] [--quick] [--min-time seconds]  *
+ *                        [--suite <name>], name of one suite above           *
+ * Results go to stdout, one record per measure, so runs of two commits can  *
+ * be diffed or loaded as they are.                                           *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Classes/ArenaModel.h"
+#include "../Classes/Autopilot.h"
+#include "../Classes/BatchSimulator.h"
+#include "../Classes/BitBoard.h"
+#include "../Classes/Bitmap.h"
+#include "../Classes/CyclePilot.h"
+#include "../Classes/FixedModel.h"
+#include "../Classes/GameClient.h"
+#include "../Classes/GameServer.h"
+#include "../Classes/GridModel.h"
+#include "../Classes/LoopbackTransport.h"
+#include "../Classes/Model.h"
+#include "../Classes/ObservationEncoder.h"
+#include "../Classes/Random.h"
+#include "../Classes/Replay.h"
+#include "../Classes/Snapshot.h"
+#include "../Classes/VectorModel.h"
+
+namespace {
+
+    using Cell = std::uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        bool csv = false;
+        bool quick = false;
+        double minSeconds = 0.2;
+        std::string suite;
+    };
+
+    /* One measure: count operations of unit took seconds.
+     * parameter / argument describe the varying input, e.g. length = 128 */
+    struct Result {
+        std::string suite;
+        std::string model;
+        std::size_t width;
+        std::size_t height;
+        std::string parameter;
+        double argument;
+        std::string unit;
+        std::uint64_t count;
+        double seconds;
+
+        inline double nanosecondsPerOperation() const { return count > 0 ? seconds * 1e9 / count : 0; }
+        inline double operationsPerSecond() const { return seconds > 0 ? count / seconds : 0; }
+    };
+
+    using Results = std::vector<Result>;
+
+    // results of the measured loops end up here, so they are not optimized out
+    volatile Cell benchmarkSink = 0;
+
+    inline double elapsed(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /************************ Board helpers *********************/
+
+    // cell one step from cell towards heading, false if it leaves the board
+    inline bool neighbour(Cell cell, Util::Direction heading, std::size_t width, std::size_t height, Cell &next) {
+        std::size_t x = cell % width;
+        std::size_t y = cell / width;
+        switch (heading) {
+            case Util::LEFT:
+                if (0 == x) return false;
+                --x;
+                break;
+            case Util::RIGHT:
+                if (width - 1 == x) return false;
+                ++x;
+                break;
+            case Util::UP:
+                if (height - 1 == y) return false;
+                ++y;
+                break;
+            case Util::DOWN:
+                if (0 == y) return false;
+                --y;
+                break;
+            default:
+                return false;
+        }
+        next = static_cast<Cell>(y * width + x);
+        return true;
+    }
+
+    // direction of a step of the tour, from and to are neighbours
+    inline Util::Direction heading(Cell from, Cell to) {
+        if (to == from + 1) return Util::RIGHT;
+        if (to + 1 == from) return Util::LEFT;
+        return to > from ? Util::UP : Util::DOWN;
+    }
+
+    /* A closed tour of the board, height must be even.
+     * Column 0 is the way back down, rows 0..height-1 are swept
+     * right / left over columns 1..width-1 */
+    std::vector<Cell> makeTour(std::size_t width, std::size_t height) {
+        std::vector<Cell> tour;
+        tour.reserve(width * height);
+        tour.push_back(0);
+        for (std::size_t y = 0; y < height; ++y) {
+            for (std::size_t i = 1; i < width; ++i) {
+                std::size_t x = 0 == y % 2 ? i : width - i;
+                tour.push_back(static_cast<Cell>(y * width + x));
+            }
+        }
+        for (std::size_t y = height - 1; y > 0; --y) {
+            tour.push_back(static_cast<Cell>(y * width));
+        }
+        return tour;
+    }
+
+    // direction[cell] leads to the next cell of the tour
+    std::vector<Util::Direction> makeTourDirections(const std::vector<Cell> &tour) {
+        std::vector<Util::Direction> directions(tour.size());
+        for (std::size_t i = 0; i < tour.size(); ++i) {
+            directions[tour[i]] = heading(tour[i], tour[(i + 1) % tour.size()]);
+        }
+        return directions;
+    }
+
+    /* Snapshot of a snake of the given length lying along the tour,
+     * the food halfway along the free part of it. Any model restores it,
+     * following the tour it never dies */
+    Util::Snapshot makeSnapshot(const std::vector<Cell> &tour, std::size_t width, std::size_t height,
+                                std::size_t length, std::uint64_t seed) {
+        Util::Snapshot buffer;
+        Util::SnapshotWriter writer(buffer);
+        writer.write(Util::SNAPSHOT_MAGIC);
+        writer.write(static_cast<std::uint32_t>(width));
+        writer.write(static_cast<std::uint32_t>(height));
+        writer.write(static_cast<std::uint64_t>(length - 2));
+        writer.write(static_cast<std::uint8_t>(heading(tour[length - 2], tour[length - 1])));
+        writer.write(tour[(length + tour.size()) / 2 % tour.size()]);
+        writer.write(seed);
+        writer.write(static_cast<std::uint32_t>(length));
+        Util::writeBody(writer, length, [&tour](std::size_t index) { return tour[index]; });
+        return buffer;
+    }
+
+    /************************ Policies *********************/
+
+    // any direction, reversing is discarded by the model anyway
+    inline Util::Direction randomPolicy(Util::Random &generator) {
+        return static_cast<Util::Direction>(generator() & 3);
+    }
+
+    // the free neighbour closest to the food, straight on if none is free
+    template <typename M>
+    Util::Direction greedyPolicy(const M &model) {
+        std::size_t width = model.getWidth();
+        Cell head = model.getHeadCell();
+        Cell food = model.getFoodCell();
+        long foodX = static_cast<long>(food % width);
+        long foodY = static_cast<long>(food / width);
+        Util::Direction best = Util::UNDEFINED;
+        long bestDistance = 0;
+        for (int i = 0; i < 4; ++i) {
+            Util::Direction candidate = static_cast<Util::Direction>(i);
+            Cell next;
+            if (((candidate ^ model.getDirection()) & 1) == 0 && candidate != model.getDirection()) {
+                continue;
+            }
+            if (!neighbour(head, candidate, width, model.getHeight(), next) || model.isOccupied(next)) {
+                continue;
+            }
+            long distance = std::labs(static_cast<long>(next % width) - foodX)
+                            + std::labs(static_cast<long>(next / width) - foodY);
+            if (Util::UNDEFINED == best || distance < bestDistance) {
+                best = candidate;
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+
+    /************************ Suites *********************/
+
+    struct Board {
+        std::size_t width;
+        std::size_t height;
+    };
+
+    /* Follow the tour from a snake of each length, the snapshot is restored
+     * every chunk of steps outside of the timing, so the length barely moves */
+    template <typename M>
+    void runLatency(Results &results, const Options &options, const char *name, M &model) {
+        const std::size_t chunk = 1024;
+        std::size_t width = model.getWidth();
+        std::size_t height = model.getHeight();
+        std::size_t boardSize = width * height;
+        std::vector<Cell> tour = makeTour(width, height);
+        std::vector<Util::Direction> directions = makeTourDirections(tour);
+        const double fractions[] = { 0, 0.25, 0.5, 0.9 };
+
+        for (double fraction : fractions) {
+            std::size_t length = std::max<std::size_t>(2, static_cast<std::size_t>(boardSize * fraction));
+            Util::Snapshot start = makeSnapshot(tour, width, height, length, 42);
+            std::uint64_t steps = 0;
+            double seconds = 0;
+            while (seconds < options.minSeconds) {
+                model.restore(start);
+                Clock::time_point begin = Clock::now();
+                for (std::size_t i = 0; i < chunk; ++i) {
+                    ++steps;
+                    if (Snake::Model::GameStatus::NORMAL != model.update(directions[model.getHeadCell()])) {
+                        break;
+                    }
+                }
+                seconds += elapsed(begin);
+            }
+            results.push_back({ "latency", name, width, height, "length",
+                                static_cast<double>(length), "step", steps, seconds });
+        }
+    }
+
+    /* The original Model has no headless accessors, this keeps the head,
+     * the food and the occupancy up to date from its deltas */
+    class ModelAdapter {
+    public:
+        ModelAdapter(std::size_t width, std::size_t height, std::uint64_t seed = 0)
+        : model(width, height, seed), width(width), height(height), head(0), food(0), occupied(width * height) {
+            apply();
+        }
+
+        Snake::Model::GameStatus update(Util::Direction command) {
+            Snake::Model::GameStatus status = model.update(command);
+            apply();
+            return status;
+        }
+        void restore(const Util::Snapshot &buffer) {
+            model.restore(buffer);
+            occupied.clear();
+            apply();
+        }
+
+        inline Util::Direction getDirection() const { return model.getDirection(); }
+        inline std::size_t getFoodEaten() const { return model.getFoodEaten(); }
+        inline std::size_t getWidth() const { return width; }
+        inline std::size_t getHeight() const { return height; }
+        inline Cell getHeadCell() const { return head; }
+        inline Cell getFoodCell() const { return food; }
+        inline bool isOccupied(Cell cell) const { return occupied.test(cell); }
+
+    private:
+        Snake::Model model;
+        std::size_t width;
+        std::size_t height;
+        Cell head;
+        Cell food;
+        Util::Bitmap occupied;
+
+        void apply() {
+            for (const Util::CellChange &change : model.getDelta()) {
+                switch (change.to) {
+                    case Util::NodeType::HEAD:
+                        head = change.cell;
+                        occupied.set(change.cell);
+                        break;
+                    case Util::NodeType::BODY:
+                        occupied.set(change.cell);
+                        break;
+                    case Util::NodeType::FOOD:
+                        food = change.cell;
+                        break;
+                    default:
+                        occupied.reset(change.cell);
+                        break;
+                }
+            }
+        }
+    };
+
+    template <std::size_t W, std::size_t H>
+    void runLatencyBoard(Results &results, const Options &options, bool withModel) {
+        if (withModel) {
+            ModelAdapter model(W, H);
+            runLatency(results, options, "Model", model);
+        }
+        Snake::GridModel grid(W, H);
+        runLatency(results, options, "GridModel", grid);
+        std::unique_ptr<Snake::FixedModel<W, H>> fixed(new Snake::FixedModel<W, H>());
+        runLatency(results, options, "FixedModel", *fixed);
+    }
+
+    void runLatencySuite(Results &results, const Options &options) {
+        runLatencyBoard<16, 16>(results, options, true);
+        runLatencyBoard<48, 32>(results, options, true);
+        runLatencyBoard<128, 128>(results, options, !options.quick);
+        if (!options.quick) {
+            runLatencyBoard<512, 512>(results, options, false);
+        }
+    }
+
+    /* Picking a free cell uniformly at occupancy p, the way the models do it
+     * (Bitmap::sampleClear, one draw located through the clear counts of the
+     * words), against a scan of the words up to the free cell of the rank
+     * drawn, one popcount per word, and drawing until a free cell is hit,
+     * the way Model did first, whose cost grows as 1 / (1 - p) */
+    void runFoodSuite(Results &results, const Options &options) {
+        const std::size_t width = 128;
+        const std::size_t height = 128;
+        const std::size_t boardSize = width * height;
+        const double occupancies[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+        for (double occupancy : occupancies) {
+            // keep one free cell at least
+            std::size_t occupiedCount = std::min(boardSize - 1, static_cast<std::size_t>(boardSize * occupancy));
+            Util::Random generator(7);
+            Util::Bitmap occupied(boardSize);
+            while (boardSize - occupied.clearCount() < occupiedCount) {
+                occupied.set(occupied.sampleClear(generator));
+            }
+
+            std::uint64_t count = 0;
+            Cell sink = 0;
+            Clock::time_point begin = Clock::now();
+            do {
+                for (int i = 0; i < 1024; ++i) {
+                    sink ^= static_cast<Cell>(occupied.sampleClear(generator));
+                }
+                count += 1024;
+            } while (elapsed(begin) < options.minSeconds);
+            results.push_back({ "food", "Bitmap", width, height, "occupancy",
+                                static_cast<double>(occupiedCount) / boardSize, "food", count, elapsed(begin) });
+
+            std::uniform_int_distribution<std::size_t> anyFree(0, occupied.clearCount() - 1);
+            count = 0;
+            begin = Clock::now();
+            do {
+                for (int i = 0; i < 64; ++i) {
+                    std::size_t rank = anyFree(generator);
+                    std::size_t index = 0;
+                    for (;; ++index) {
+                        std::size_t free = Util::popCount(~occupied.data()[index]);
+                        if (rank < free) {
+                            break;
+                        }
+                        rank -= free;
+                    }
+                    sink ^= static_cast<Cell>(index * 64 + Util::selectBit(~occupied.data()[index],
+                                                                          static_cast<unsigned>(rank)));
+                }
+                count += 64;
+            } while (elapsed(begin) < options.minSeconds);
+            results.push_back({ "food", "scan", width, height, "occupancy",
+                                static_cast<double>(occupiedCount) / boardSize, "food", count, elapsed(begin) });
+
+            std::uniform_int_distribution<Cell> distribution(0, static_cast<Cell>(boardSize - 1));
+            count = 0;
+            begin = Clock::now();
+            do {
+                for (int i = 0; i < 16; ++i) {
+                    Cell cell;
+                    do {
+                        cell = distribution(generator);
+                    } while (occupied.test(cell));
+                    sink ^= cell;
+                }
+                count += 16;
+            } while (elapsed(begin) < options.minSeconds);
+            results.push_back({ "food", "rejection", width, height, "occupancy",
+                                static_cast<double>(occupiedCount) / boardSize, "food", count, elapsed(begin) });
+            benchmarkSink = sink;
+        }
+    }
+
+    /* Whole games on one thread, each game is capped to 64 steps per cell
+     * so a greedy snake going round in circles still ends */
+    template <typename M>
+    void runGames(Results &results, const Options &options, const char *name,
+                  std::size_t width, std::size_t height, bool greedy) {
+        const std::size_t maxSteps = 64 * width * height;
+        Util::Random generator(1);
+        std::uint64_t games = 0;
+        std::uint64_t steps = 0;
+        std::uint64_t food = 0;
+        Clock::time_point begin = Clock::now();
+        do {
+            std::unique_ptr<M> model(new M(width, height, games));
+            for (std::size_t i = 0; i < maxSteps; ++i) {
+                Util::Direction command = greedy ? greedyPolicy(*model) : randomPolicy(generator);
+                ++steps;
+                if (Snake::Model::GameStatus::NORMAL != model->update(command)) {
+                    break;
+                }
+            }
+            food += model->getFoodEaten();
+            ++games;
+        } while (elapsed(begin) < options.minSeconds);
+        double seconds = elapsed(begin);
+        const char *policy = greedy ? "greedy" : "random";
+        results.push_back({ "throughput", name, width, height, policy, 0, "step", steps, seconds });
+        results.push_back({ "throughput", name, width, height, policy, 0, "game", games, seconds });
+        results.push_back({ "throughput", name, width, height, policy, 0, "food", food, seconds });
+    }
+
+    // VectorModel under the random policy, games restart as soon as they end
+    void runVectorGames(Results &results, const Options &options, std::size_t width, std::size_t height) {
+        const std::size_t games = 1024;
+        Snake::VectorModel model(games, width, height, 1);
+        std::vector<Util::Direction> commands(games);
+        Util::Random generator(1);
+        std::uint64_t steps = 0;
+        std::uint64_t ended = 0;
+        Clock::time_point begin = Clock::now();
+        do {
+            for (std::size_t k = 0; k < games; ++k) {
+                commands[k] = randomPolicy(generator);
+            }
+            model.step(commands.data());
+            steps += games;
+            for (std::size_t k = 0; k < games; ++k) {
+                if (Snake::Model::GameStatus::NORMAL != model.getStatus(k)) {
+                    model.reset(k);
+                    ++ended;
+                }
+            }
+        } while (elapsed(begin) < options.minSeconds);
+        double seconds = elapsed(begin);
+        results.push_back({ "throughput", "VectorModel", width, height, "random", 0, "step", steps, seconds });
+        results.push_back({ "throughput", "VectorModel", width, height, "random", 0, "game", ended, seconds });
+    }
+
+    void runThroughputSuite(Results &results, const Options &options) {
+        const Board boards[] = { { 16, 16 }, { 48, 32 } };
+        for (const Board &board : boards) {
+            runGames<ModelAdapter>(results, options, "Model", board.width, board.height, false);
+            runGames<ModelAdapter>(results, options, "Model", board.width, board.height, true);
+            runGames<Snake::GridModel>(results, options, "GridModel", board.width, board.height, false);
+            runGames<Snake::GridModel>(results, options, "GridModel", board.width, board.height, true);
+            runVectorGames(results, options, board.width, board.height);
+        }
+    }
+
+    /* The same batch of greedy games on 1, 2, 4 ... threads, up to the
+     * number of hardware threads. Games do not share anything */
+    void runScalingSuite(Results &results, const Options &options) {
+        const std::size_t games = options.quick ? 1024 : 4096;
+        const std::size_t width = 32;
+        const std::size_t height = 32;
+        const std::size_t maxSteps = options.quick ? 500 : 2000;
+        std::size_t hardware = std::max<unsigned>(1, std::thread::hardware_concurrency());
+
+        for (std::size_t threads = 1; ; threads = std::min(threads * 2, hardware)) {
+            Snake::BatchSimulator simulator(games, width, height, threads, 0);
+            simulator.setPolicy([](std::size_t, const Snake::GridModel &model) {
+                return greedyPolicy(model);
+            });
+            simulator.run(maxSteps);
+            Snake::BatchSimulator::Statistics statistics = simulator.getStatistics();
+            results.push_back({ "scaling", "BatchSimulator", width, height, "threads",
+                                static_cast<double>(threads), "step", statistics.steps, statistics.seconds });
+            if (threads == hardware) {
+                break;
+            }
+        }
+    }
+
+    /* Model played to WIN by the CyclePilot, whole board filled every
+     * game, so also the food put at near full occupancy */
+    void runCycleGames(Results &results, const Options &options, std::size_t width, std::size_t height) {
+        std::uint64_t steps = 0;
+        std::uint64_t games = 0;
+        std::uint64_t wins = 0;
+        Clock::time_point begin = Clock::now();
+        do {
+            Snake::Model model(width, height, games);
+            Snake::CyclePilot pilot(width, height);
+            pilot.apply(model.getDelta());
+            Snake::Model::GameStatus status = Snake::Model::GameStatus::NORMAL;
+            while (Snake::Model::GameStatus::NORMAL == status) {
+                status = model.update(pilot.decide(model.getDirection()));
+                pilot.apply(model.getDelta());
+                ++steps;
+            }
+            wins += Snake::Model::GameStatus::WIN == status ? 1 : 0;
+            ++games;
+        } while (elapsed(begin) < options.minSeconds);
+        double seconds = elapsed(begin);
+        results.push_back({ "autopilot", "CyclePilot", width, height, "games",
+                            static_cast<double>(games), "step", steps, seconds });
+        results.push_back({ "autopilot", "CyclePilot", width, height, "games",
+                            static_cast<double>(games), "win", wins, seconds });
+    }
+
+    /* GridModel played by the autopilot, a game that ends or drags on past
+     * 64 steps per cell starts over. Only decide() is timed, the worst
+     * step is a record of its own (count 1) */
+    void runAutopilotSuite(Results &results, const Options &options) {
+        const Board boards[] = { { 16, 16 }, { 48, 32 }, { 128, 128 }, { 1000, 1000 } };
+        for (const Board &board : boards) {
+            const std::size_t maxSteps = 64 * board.width * board.height;
+            std::uint64_t steps = 0;
+            std::uint64_t games = 0;
+            double seconds = 0;
+            double worst = 0;
+            Clock::time_point begin = Clock::now();
+            do {
+                Snake::GridModel model(board.width, board.height, games);
+                Snake::Autopilot pilot(board.width, board.height);
+                pilot.apply(model.getDelta());
+                for (std::size_t i = 0; i < maxSteps && elapsed(begin) < options.minSeconds; ++i) {
+                    Clock::time_point start = Clock::now();
+                    Util::Direction command = pilot.decide(model.getDirection());
+                    double step = elapsed(start);
+                    seconds += step;
+                    worst = std::max(worst, step);
+                    ++steps;
+                    if (Snake::Model::GameStatus::NORMAL != model.update(command)) {
+                        break;
+                    }
+                    pilot.apply(model.getDelta());
+                }
+                ++games;
+            } while (elapsed(begin) < options.minSeconds);
+            results.push_back({ "autopilot", "Autopilot", board.width, board.height, "games",
+                                static_cast<double>(games), "step", steps, seconds });
+            results.push_back({ "autopilot", "Autopilot", board.width, board.height, "games",
+                                static_cast<double>(games), "worst step", 1, worst });
+        }
+        runCycleGames(results, options, 16, 16);
+        runCycleGames(results, options, 48, 32);
+    }
+
+    /* The same arena on 1, 2, 4 ... threads, snakes turn at random every
+     * few ticks and come back once dead. Only step() is timed */
+    void runArenaSuite(Results &results, const Options &options) {
+        const std::size_t snakes = options.quick ? 1000 : 10000;
+        const std::size_t width = options.quick ? 256 : 1024;
+        const std::size_t height = width;
+        const std::size_t foods = snakes / 2;
+        std::size_t hardware = std::max<unsigned>(1, std::thread::hardware_concurrency());
+
+        for (std::size_t threads = 1; ; threads = std::min(threads * 2, hardware)) {
+            Snake::ArenaModel arena(width, height, snakes, foods, threads, 1);
+            arena.setRespawn(true);
+            std::vector<Util::Direction> commands(snakes);
+            Util::Random generator(1);
+            std::uint64_t ticks = 0;
+            double seconds = 0;
+            do {
+                for (Util::Direction &command : commands) {
+                    std::uint64_t draw = generator();
+                    command = 0 == draw % 4 ? static_cast<Util::Direction>((draw >> 8) % 4) : Util::Direction::UNDEFINED;
+                }
+                Clock::time_point begin = Clock::now();
+                arena.step(commands.data());
+                seconds += elapsed(begin);
+                ++ticks;
+            } while (seconds < options.minSeconds);
+            results.push_back({ "arena", "ArenaModel", width, height, "threads",
+                                static_cast<double>(threads), "tick", ticks, seconds });
+            results.push_back({ "arena", "ArenaModel", width, height, "threads",
+                                static_cast<double>(threads), "snake step", ticks * snakes, seconds });
+            if (threads == hardware) {
+                break;
+            }
+        }
+    }
+
+    /* Rooms of one player each, through LoopbackTransport with 2 ticks of
+     * latency, commands at random and games restarted. Only tick() of the
+     * server is timed; bytes are those of the frames sent. In the end
+     * every client must show the board of its room, desyncs are counted */
+    void runServerSuite(Results &results, const Options &options) {
+        const std::size_t rooms = options.quick ? 100 : 1000;
+        const std::size_t width = 32;
+        const std::size_t height = 32;
+        const std::size_t latency = 2;
+
+        Snake::GameServer server(width, height);
+        server.setRestart(true);
+        Snake::LoopbackTransport loopback(server, latency);
+        std::vector<std::unique_ptr<Snake::GameClient>> clients;
+        for (std::size_t i = 0; i < rooms; ++i) {
+            clients.emplace_back(new Snake::GameClient(2 * latency + 1));
+            server.join(loopback.connect(*clients.back()), server.createRoom(i + 1));
+        }
+
+        Util::Random generator(1);
+        std::uint64_t ticks = 0;
+        double seconds = 0;
+        do {
+            for (std::unique_ptr<Snake::GameClient> &client : clients) {
+                std::uint64_t draw = generator();
+                if (0 == draw % 8) {
+                    client->pushCommand(static_cast<Util::Direction>((draw >> 8) % 4));
+                }
+            }
+            Clock::time_point begin = Clock::now();
+            server.tick();
+            seconds += elapsed(begin);
+            loopback.advance();
+            ++ticks;
+        } while (seconds < options.minSeconds);
+        for (std::size_t i = 0; i < latency; ++i) {
+            loopback.advance();
+        }
+
+        std::uint64_t frames = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t desyncs = 0;
+        for (std::size_t i = 0; i < rooms; ++i) {
+            const Snake::GameServer::RoomStatistics &statistics = server.getStatistics(static_cast<Snake::GameServer::RoomId>(i));
+            frames += statistics.frames;
+            bytes += statistics.bytes;
+            const Snake::GridModel &model = server.getModel(static_cast<Snake::GameServer::RoomId>(i));
+            const Snake::GameClient &client = *clients[i];
+            bool same = model.getLength() == client.getLength();
+            for (std::size_t node = 0; same && node < model.getLength(); ++node) {
+                same = model.getBodyCell(node) == client.getBodyCell(node);
+            }
+            if (!same) {
+                ++desyncs;
+            }
+        }
+        results.push_back({ "server", "GameServer", width, height, "rooms",
+                            static_cast<double>(rooms), "room tick", ticks * rooms, seconds });
+        results.push_back({ "server", "GameServer", width, height, "rooms",
+                            static_cast<double>(rooms), "frame", frames, seconds });
+        results.push_back({ "server", "GameServer", width, height, "rooms",
+                            static_cast<double>(rooms), "byte", bytes, seconds });
+        results.push_back({ "server", "GameClient", width, height, "rooms",
+                            static_cast<double>(rooms), "desync", desyncs, seconds });
+    }
+
+    /* Games of Model played by the CyclePilot, up to maxSteps, recorded
+     * with a keyframe every 64 steps and written out. The file is read
+     * back through a ReplayView: a ReplayPlayer seeks to checkpoints in
+     * random order, then plays to the end, and its GridModel must give
+     * the snapshots of the live model there, the status too. Recording,
+     * seeks and played steps are timed apart, mismatches are counted */
+    void runReplayGames(Results &results, const Options &options, std::size_t width, std::size_t height) {
+        const std::size_t maxSteps = options.quick ? 2000 : 20000;
+        const std::size_t checkpointInterval = 97;
+        std::uint64_t recorded = 0;
+        std::uint64_t seeks = 0;
+        std::uint64_t played = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t mismatches = 0;
+        double recordSeconds = 0;
+        double seekSeconds = 0;
+        double playSeconds = 0;
+        std::vector<std::uint8_t> file;
+        Util::Snapshot snapshot;
+        Util::Random generator(1);
+        for (std::uint64_t game = 0; recordSeconds + seekSeconds + playSeconds < options.minSeconds; ++game) {
+            Snake::Model model(width, height, game);
+            Snake::CyclePilot pilot(width, height);
+            pilot.apply(model.getDelta());
+            Snake::ReplayRecorder recorder(width, height, game, 64);
+            // snapshots of the live model at some steps, then at the last one
+            std::vector<std::pair<std::size_t, Util::Snapshot>> checkpoints;
+            Clock::time_point begin = Clock::now();
+            recorder.record(model);
+            recordSeconds += elapsed(begin);
+            Snake::Model::GameStatus status = Snake::Model::GameStatus::NORMAL;
+            for (std::size_t step = 1; step <= maxSteps && Snake::Model::GameStatus::NORMAL == status; ++step) {
+                status = model.update(pilot.decide(model.getDirection()));
+                pilot.apply(model.getDelta());
+                begin = Clock::now();
+                recorder.record(model, status);
+                recordSeconds += elapsed(begin);
+                if (0 == step % checkpointInterval) {
+                    checkpoints.emplace_back(step, Util::Snapshot());
+                    model.snapshot(checkpoints.back().second);
+                }
+            }
+            recorded += recorder.getSteps();
+            Util::Snapshot last;
+            model.snapshot(last);
+            recorder.write(file);
+            bytes += file.size();
+
+            Snake::ReplayView view(file.data(), file.size());
+            Snake::ReplayPlayer player(view);
+            for (std::size_t i = checkpoints.size(); i > 1; --i) {
+                std::swap(checkpoints[i - 1], checkpoints[generator() % i]);
+            }
+            for (const auto &checkpoint : checkpoints) {
+                begin = Clock::now();
+                player.seek(checkpoint.first);
+                seekSeconds += elapsed(begin);
+                ++seeks;
+                player.getModel().snapshot(snapshot);
+                mismatches += snapshot == checkpoint.second ? 0 : 1;
+            }
+            player.seek(0);
+            begin = Clock::now();
+            Snake::Model::GameStatus replayed = player.playToEnd();
+            playSeconds += elapsed(begin);
+            played += view.getSteps();
+            player.getModel().snapshot(snapshot);
+            mismatches += snapshot == last && replayed == status && view.getStatus() == status ? 0 : 1;
+        }
+        results.push_back({ "replay", "ReplayRecorder", width, height, "max steps",
+                            static_cast<double>(maxSteps), "step", recorded, recordSeconds });
+        results.push_back({ "replay", "ReplayRecorder", width, height, "max steps",
+                            static_cast<double>(maxSteps), "byte", bytes, recordSeconds });
+        results.push_back({ "replay", "ReplayPlayer", width, height, "max steps",
+                            static_cast<double>(maxSteps), "seek", seeks, seekSeconds });
+        results.push_back({ "replay", "ReplayPlayer", width, height, "max steps",
+                            static_cast<double>(maxSteps), "step", played, playSeconds });
+        results.push_back({ "replay", "ReplayPlayer", width, height, "max steps",
+                            static_cast<double>(maxSteps), "mismatch", mismatches, seekSeconds + playSeconds });
+    }
+
+    void runReplaySuite(Results &results, const Options &options) {
+        runReplayGames(results, options, 16, 16);
+        runReplayGames(results, options, 48, 32);
+    }
+
+    /* The step of one game (the CyclePilot, so the snake gets long) read
+     * by fn(model) after every update, games start over as they end.
+     * Only fn is timed */
+    template <typename F>
+    double timeObservations(const Options &options, std::size_t width, std::size_t height,
+                            std::uint64_t &steps, F fn) {
+        double seconds = 0;
+        steps = 0;
+        for (std::uint64_t game = 0; seconds < options.minSeconds; ++game) {
+            Snake::GridModel model(width, height, game);
+            Snake::CyclePilot pilot(width, height);
+            pilot.apply(model.getDelta());
+            Clock::time_point begin = Clock::now();
+            fn(model, true);
+            seconds += elapsed(begin);
+            Snake::GridModel::GameStatus status = Snake::GridModel::GameStatus::NORMAL;
+            while (Snake::GridModel::GameStatus::NORMAL == status && seconds < options.minSeconds) {
+                status = model.update(pilot.decide(model.getDirection()));
+                pilot.apply(model.getDelta());
+                begin = Clock::now();
+                fn(model, false);
+                seconds += elapsed(begin);
+                ++steps;
+            }
+        }
+        return seconds;
+    }
+
+    template <typename T>
+    void runObservations(Results &results, const Options &options, std::size_t width, std::size_t height,
+                         const Snake::ObservationEncoder::View &view, const std::string &name, bool changes) {
+        Snake::ObservationEncoder encoder(width, height, view);
+        std::vector<T> buffer(encoder.getSize());
+        std::uint64_t steps = 0;
+        double seconds = timeObservations(options, width, height, steps,
+                                          [&](const Snake::GridModel &model, bool start) {
+            if (start) {
+                encoder.reset();
+            }
+            encoder.apply(model.getDelta());
+            if (changes) {
+                encoder.writeChanges(buffer.data());
+            } else {
+                encoder.write(buffer.data());
+            }
+        });
+        results.push_back({ "observation", "ObservationEncoder", width, height, name,
+                            static_cast<double>(encoder.getViewWidth()), "step", steps, seconds });
+    }
+
+    /* Observations from a few layouts, the whole board redrawn from the
+     * body of the model every step as the baseline */
+    void runObservationSuite(Results &results, const Options &options) {
+        using View = Snake::ObservationEncoder::View;
+        using Frame = Snake::ObservationEncoder::Frame;
+        const Board boards[] = { { 16, 16 }, { 48, 32 } };
+        for (const Board &board : boards) {
+            const std::size_t width = board.width;
+            const std::size_t height = board.height;
+            const std::size_t planeSize = width * height;
+            std::vector<float> planes(Snake::ObservationEncoder::PLANES * planeSize);
+            std::uint64_t steps = 0;
+            double seconds = timeObservations(options, width, height, steps,
+                                              [&](const Snake::GridModel &model, bool) {
+                std::fill(planes.begin(), planes.end(), 0.0f);
+                std::size_t length = model.getLength();
+                for (std::size_t i = 0; i < length; ++i) {
+                    planes[Snake::ObservationEncoder::BODY * planeSize + model.getBodyCell(i)] = float(i + 1) / length;
+                }
+                planes[Snake::ObservationEncoder::HEAD * planeSize + model.getHeadCell()] = 1.0f;
+                if (length < planeSize) {
+                    planes[Snake::ObservationEncoder::FOOD * planeSize + model.getFoodCell()] = 1.0f;
+                }
+            });
+            results.push_back({ "observation", "GridModel", width, height, "redraw float",
+                                static_cast<double>(width), "step", steps, seconds });
+
+            runObservations<std::uint8_t>(results, options, width, height, View(), "board uint8", false);
+            runObservations<std::uint8_t>(results, options, width, height, View(), "board uint8 changes", true);
+            runObservations<float>(results, options, width, height, View(), "board float", false);
+            runObservations<float>(results, options, width, height, View(), "board float changes", true);
+            runObservations<float>(results, options, width, height, View(Frame::BOARD, 0, 0, false),
+                                   "occupancy float changes", true);
+            runObservations<float>(results, options, width, height, View(Frame::EGOCENTRIC, 11, 11),
+                                   "egocentric float", false);
+        }
+    }
+
+    /************************ Output *********************/
+
+    void writeCsv(std::ostream &out, const Results &results) {
+        out << "suite,model,width,height,parameter,argument,unit,count,seconds,ns_per_op,ops_per_second\n";
+        for (const Result &result : results) {
+            out << result.suite << ',' << result.model << ',' << result.width << ',' << result.height << ','
+                << result.parameter << ',' << result.argument << ',' << result.unit << ','
+                << result.count << ',' << result.seconds << ','
+                << result.nanosecondsPerOperation() << ',' << result.operationsPerSecond() << '\n';
+        }
+    }
+
+    void writeJson(std::ostream &out, const Results &results) {
+        out << "{\n  \"benchmark\": \"snake_model\",\n  \"results\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result &result = results[i];
+            out << (0 == i ? "\n" : ",\n")
+                << "    {\"suite\": \"" << result.suite << "\", \"model\": \"" << result.model
+                << "\", \"width\": " << result.width << ", \"height\": " << result.height
+                << ", \"parameter\": \"" << result.parameter << "\", \"argument\": " << result.argument
+                << ", \"unit\": \"" << result.unit << "\", \"count\": " << result.count
+                << ", \"seconds\": " << result.seconds
+                << ", \"ns_per_op\": " << result.nanosecondsPerOperation()
+                << ", \"ops_per_second\": " << result.operationsPerSecond() << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if ("--format" == argument && i + 1 < argc) {
+                std::string format = argv[++i];
+                if ("csv" != format && "json" != format) {
+                    return false;
+                }
+                options.csv = "csv" == format;
+            } else if ("--quick" == argument) {
+                options.quick = true;
+                options.minSeconds = 0.02;
+            } else if ("--min-time" == argument && i + 1 < argc) {
+                options.minSeconds = std::atof(argv[++i]);
+            } else if ("--suite" == argument && i + 1 < argc) {
+                options.suite = argv[++i];
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--format json|csv] [--quick] [--min-time seconds]"
+                     " [--suite latency|food|throughput|scaling|autopilot|arena|server|observation|replay]" << std::endl;
+        return 1;
+    }
+
+    Results results;
+    if (options.suite.empty() || "latency" == options.suite) {
+        runLatencySuite(results, options);
+    }
+    if (options.suite.empty() || "food" == options.suite) {
+        runFoodSuite(results, options);
+    }
+    if (options.suite.empty() || "throughput" == options.suite) {
+        runThroughputSuite(results, options);
+    }
+    if (options.suite.empty() || "scaling" == options.suite) {
+        runScalingSuite(results, options);
+    }
+    if (options.suite.empty() || "autopilot" == options.suite) {
+        runAutopilotSuite(results, options);
+    }
+    if (options.suite.empty() || "arena" == options.suite) {
+        runArenaSuite(results, options);
+    }
+    if (options.suite.empty() || "server" == options.suite) {
+        runServerSuite(results, options);
+    }
+    if (options.suite.empty() || "observation" == options.suite) {
+        runObservationSuite(results, options);
+    }
+    if (options.suite.empty() || "replay" == options.suite) {
+        runReplaySuite(results, options);
+    }
+
+    if (options.csv) {
+        writeCsv(std::cout, results);
+    } else {
+        writeJson(std::cout, results);
+    }
+    return 0;
+}
@@ -0,0 +1,298 @@
+/******************************************************************************
+ * Headless authoritative game server, GameServer over WebSocket              *
+ *                                                                            *
+ * Usage: snake_server [--port n] [--rooms n] [--size width height]           *
+ *                     [--tick-rate hz] [--keyframe-interval ticks]           *
+ *                     [--threads n]                                          *
+ *                                                                            *
+ * Serves the frames of TickCodec.h as binary messages under the subprotocol *
+ * MESSAGE_PROTOCOL, with the libwebsockets bundled in cocos2d/external.      *
+ * A client joins the room numbered by the end of the URL path, modulo the    *
+ * room count: ws://host:9000/3 is room 3, ws://host:9000/ room 0. The first  *
+ * client of a room plays, the others watch, see GameServer.h. The game side  *
+ * is NetworkClient.h. On SIGINT / SIGTERM the statistics of each room go to  *
+ * stdout as CSV.                                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "libwebsockets.h"
+#include "../Classes/GameServer.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+    using ClientId = Snake::GameServer::ClientId;
+    using RoomId = Snake::GameServer::RoomId;
+
+    struct Options {
+        int port = 9000;
+        std::size_t rooms = 16;
+        std::size_t width = 48;
+        std::size_t height = 32;
+        double tickRate = 10;
+        std::size_t keyframeInterval = 64;
+        std::size_t threads = 0;
+    };
+
+    // frames queued for one client before they are dropped as stale,
+    // it is sent a keyframe instead, as if it asked for a RESYNC
+    constexpr std::size_t MAX_QUEUED_FRAMES = 256;
+    // biggest message of a client, an INPUT is a few bytes
+    constexpr std::size_t MAX_CLIENT_MESSAGE = 64;
+
+    volatile std::sig_atomic_t running = 1;
+
+    void stop(int) {
+        running = 0;
+    }
+
+    // per connection data of libwebsockets, allocated and zeroed by it
+    struct Session {
+        ClientId client;
+        RoomId room;
+    };
+
+    class Server {
+    public:
+        explicit Server(const Options &options)
+        : server(options.width, options.height, options.keyframeInterval, options.threads),
+          rooms(options.rooms), nextClient(1) {
+            server.setRestart(true);
+            server.setSend([this](ClientId client, const std::uint8_t *data, std::size_t size) {
+                queue(client, data, size);
+            });
+            for (std::size_t i = 0; i < rooms; ++i) {
+                server.createRoom(i + 1);
+            }
+        }
+
+        inline void tick() { server.tick(); }
+
+        // room numbered by the end of path
+        RoomId roomOf(const char *path) const {
+            const char *digits = path + std::strlen(path);
+            while (digits > path && '0' <= digits[-1] && '9' >= digits[-1]) {
+                --digits;
+            }
+            return static_cast<RoomId>(std::strtoull(digits, nullptr, 10) % rooms);
+        }
+
+        void open(Session &session, libwebsocket *socket) {
+            session.client = nextClient++;
+            connections[session.client].socket = socket;
+            server.join(session.client, session.room);
+        }
+
+        void close(const Session &session) {
+            server.leave(session.client);
+            connections.erase(session.client);
+        }
+
+        inline void receive(const Session &session, const void *data, std::size_t size) {
+            server.receive(session.client, static_cast<const std::uint8_t*>(data), size);
+        }
+
+        // write the next frame queued, one per writeable callback,
+        // return false to close the connection
+        bool write(const Session &session) {
+            auto found = connections.find(session.client);
+            if (connections.end() == found) {
+                return true;
+            }
+            Connection &connection = found->second;
+            if (connection.frames.empty()) {
+                return true;
+            }
+            Snake::Message &frame = connection.frames.front();
+            std::size_t size = frame.size() - LWS_SEND_BUFFER_PRE_PADDING - LWS_SEND_BUFFER_POST_PADDING;
+            if (libwebsocket_write(connection.socket, frame.data() + LWS_SEND_BUFFER_PRE_PADDING,
+                                   size, LWS_WRITE_BINARY) < 0) {
+                return false;
+            }
+            connection.frames.pop_front();
+            if (!connection.frames.empty()) {
+                libwebsocket_callback_on_writable(context, connection.socket);
+            }
+            return true;
+        }
+
+        void report(std::ostream &out) const {
+            out << "room,ticks,games,frames,keyframes,bytes,bytes_per_tick,us_per_tick\n";
+            for (RoomId room = 0; room < rooms; ++room) {
+                const Snake::GameServer::RoomStatistics &statistics = server.getStatistics(room);
+                double ticks = statistics.ticks > 0 ? static_cast<double>(statistics.ticks) : 1;
+                out << room << "," << statistics.ticks << "," << statistics.games
+                    << "," << statistics.frames << "," << statistics.keyframes << "," << statistics.bytes
+                    << "," << statistics.bytes / ticks << "," << 1e6 * statistics.seconds / ticks << "\n";
+            }
+            out << "rejected messages," << server.getRejected() << "\n";
+        }
+
+        libwebsocket_context *context = nullptr;
+
+        // disable
+        Server(const Server&) = delete;
+        Server operator=(const Server&) = delete;
+    private:
+        // one WebSocket connection, its frames wait there until it is writeable,
+        // each with the padding libwebsocket_write() needs around it
+        struct Connection {
+            libwebsocket *socket = nullptr;
+            std::deque<Snake::Message> frames;
+        };
+
+        Snake::GameServer server;
+        std::size_t rooms;
+        ClientId nextClient;
+        std::unordered_map<ClientId, Connection> connections;
+
+        void queue(ClientId client, const std::uint8_t *data, std::size_t size) {
+            auto found = connections.find(client);
+            if (connections.end() == found) {
+                return;
+            }
+            Connection &connection = found->second;
+            if (connection.frames.size() >= MAX_QUEUED_FRAMES) {
+                connection.frames.clear();
+                Snake::Message resync;
+                Snake::encodeResync(resync);
+                server.receive(client, resync.data(), resync.size());
+                return;
+            }
+            connection.frames.emplace_back(LWS_SEND_BUFFER_PRE_PADDING + size + LWS_SEND_BUFFER_POST_PADDING);
+            std::memcpy(connection.frames.back().data() + LWS_SEND_BUFFER_PRE_PADDING, data, size);
+            libwebsocket_callback_on_writable(context, connection.socket);
+        }
+    };
+
+    int serveSnake(libwebsocket_context *context, libwebsocket *wsi, libwebsocket_callback_reasons reason,
+                 void *user, void *in, std::size_t len) {
+        Server &server = *static_cast<Server*>(libwebsocket_context_user(context));
+        Session *session = static_cast<Session*>(user);
+        switch (reason) {
+            case LWS_CALLBACK_FILTER_PROTOCOL_CONNECTION:
+                // the headers are only there until the handshake is over
+                if (nullptr != session) {
+                    char path[256] = "";
+                    lws_hdr_copy(wsi, path, sizeof(path), WSI_TOKEN_GET_URI);
+                    session->room = server.roomOf(path);
+                }
+                break;
+            case LWS_CALLBACK_ESTABLISHED:
+                server.open(*session, wsi);
+                break;
+            case LWS_CALLBACK_RECEIVE:
+                server.receive(*session, in, len);
+                break;
+            case LWS_CALLBACK_SERVER_WRITEABLE:
+                if (!server.write(*session)) {
+                    return -1;
+                }
+                break;
+            case LWS_CALLBACK_CLOSED:
+                server.close(*session);
+                break;
+            default:
+                break;
+        }
+        return 0;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if ("--port" == argument && i + 1 < argc) {
+                options.port = std::atoi(argv[++i]);
+            } else if ("--rooms" == argument && i + 1 < argc) {
+                options.rooms = std::strtoul(argv[++i], nullptr, 10);
+            } else if ("--size" == argument && i + 2 < argc) {
+                options.width = std::strtoul(argv[++i], nullptr, 10);
+                options.height = std::strtoul(argv[++i], nullptr, 10);
+            } else if ("--tick-rate" == argument && i + 1 < argc) {
+                options.tickRate = std::atof(argv[++i]);
+            } else if ("--keyframe-interval" == argument && i + 1 < argc) {
+                options.keyframeInterval = std::strtoul(argv[++i], nullptr, 10);
+            } else if ("--threads" == argument && i + 1 < argc) {
+                options.threads = std::strtoul(argv[++i], nullptr, 10);
+            } else {
+                return false;
+            }
+        }
+        return options.port > 0 && options.rooms > 0 && options.tickRate > 0;
+    }
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--port n] [--rooms n] [--size width height] [--tick-rate hz]"
+                     " [--keyframe-interval ticks] [--threads n]" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Server> server;
+    try {
+        server.reset(new Server(options));
+    } catch (const Util::Exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    libwebsocket_protocols protocols[2];
+    std::memset(protocols, 0, sizeof(protocols));
+    protocols[0].name = Snake::MESSAGE_PROTOCOL;
+    protocols[0].callback = serveSnake;
+    protocols[0].per_session_data_size = sizeof(Session);
+    protocols[0].rx_buffer_size = MAX_CLIENT_MESSAGE;
+
+    lws_context_creation_info info;
+    std::memset(&info, 0, sizeof(info));
+    info.port = options.port;
+    info.protocols = protocols;
+    info.gid = -1;
+    info.uid = -1;
+    info.user = server.get();
+    lws_set_log_level(LLL_ERR | LLL_WARN, nullptr);
+    server->context = libwebsocket_create_context(&info);
+    if (nullptr == server->context) {
+        std::cerr << "Cannot listen on port " << options.port << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::cerr << "Serving " << options.rooms << " rooms of " << options.width << "x" << options.height
+              << " on port " << options.port << ", " << options.tickRate << " ticks per second" << std::endl;
+
+    // ticks on a fixed schedule, the sockets are served in between
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / options.tickRate));
+    Clock::time_point nextTick = Clock::now() + period;
+    while (running) {
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextTick - Clock::now()).count();
+        if (libwebsocket_service(server->context, static_cast<int>(std::max<long long>(wait, 0))) < 0) {
+            break;
+        }
+        if (Clock::now() >= nextTick) {
+            server->tick();
+            nextTick += period;
+        }
+    }
+
+    libwebsocket_context_destroy(server->context);
+    server->report(std::cout);
+    return 0;
+}
@@ -7,7 +7,10 @@
 //
 
 #include "GameScene.h"
+#include <sstream>
+#include "GridRenderer.h"
 #include "Model.h"
+#include "SimulationThread.h"
 #include "Util.h"
 #include "HelloWorldScene.h"
 
@@ -15,21 +18,15 @@ USING_NS_CC;
 
 namespace {
     constexpr int SPRITE_LAYER = 0;
-    // get texture file name based on the node type
-    std::string getTextureName(const Util::Node &node);
-    
-    // based on the position, calculate the hash value
-    // 1000 * x + y, assumption, y < 1000
-    inline std::size_t calcHash(int x, int y);
 }
 
-Scene* GameScene::createScene()
+Scene* GameScene::createScene(bool threadedSimulation)
 {
     // 'scene' is an autorelease object
     auto scene = Scene::create();
     
     // 'layer' is an autorelease object
-    auto layer = GameScene::create();
+    auto layer = threadedSimulation ? GameScene::createWithSimulationThread() : GameScene::create();
     
     // add layer as a child to scene
     scene->addChild(layer);
@@ -38,6 +35,31 @@ Scene* GameScene::createScene()
     return scene;
 }
 
+GameScene* GameScene::createWithSimulationThread()
+{
+    GameScene *layer = new (std::nothrow) GameScene();
+    if (layer) {
+        layer->threadedSimulation = true;
+    }
+    if (layer && layer->init()) {
+        layer->autorelease();
+        return layer;
+    }
+    CC_SAFE_DELETE(layer);
+    return nullptr;
+}
+
+GameScene::GameScene()
+{
+}
+
+GameScene::~GameScene()
+{
+    if (afterDrawListener) {
+        Director::getInstance()->getEventDispatcher()->removeEventListener(afterDrawListener);
+    }
+}
+
 // on "init" you need to initialize your instance
 bool GameScene::init()
 {
@@ -51,66 +73,111 @@ bool GameScene::init()
     Size visibleSize = Director::getInstance()->getVisibleSize();
     height = visibleSize.height / RATIO;
     width = visibleSize.width / RATIO;
-    modelPtr = new Snake::Model(width, height);
-    //std::move(new Snake::Model(width, height)));
     Vec2 origin = Director::getInstance()->getVisibleOrigin();
-    Snake::Model::NodesVector nodesToAdd = modelPtr->getNodesAdded();
-    
-    for (auto node : nodesToAdd) {
-        createAndPutSprite(node);
+    board = GridRenderer::create(width, height, RATIO);
+    if (!board) {
+        return false;
     }
+    this->addChild(board, SPRITE_LAYER);
     
     speed = 120;
-    schedule(schedule_selector(GameScene::update), 60/speed);
+    if (threadedSimulation) {
+        modelPtr.reset();
+        simulation.reset(new Snake::SimulationThread(width, height, speed / 60));
+        drawnCells.assign(width * height, Util::NodeType::UNINIT);
+        headSprite = Sprite::create("SnakeHead.png");
+        headSprite->setAnchorPoint(Vec2(0, 0));
+        this->addChild(headSprite, SPRITE_LAYER + 1);
+        // every frame, the simulation keeps its own clock
+        schedule(schedule_selector(GameScene::updateFromSimulation));
+        simulation->start();
+    } else {
+        modelPtr.reset(new Snake::Model(width, height));
+        //std::move(new Snake::Model(width, height)));
+        applyDelta(modelPtr->getDelta());
+        schedule(schedule_selector(GameScene::update), 60/speed);
+    }
     
     createKeyboardListener();
     createTouchListener();
+    afterDrawListener = _eventDispatcher->addCustomEventListener(Director::EVENT_AFTER_DRAW,
+                                                                 [this](EventCustom*) { onAfterDraw(); });
     
     return true;
 }
 
 void GameScene::update(float dt){
-    Snake::Model::GameStatus ret = modelPtr->update(userCommand);
+    Snake::InputCommand command;
+    if (inputQueue.tryPop(command)) {
+        inputLatency.record(std::chrono::steady_clock::now() - command.time);
+    }
+    Snake::Model::GameStatus ret = modelPtr->update(command.direction);
+    stepPending = true;
+    stepTime = std::chrono::steady_clock::now();
     if (Snake::Model::GameStatus::NORMAL != ret) {
         gameOver();
     }
-    Snake::Model::NodesVector nodesToRemove = modelPtr->getNodesRemoved();
-    for (auto& node : nodesToRemove) {
-        removeSprite(node);
-    }
-    Snake::Model::NodesVector nodesToChange = modelPtr->getNodesChanged();
-    for (auto& node : nodesToChange) {
-        updateSprite(node);
-    }
-    Snake::Model::NodesVector nodesToAdd = modelPtr->getNodesAdded();
-    for (auto& node : nodesToAdd) {
-        createAndPutSprite(node);
-    }
+    applyDelta(modelPtr->getDelta());
 }
 
+void GameScene::updateFromSimulation(float dt) {
+    if (simulation->poll()) {
+        // diff against the board drawn, steps skipped in between are covered
+        const Snake::SimulationFrame& frame = simulation->getFrame();
+        stepPending = true;
+        stepTime = frame.time;
+        frameChanges.clear();
+        for (std::uint32_t cell = 0; cell < drawnCells.size(); ++cell) {
+            Util::NodeType type = frame.cells[cell];
+            if (Util::NodeType::HEAD == type) {
+                type = Util::NodeType::BODY;
+            }
+            if (type != drawnCells[cell]) {
+                frameChanges.push_back({ cell, drawnCells[cell], type });
+                drawnCells[cell] = type;
+            }
+        }
+        applyDelta(Util::DeltaView(frameChanges));
+        if (Snake::Model::GameStatus::NORMAL != frame.status) {
+            gameOver();
+        }
+    }
+    
+    const Snake::SimulationFrame& frame = simulation->getFrame();
+    float progress = simulation->getProgress(std::chrono::steady_clock::now());
+    Vec2 from(frame.previousHead % width, frame.previousHead / width);
+    Vec2 to(frame.head % width, frame.head / width);
+    headSprite->setPosition((from + (to - from) * progress) * RATIO);
+}
 
-int GameScene::createAndPutSprite(const Util::Node& node) {
-    auto sprite = Sprite::create(getTextureName(node));
-    sprite->setPosition(Vec2(node.x * RATIO, node.y * RATIO));
-    sprite->setAnchorPoint(Vec2(0, 0));
-    this->addChild(sprite, SPRITE_LAYER, static_cast<int>(calcHash(node.x, node.y)));
-    return 0;
+void GameScene::applyDelta(Util::DeltaView delta) {
+    board->applyDelta(delta);
 }
 
-int GameScene::updateSprite(const Util::Node& node) {
-    auto child = this->getChildByTag(static_cast<int>(calcHash(node.x, node.y)));
-    auto sprite = static_cast<Sprite*>(child);
-    sprite->setTexture(getTextureName(node));
-    return 0;
+void GameScene::onAfterDraw() {
+    // the frame is handed to the display right after this event
+    if (stepPending) {
+        presentLatency.record(std::chrono::steady_clock::now() - stepTime);
+        stepPending = false;
+    }
 }
 
-int GameScene::removeSprite(const Util::Node& node) {
-    this->removeChildByTag(static_cast<int>(calcHash(node.x, node.y)));
-    return 0;
+void GameScene::reportLatency() {
+    std::ostringstream report;
+    report << "input to step: ";
+    (simulation ? simulation->getInputLatency() : inputLatency).report(report);
+    report << "\nstep to present: ";
+    presentLatency.report(report);
+    CCLOG("%s", report.str().c_str());
 }
 
 void GameScene::gameOver() {
+    reportLatency();
     unschedule(schedule_selector(GameScene::update));
+    if (simulation) {
+        unschedule(schedule_selector(GameScene::updateFromSimulation));
+        simulation->stop();
+    }
     
     _eventDispatcher->removeEventListenersForType(EventListener::Type::TOUCH_ONE_BY_ONE);
     _eventDispatcher->removeEventListenersForType(EventListener::Type::KEYBOARD);
@@ -127,23 +194,15 @@ void GameScene::gameOver() {
     
 }
 
-namespace {
-    std::string getTextureName(const Util::Node &node) {
-        switch (node.type) {
-            case Util::NodeType::FOOD:
-                return std::string("Food.png");
-            case Util::NodeType::BODY:
-                return std::string("Snake.png");
-            case Util::NodeType::HEAD:
-                return std::string("SnakeHead.png");
-            default:
-                // should never go here
-                break;
-        }
-        return std::string("Error.png");
-    }
-    std::size_t calcHash(int x, int y) {
-        return 1000 * x + y;
+void GameScene::pushCommand(Util::Direction direction) {
+    // a full queue drops the command, the user is far ahead of the game anyway
+    if (simulation) {
+        simulation->pushCommand(direction);
+    } else {
+        Snake::InputCommand command;
+        command.direction = direction;
+        command.time = std::chrono::steady_clock::now();
+        inputQueue.tryPush(command);
     }
 }
 
@@ -160,16 +219,16 @@ void GameScene::onKeyPressed(EventKeyboard::KeyCode keyCode, Event* event)
 {
     switch (keyCode) {
         case EventKeyboard::KeyCode::KEY_LEFT_ARROW:
-            userCommand = Util::Direction::LEFT;
+            pushCommand(Util::Direction::LEFT);
             break;
         case EventKeyboard::KeyCode::KEY_RIGHT_ARROW:
-            userCommand = Util::Direction::RIGHT;
+            pushCommand(Util::Direction::RIGHT);
             break;
         case EventKeyboard::KeyCode::KEY_UP_ARROW:
-            userCommand = Util::Direction::UP;
+            pushCommand(Util::Direction::UP);
             break;
         case EventKeyboard::KeyCode::KEY_DOWN_ARROW:
-            userCommand = Util::Direction::DOWN;
+            pushCommand(Util::Direction::DOWN);
             break;
         default:
             break;
@@ -202,8 +261,8 @@ void GameScene::parseTouchCommand() {
     auto endY   = static_cast<int>(touchEndPoint.y);
     
     if (abs(endY - startY) > abs(endX - startX)) {
-        userCommand = endY > startY ? Util::Direction::UP : Util::Direction::DOWN;
+        pushCommand(endY > startY ? Util::Direction::UP : Util::Direction::DOWN);
     } else {
-        userCommand = endX > startX ? Util::Direction::RIGHT : Util::Direction::LEFT;
+        pushCommand(endX > startX ? Util::Direction::RIGHT : Util::Direction::LEFT);
     }
 }